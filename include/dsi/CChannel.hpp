@@ -20,11 +20,65 @@ namespace DSI
 {
    // forward decl
    class CClientConnectSM;
+   class CCorkScope;
 
    
    /// @internal helper typedef
    typedef struct iovec iov_t;
 
+
+   /**
+    * Configuration of the outbound send queue of a channel. Data which cannot be written
+    * to the peer immediately is queued and sent once the peer is able to receive again.
+    * If the queue grows beyond the high watermark the peer is considered as a slow consumer
+    * and the policy is applied until the queue has been drained below the low watermark.
+    */
+   struct SendQueueConfig
+   {
+      /// What to do with a slow consumer.
+      enum Policy
+      {
+         Drop = 0,      ///< drop all further messages until the low watermark is reached
+         Disconnect,    ///< shut down the connection to the peer
+         Block          ///< wait for the peer to drain the queue before the next message
+      };
+
+      size_t highWatermark;   ///< queue size in bytes which marks a slow consumer
+      size_t lowWatermark;    ///< queue size in bytes below which the consumer has recovered
+      Policy policy;          ///< slow consumer policy
+   };
+
+
+   /**
+    * Counters of the outbound send queue of one (or the sum of multiple) channel(s).
+    */
+   struct SendQueueStatistics
+   {
+      size_t queuedBytes;         ///< bytes currently waiting to be sent
+      size_t peakQueuedBytes;     ///< maximum number of bytes ever queued
+      uint32_t deferredMessages;  ///< messages which could not be sent without blocking
+      uint32_t droppedMessages;   ///< messages dropped due to the Drop policy
+      uint32_t disconnects;       ///< connections shut down due to the Disconnect policy
+   };
+
+
+   /**
+    * Transport counters of one (or the sum of multiple) channel(s). Bytes include the message headers
+    * and the payloads passed through shared memory.
+    */
+   struct TransportStatistics
+   {
+      uint64_t bytesSent;              ///< bytes written to the peer
+      uint64_t bytesReceived;          ///< bytes read from the peer
+      uint32_t messagesSent;           ///< requests and responses, independent of their fragmentation
+      uint32_t messagesReceived;       ///< requests and responses, independent of their fragmentation
+      uint32_t fragmentsSent;          ///< additional frames of messages exceeding the frame size
+      uint32_t fragmentsReassembled;   ///< additional frames received and appended to their message
+      uint32_t writeCalls;             ///< write syscalls
+      uint32_t readCalls;              ///< read syscalls, at least one per message header
+      uint32_t partialReads;           ///< reads which returned less data than requested
+   };
+
    
    /**
     * @class CChannel "CChannel.hpp" "dsi/CChannel.hpp"
@@ -36,6 +90,10 @@ namespace DSI
     */
    class CChannel : public Private::CNonCopyable
    {
+      friend class CCorkScope;
+      friend class CRequestReader;
+      friend class CRequestWriter;
+
    public:
 
       /**
@@ -65,12 +123,14 @@ namespace DSI
       virtual bool isOpen() const = 0;
 
       /**
-       * Blocking send all data given by @c data of length @c len.
+       * Send all data given by @c data of length @c len. Data which cannot be written without
+       * blocking is queued in the channel's send queue.
        */
       virtual bool sendAll(const void* data, size_t len) = 0;
 
       /**
-       * Blocking send all data given by @c iov of length @c len.
+       * Send all data given by @c iov of length @c len. Data which cannot be written without
+       * blocking is queued in the channel's send queue.
        */
       virtual bool sendAll(const iov_t* iov, size_t iov_len) = 0;
       
@@ -78,11 +138,83 @@ namespace DSI
        * Blocking receive all data of length @c len and store it in @c buf.
        */      
       virtual bool recvAll(void* buf, size_t len) = 0;      
+
+      /**
+       * Receive the payload of a packet transferred out of band (@c len bytes at the given
+       * ring @c position). The default implementation fails.
+       */
+      virtual bool recvShared(void* buf, size_t len, uint32_t position);
+      
+      /**
+       * Change the send queue configuration. The default implementation is a NOOP.
+       */
+      virtual void setSendQueueConfig(const SendQueueConfig& config);
+
+      /**
+       * @return the send queue counters. The default implementation returns all zeros.
+       */
+      virtual SendQueueStatistics getSendQueueStatistics() const;
+
+      /**
+       * @return the transport counters of this channel, only valid within the thread using the channel.
+       */
+      inline
+      const TransportStatistics& getTransportStatistics() const
+      {
+         return mTransportStats;
+      }
+
+      /**
+       * Hold back the data of all following @c sendAll calls until the matching @c uncork, so
+       * multiple messages are written with one syscall. Calls may be nested. The default
+       * implementation is a NOOP.
+       */
+      virtual void cork();
+
+      /**
+       * Write all data held back since the outermost @c cork. The data is subject to the send
+       * queue just like the one of @c sendAll.
+       *
+       * @return false if the data could not be written or queued, just like @c sendAll. The
+       * default implementation is a NOOP returning true.
+       */
+      virtual bool uncork();
+
+      /**
+       * Set the maximum size of one message frame (including the message header) the peer accepts.
+       * Only called after the frame size was negotiated during connection setup.
+       */
+      inline
+      void setMaxFrameSize(uint32_t size)
+      {
+         mMaxFrameSize = size;
+      }
+
+      /**
+       * @return the maximum frame size of this channel. Defaults to DSI_PACKET_SIZE.
+       */
+      inline
+      uint32_t getMaxFrameSize() const
+      {
+         return mMaxFrameSize;
+      }
       
       /**
        * Internal asynchronous read operation.
        */
       virtual void asyncRead(CClientConnectSM* sm) = 0;
+
+   protected:
+
+      /// updated by the channel implementations and the message readers and writers
+      TransportStatistics mTransportStats;
+
+   private:
+
+      uint32_t mMaxFrameSize;
+
+      /// the scope which corked the channel, if any
+      CCorkScope* mCorkScope;
    };
    
 }   //namespace DSI
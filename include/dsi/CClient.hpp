@@ -8,6 +8,8 @@
 #ifndef DSI_CCLIENT_HPP
 #define DSI_CCLIENT_HPP
 
+#include <vector>
+
 #include "dsi/CBase.hpp"
 #include "dsi/CChannel.hpp"
 
@@ -82,6 +84,17 @@ namespace DSI
        */
       void clearNotification( notificationid_t id );
 
+      /**
+       * Sets the notifications on all given attributes, responses or informations with one request.
+       * Servers of an older protocol version get one request per id.
+       */
+      void setNotifications( const std::vector<notificationid_t>& ids );
+
+      /**
+       * Clears the notifications with the given update ids with one request.
+       */
+      void clearNotifications( const std::vector<notificationid_t>& ids );
+
       /**
        * Callback that is called when the server connects. This
        * function will be implemented by the generated proxy base class.
@@ -25,6 +25,19 @@ namespace DSI
    class CClient;
    class CServer;
    class CIStream;
+   class CServicebrokerConnection;
+
+
+   /**
+    * Runtime counters of a communication engine, summed up over all its shards.
+    */
+   struct CommEngineStatistics
+   {
+      TransportStatistics transport;   ///< all channels, including the already closed ones
+      uint64_t loopIterations;         ///< rounds of the event loops
+      uint64_t loopBusyNs;             ///< time spent within the rounds, without waiting for events
+      uint64_t maxLoopBusyNs;          ///< longest single round of any shard
+   };
 
 
    /**
@@ -53,6 +66,19 @@ namespace DSI
     * engine entered it's event loop. And beware that it is not possible to add the same
     * client or server instance to multiple instances of the communcation engine.
     *
+    * By default, the engine runs all its clients and servers within the thread calling @c run(). An
+    * engine created with more than one shard runs one event loop per shard, the first one in the
+    * thread calling @c run() and each other one in its own thread. Each client and server is pinned to
+    * one shard when added and all its I/O, callbacks and channels are handled by that shard only.
+    * Clients and servers on different shards must therefore not share any unprotected state.
+    *
+    * @code
+    *   CCommEngine commEngine(4);      // four event loop threads
+    *   commEngine.add(stub);           // round-robin shard assignment
+    *   commEngine.add(proxy, 0);       // explicitly run the proxy in the thread calling run()
+    *   commEngine.run();
+    * @endcode
+    *
     * @note Due to the current implementation, it is not possible to run a client and server within 
     *       the same communication engine. Such an implementation would run into a blocking system 
     *       call during the synchronous implementation of ConnectAttach and wait forever. 
@@ -98,34 +124,65 @@ namespace DSI
          InvalidFileDescriptor,   ///< The internal multiplexer got an invalid file descriptor.
          GenericError             ///< any other error occurred.
       };
-            
+
+      enum
+      {
+         AnyShard = -1   ///< let the engine choose the shard of a client or server
+      };
+
       /**
        * Creates a new communication engine object for local transport initially. The communication 
        * engine automatically adds TCP/IP transport once a TCP/IP enabled server is added. It then
        * binds to an arbitrary TCP/IP port. If you want to choose a distinct port you may set the
        * @c DSI_COMMENGINE_PORT environment variable pointing to the port number the engine should
-       * use for installing the TCP/IP acceptor.
+       * use for installing the TCP/IP acceptor. The port is only used by the first shard, all other
+       * shards bind to arbitrary ports.
+       *
+       * @param shards The number of event loops (threads) of this engine, at least one.
        */
-      CCommEngine();
+      explicit
+      CCommEngine(unsigned int shards = 1);
 
       /**
        * Frees the communication engine object.
        */
       ~CCommEngine();
 
+      /**
+       * @return the number of shards (event loops) of this engine.
+       */
+      unsigned int getShardCount() const;
+
       /**
        * Starts the main event loop of a DSI application. This call will not return. Clients and server
        * may be added to the communication engine prior to calling @run() or afterwards within a callback.
+       * The event loops of all other shards are started in their own threads and are stopped and
+       * joined before this function returns.
        */
       int run();
 
       /**
        * Stops the main event loop, i.e. let @run() return. May be even called from another thread context.
+       * The event loop is woken up immediately in this case.
        *
        * @param exitcode The exitcode to be returned by @c run().
        */
       void stop(int exitcode = 0);
 
+      /**
+       * Runs the given function from within the event loop of the given shard, e.g. to hand over
+       * the result of a worker thread to a stub. May be called from any thread, the function is
+       * always called asynchronously, in the order of posting. Functions posted while the engine is
+       * not running are called later, at the latest once it runs again. Note that @c add(),
+       * @c remove() and @c stop() called from another thread while the shard does not run its
+       * event loop execute their work and with it all functions posted so far synchronously in the
+       * calling thread. Functions still pending when the engine is destroyed are dropped.
+       *
+       * @param task The function to be called.
+       * @param shard The shard to run the function, see @c add().
+       */
+      void post(const std::tr1::function<void()>& task, unsigned int shard = 0);
+
       /**
        * Adds a client (proxy) to the communication engine. Once the client is added 
        * it may be removed via @c remove(). It is only possible to add a client
@@ -133,9 +190,10 @@ namespace DSI
        * main event loop is started.
        *       
        * @param client the client
+       * @param shard The shard running the client, @c AnyShard for round-robin assignment.
        * @return true if the client has been add to the communication engine.
        */
-      bool add(CClient &client);
+      bool add(CClient &client, int shard = AnyShard);
 
       /**
        * Removes a client (proxy) from the communication engine.
@@ -152,9 +210,10 @@ namespace DSI
        * main event loop is started.
        *
        * @param server The server to add.
+       * @param shard The shard running the server, @c AnyShard for round-robin assignment.
        * @return true if the server has been add to the communication engine.
        */
-      bool add(CServer &server);
+      bool add(CServer &server, int shard = AnyShard);
 
       /**
        * Removes a server (stub) from the communication engine.
@@ -167,7 +226,7 @@ namespace DSI
       /**
        * Add a generic device that will be included into the main event loop for io-event
        * multiplexing (poll). Devices may be everything that is pollable, e.g. sockets,
-       * message queues, pipes, ...
+       * message queues, pipes, ... Generic devices are always handled by the first shard.
        *
        * @c HandlerT must be a functor taking exactly one argument of type @c IOResult returning
        * a boolean value. In case of the boolean value beeing true, the given fd will be rearmed for
@@ -187,6 +246,28 @@ namespace DSI
        */
       void removeGenericDevice(int fd);
 
+      /**
+       * Set the outbound send queue configuration of all current and future channels of 
+       * this communication engine. The initial configuration can be set via the environment
+       * variables @c DSI_SEND_QUEUE_HIGH_WATERMARK, @c DSI_SEND_QUEUE_LOW_WATERMARK and 
+       * @c DSI_SEND_QUEUE_POLICY.
+       */
+      void setSendQueueConfig(const SendQueueConfig& config);
+
+      /**
+       * @return the summed up send queue counters of all channels of this communication engine, 
+       * including the already closed ones. The peak value is the maximum of all channels.
+       */
+      SendQueueStatistics getSendQueueStatistics() const;
+
+      /**
+       * @return a snapshot of the transport and event loop counters of this communication engine.
+       * The counters are updated by the event loops without any locking, each shard copies its
+       * own ones from within its loop. Dividing e.g. the bytes by the messages or the busy time by
+       * the loop iterations gives the averages for sizing socket buffers and frame sizes.
+       */
+      CommEngineStatistics getStatistics() const;
+
    private:
 
       /**       
@@ -214,13 +295,22 @@ namespace DSI
       /// Attach to or craete a new tcp channel as described by @c host and @c port in host-byte-order.
       /// @param private_ Create a socket only known by the caller, no caching et al.
       std::tr1::shared_ptr<CChannel> attachTCP(uint32_t host, uint32_t port, bool private_ = false);
+
+      /// Keep the counters of a channel created by @c attachTCP(..., true) the caller is done with.
+      void releasePrivateChannel(const CChannel& chnl);
       
       CClient* findClient(int32_t id);
       CServer* findServer(int32_t id);
 
+      /// The non-blocking servicebroker connection of the calling thread's shard.
+      CServicebrokerConnection& getServicebroker();
+
       /// Private structure hiding implementation details, not important for the interface
       struct Private;
       Private* d;
+
+      /// @return the shard of the calling thread or the first shard if called from outside of this engine.
+      Private* current() const;
       
       /// internal forwarder function.
       static void pimplCCommEngineAddGenericDevice(void* d, int fd, DataFlowDirection dir,
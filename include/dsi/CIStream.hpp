@@ -22,6 +22,7 @@
 #include "dsi/TVariant.hpp"
 
 #include "dsi/private/CNonCopyable.hpp"
+#include "dsi/private/streamable.hpp"
 
 
 namespace DSI
@@ -62,6 +63,15 @@ namespace DSI
        * Read method for single-byte strings as-is, aka buffers without any character set conversion.
        */
       void read(std::string& buf);
+
+      /**
+       * Read an array of trivially streamable elements with a single copy.
+       *
+       * @return false if the current offset does not allow copying the memory layout, the
+       *         elements must be read one by one then.
+       */
+      template<typename T>
+      bool readBulk(T* data, size_t count);
      
       /**
        * Raw read function. 
@@ -155,6 +165,34 @@ namespace DSI
    }
 
 
+   template<typename T>
+   inline
+   bool CIStream::readBulk(T* data, size_t count)
+   {
+      // if an error occured we just do nothing
+      if (0 == mError)
+      {
+         // same padding the per element deserialization would skip before the first element
+         const size_t padding = (-mOffset) & (IsTriviallyStreamable<T>::leading - 1);
+
+         if (((mOffset + padding) & (IsTriviallyStreamable<T>::alignment - 1)) != 0)
+            return false;
+
+         if (padding <= (mSize - mOffset) && count <= (mSize - mOffset - padding) / sizeof(T))
+         {
+            memcpy(static_cast<void*>(data), mData + mOffset + padding, count * sizeof(T));
+            mOffset += padding + count * sizeof(T);
+         }
+         else
+         {
+            mError = ERANGE;
+         }
+      }
+
+      return true;
+   }
+
+
    inline
    void CIStream::read(void * buffer, size_t size)
    {
@@ -345,6 +383,9 @@ DSI::CIStream& operator>>(DSI::CIStream& is, std::vector<T>& v)
    int32_t newSize = 0;   
    is >> newSize;   
    v.resize(newSize);   
+
+   if (DSI::IsTriviallyStreamable<T>::value && !v.empty() && is.readBulk(&v[0], v.size()))
+      return is;
    
    for(typename std::vector<T>::iterator iter = v.begin(); iter != v.end(); ++iter)
    {   
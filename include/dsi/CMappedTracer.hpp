@@ -0,0 +1,66 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_CMAPPEDTRACER_HPP
+#define DSI_CMAPPEDTRACER_HPP
+
+
+#include "dsi/Trace.hpp"
+
+
+namespace DSI
+{
+
+namespace Trace
+{
+
+/**
+ * Tracing implementation writing fixed size binary records into a memory mapped ring buffer file.
+ * Recording a frame takes no lock and does no formatting, so it hardly changes the timing of the
+ * traced application. When the ring is full the oldest records are overwritten. The file can be
+ * decoded with the @c dsitrace tool, also while the application is still running or after it crashed.
+ */
+class CMappedTracer : public IChannel
+{
+public:
+
+   /**
+    * @param path The trace file, it is created or truncated.
+    * @param records Number of records in the ring.
+    * @param payloadSize Maximum number of payload bytes recorded per frame, 0 disables payload tracing.
+    */
+   explicit
+   CMappedTracer(const char* path, unsigned int records = 65536, unsigned int payloadSize = 0);
+
+   ~CMappedTracer();
+
+   /// @return -1 if the trace file could not be created or the interface table is full.
+   int open(const SFNDInterfaceDescription& iface, Direction dir, uint32_t updateId = DSI::INVALID_ID);
+   void close(int handle);
+
+   /// @return always true.
+   bool isActive(int handle);
+
+   /// @return true if a payload size was given.
+   bool isPayloadEnabled(int handle);
+
+   /// Appends one record to the ring, the payload is truncated to the configured size.
+   void write(int handle, const DSI::MessageHeader* hdr, const DSI::EventInfo* info, const void* payload, size_t len);
+
+private:
+
+   /// pimpl implementation detail
+   struct Private;
+   Private* d;
+};
+
+}   // namespace Trace
+
+}   // namespace DSI
+
+
+#endif   // DSI_CMAPPEDTRACER_HPP
@@ -16,6 +16,7 @@
 #include "dsi/CRequestWriter.hpp"
 
 #include "dsi/private/CNonCopyable.hpp"
+#include "dsi/private/streamable.hpp"
 
 
 namespace DSI
@@ -63,6 +64,15 @@ namespace DSI
        * Write method for blob data.
        */
       COStream& write(const void* data, size_t size);
+
+      /**
+       * Write an array of trivially streamable elements with a single copy.
+       *
+       * @return false if the current offset does not allow copying the memory layout, the
+       *         elements must be written one by one then.
+       */
+      template<typename T>
+      bool writeBulk(const T* data, size_t count);
       
    private:
 
@@ -113,6 +123,30 @@ namespace DSI
    }
 
 
+   template<typename T>
+   inline
+   bool COStream::writeBulk(const T* data, size_t count)
+   {
+      // same padding the per element serialization would insert before the first element
+      const size_t padding = (-mWriter.size()) & (IsTriviallyStreamable<T>::leading - 1);
+
+      if (((mWriter.size() + padding) & (IsTriviallyStreamable<T>::alignment - 1)) != 0)
+         return false;
+
+      const size_t len = count * sizeof(T);
+
+      if ((padding + len) < mWriter.avail() || setCapacity(mWriter.size() + padding + len))
+      {
+         mWriter.pbump(padding);
+
+         memcpy(mWriter.pptr(), data, len);
+         mWriter.pbump(len);
+      }
+
+      return true;
+   }
+
+
    inline
    COStream& COStream::write(bool b)
    {
@@ -235,6 +269,9 @@ DSI::COStream& operator<<(DSI::COStream& os, const std::vector<T>& v)
 {
    int32_t size = v.size();
    os << size;
+
+   if (DSI::IsTriviallyStreamable<T>::value && !v.empty() && os.writeBulk(&v[0], v.size()))
+      return os;
    
    for(typename std::vector<T>::const_iterator iter = v.begin(); iter != v.end(); ++iter)
    {
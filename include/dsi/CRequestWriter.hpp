@@ -22,7 +22,8 @@ namespace DSI
  * Write one single DSI request. The writer combines both, a buffer interface and the
  * actual output channel. Therefore, it may be possible to use a shared memory segment
  * as buffer and send control messages via the channel. The current implementation
- * just uses a heap-based memory buffer sending the data via a socket-based channel.
+ * uses a heap-based memory buffer, local channels copy the payload into a shared memory
+ * ring and only send the message header via the socket.
  */
 class CRequestWriter : public Private::CNonCopyable
 {
@@ -52,6 +53,14 @@ public:
                  , const SPartyID &serverID
                  , uint16_t proto_minor = DSI_PROTOCOL_VERSION_MINOR);
                  
+   /**
+    * Constructor for a response which is serialized once and then sent to multiple receivers
+    * via the @c flush(CChannel&, ...) function. Such a writer is never flushed automatically.
+    */
+   CRequestWriter(DSI::ResultType result
+                 , DSI::Command cmd
+                 , uint32_t id);
+
    /// testing purpose only constructor attaching to a dummy channel
    CRequestWriter();
    
@@ -122,6 +131,28 @@ public:
     */
    bool flush();
    
+   /**
+    * Send the request as serialized so far to the given receiver. Only the party ids, the protocol
+    * version and the sequence number are replaced, the payload is sent as it is without copying it. 
+    * In contrast to @c flush() this function may be called multiple times on the same request object.
+    */
+   bool flush(CChannel& channel
+             , const SPartyID &clientID
+             , const SPartyID &serverID
+             , uint16_t proto_minor
+             , int32_t sequenceNr);
+   
+   /**
+    * Bind the request to the interface of the sending client or server. The interface is only
+    * needed for tracing, unbound requests look it up in the global trace registry on each send.
+    * The description must outlive the writer.
+    */
+   inline
+   void setTraceInterface(const SFNDInterfaceDescription& iface)
+   {
+      mTraceIface = &iface;
+   }
+
    /// Returns the buffer base pointer. For testing purpose only.
    inline
    const char* gptr() const
@@ -131,6 +162,9 @@ public:
    
 private:
 
+   /// Send the current request fragment by fragment via the given channel.
+   bool send(CChannel& channel);
+
    /// Connect and disconnect requests do not have an event info.
    inline
    bool haveEventInfo() const
@@ -151,6 +185,8 @@ private:
    EventInfo mInfo;          ///< event information for data requests - may be unused for other request types
 
    Private::CBuffer mBuf;    ///< where to write the data to
+
+   const SFNDInterfaceDescription* mTraceIface;   ///< interface for tracing, may be 0
 };
 
 }   // end namespace
@@ -12,6 +12,7 @@
 #include "dsi/DSI.hpp"
 #include "dsi/CBase.hpp"
 #include "dsi/CChannel.hpp"
+#include "dsi/private/TNotificationRegistry.hpp"
 
 #include <string>
 #include <map>
@@ -27,6 +28,7 @@ namespace DSI
    class CCommEngine;
    class CConnectRequestHandle;
    class CTCPConnectRequestHandle;
+   class CRequestWriter;
 
    namespace Private
    {
@@ -213,6 +215,17 @@ namespace DSI
          {
             // NOOP
          }
+
+         inline
+         SessionData& operator=(const SessionData& rhs)
+         {
+            sessionId = rhs.sessionId;
+            clientID = rhs.clientID;
+            sequenceNr = rhs.sequenceNr;
+            updateId = rhs.updateId;
+
+            return *this;
+         }
       };
 
       /**
@@ -238,6 +251,15 @@ namespace DSI
          {
             // NOOP
          }
+
+         inline
+         Notification& operator=(const Notification& rhs)
+         {
+            SessionData::operator=(rhs);
+            notifyID = rhs.notifyID;
+
+            return *this;
+         }
       };
 
       /**
@@ -385,9 +407,15 @@ namespace DSI
        */
       void sendResponse(uint32_t responseId, uint32_t id, DSI::ResultType type, uint32_t* err = 0);
 
+      /**
+       * Send the already serialized response in @c writer to all clients waiting for the
+       * response with the given @c responseId. This will be called from within generated code.
+       */
+      void sendResponse(uint32_t responseId, CRequestWriter& writer);
+
       typedef std::set<ClientConnection> clientconnectionlist_type;
       typedef std::map<int32_t, Notification> unblockedsessionsmap_type;
-      typedef std::vector<Notification> notificationlist_type;
+      typedef Private::TNotificationRegistry<Notification> notificationlist_type;
       typedef std::vector<SessionData> sessionlist_type;
       typedef std::set<int32_t> activesessionlist_type;
 
@@ -401,8 +429,9 @@ namespace DSI
       clientconnectionlist_type mClientConnections ;
 
       /**
-       * List of all set notifications - a request/response pair will insert a temporary notification
-       * before calling the user-provided handle function and will drop it again afterwards.
+       * All set notifications, indexed by notification id and client id - a request/response pair
+       * will insert a temporary notification before calling the user-provided handle function and
+       * will drop it again afterwards.
        */
       notificationlist_type mNotifications ;
 
@@ -446,6 +475,12 @@ namespace DSI
        */
       void handleDataRequest(Private::CDataRequestHandle &handle);
 
+      /**
+       * Adds the notification of a client unless it already exists and sends the current value
+       * of an attribute back to the client.
+       */
+      void addNotification(const SPartyID& clientID, uint32_t requestId, DSI::RequestType requestType, int32_t sequenceNr);
+
       /**
        * Handles the DSI disconnect request which is sent by a client during a graceful shutdown.
        */
@@ -487,6 +522,13 @@ namespace DSI
        */
       void registerInterfaceTCP( uint32_t address, int32_t port );
 
+      /**
+       * Registrate all given servers at the servicebroker, one batched request for tcp transport
+       * followed by one for local transport. Servers restricted to a user group are registrated
+       * one by one since the batched request does not transport the group.
+       */
+      static void registerInterfaces( const std::vector<CServer*>& servers, int32_t channel, uint32_t address, int32_t port );
+
       /**
        * Unregistrates the server at the servicebroker. This will be done for both local and
        * TCP transport.
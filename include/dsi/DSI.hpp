@@ -25,6 +25,25 @@
 /// maximum payload size (still including eventinfo
 #define DSI_PAYLOAD_SIZE DSI_PACKET_SIZE - sizeof(DSI::MessageHeader)
 
+/**
+ * Default for the maximum size of a single message frame including the message header. Peers
+ * supporting large frames announce this size during connection setup and send messages up to the
+ * smaller of both sizes in one frame. May be overridden at runtime by the environment variable
+ * DSI_MAX_FRAME_SIZE. Connections to legacy peers always use DSI_PACKET_SIZE.
+ */
+#ifndef DSI_MAX_FRAME_SIZE
+#   define DSI_MAX_FRAME_SIZE (1024*1024)
+#endif
+
+/**
+ * Default for the maximum total size of a received message, summed up over all its frames.
+ * Larger messages are rejected and the connection to the sender is closed. May be overridden at
+ * runtime by the environment variable DSI_MAX_MESSAGE_SIZE.
+ */
+#ifndef DSI_MAX_MESSAGE_SIZE
+#   define DSI_MAX_MESSAGE_SIZE (64*1024*1024)
+#endif
+
 
 /**
  * DSI - Distributed Service Interface. This namespace contains of classes necessary
@@ -83,7 +102,9 @@ namespace DSI
       DataResponse      =  8,       ///< a data response transfer is initiated
       ConnectRequest    =  9,       ///< a connection is requested
       DisconnectRequest = 10,       ///< a disconnection is requested
-      ConnectResponse   = 11        ///< response to a connect request
+      ConnectResponse   = 11,       ///< response to a connect request
+      ShmSetupRequest   = 12,       ///< a shared memory ring for the channel is offered
+      ShmSetupResponse  = 13        ///< response to a shared memory ring offer
    };
 
 
@@ -104,7 +125,13 @@ namespace DSI
       uint32_t flags;          ///< Flasgs (bit 1 indicates if there is at least one more packet comming
       uint32_t packetLength;   ///< The length of this packet (without message header).
 
-      int32_t reserved[1];     ///< reserved (fillup for 8 byte-alignment)
+      /**
+       * Reserved (fillup for 8 byte-alignment). The first fragment of a multi-fragment message
+       * carries the total length of all fragments here, so the receiver can allocate the
+       * buffer at once. ConnectRequest and ConnectResponse messages carry the maximum frame
+       * size the sender accepts. Older senders always transmit 0.
+       */
+      int32_t reserved[1];
 
       /**
        * Creates an uninitialized message header.
@@ -127,7 +154,9 @@ namespace DSI
       REQUEST_STOP_ALL_NOTIFY          = 0x0104,  ///< Clear all existing notification for a data attribute or for a response method
       REQUEST_REGISTER_NOTIFY          = 0x0105,  ///< Register for registzered notifications for a for a response method or information method
       REQUEST_STOP_REGISTER_NOTIFY     = 0x0106,  ///< Clear for registered notifications for a for a response method or information method
-      REQUEST_STOP_ALL_REGISTER_NOTIFY = 0x0107   ///< Clear for all registered notifications for a for a response method or information method
+      REQUEST_STOP_ALL_REGISTER_NOTIFY = 0x0107,  ///< Clear for all registered notifications for a for a response method or information method
+      REQUEST_NOTIFY_LIST              = 0x0108,  ///< Register for notifications for all data attributes or response methods in the payload
+      REQUEST_STOP_NOTIFY_LIST         = 0x0109   ///< Clear the notifications for all data attributes or response methods in the payload
    } ;
 
 
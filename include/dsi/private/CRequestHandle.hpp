@@ -65,6 +65,12 @@ namespace DSI
             // NOOP
          }
 
+         inline
+         const DSI::MessageHeader& header() const
+         {
+            return mHdr;
+         }
+
          std::tr1::shared_ptr<ChannelT> mChnl;
          
       private:
@@ -0,0 +1,365 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_PRIVATE_TNOTIFICATIONREGISTRY_HPP
+#define DSI_PRIVATE_TNOTIFICATIONREGISTRY_HPP
+
+
+#include <map>
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <stdint.h>
+
+#include "dsi/DSI.hpp"
+#include "dsi/private/CNonCopyable.hpp"
+
+
+namespace DSI
+{
+   namespace Private
+   {
+
+      /**
+       * @internal
+       *
+       * Container for all notifications set on a server. The notifications are indexed by their
+       * notification id, by the client id and by the session id, so looking up the receivers of one
+       * update or all notifications of one client does not depend on the total number of notifications.
+       *
+       * Each notification is identified by a handle. A handle stays valid until the notification is
+       * erased and erasing an already erased handle is a NOOP. Therefore, the registry may be
+       * modified while working on a formerly collected list of handles.
+       *
+       * The NotificationT type must provide the members @c notifyID, @c clientID and @c sessionId.
+       *
+       * Stubs generated by former code generators access the notifications like a vector, by their
+       * position in the order they were added. The positional access is linear on the distance
+       * to the last accessed position, so iterating over all notifications is linear as well.
+       */
+      template<typename NotificationT>
+      class TNotificationRegistry : public CNonCopyable
+      {
+      public:
+
+         typedef uint32_t handle_type;
+         typedef std::vector<handle_type> handlelist_type;
+
+         /**
+          * Position of a notification for the vector compatible interface, only valid until
+          * the registry is modified.
+          */
+         class iterator
+         {
+         public:
+
+            explicit inline
+            iterator(size_t index)
+             : mIndex(index)
+            {
+               // NOOP
+            }
+
+            inline
+            iterator operator+(ptrdiff_t n) const
+            {
+               return iterator(mIndex + n);
+            }
+
+            inline
+            size_t index() const
+            {
+               return mIndex;
+            }
+
+         private:
+
+            size_t mIndex;
+         };
+
+         inline
+         TNotificationRegistry()
+          : mCursorValid(false)
+          , mCursorIndex(0)
+          , mNextHandle(0)
+         {
+            // NOOP
+         }
+
+         /**
+          * Add the given notification.
+          *
+          * @return the handle of the new notification.
+          */
+         handle_type add(const NotificationT& n);
+
+         /**
+          * Remove the notification with the given handle.
+          */
+         void erase(handle_type handle);
+
+         /**
+          * Vector compatible interface: remove the notification at the given position.
+          */
+         void erase(const iterator& pos);
+
+         /**
+          * Vector compatible interface: @return the position of the first notification.
+          */
+         inline
+         iterator begin() const
+         {
+            return iterator(0);
+         }
+
+         /**
+          * Vector compatible interface: @return the notification at the given position.
+          */
+         inline
+         NotificationT& operator[](size_t index)
+         {
+            return at(index)->second.notification;
+         }
+
+         /**
+          * @return the notification with the given handle or 0 if it does not exist (any more).
+          */
+         inline
+         NotificationT* find(handle_type handle)
+         {
+            typename entrymap_type::iterator iter = mEntries.find(handle);
+            return iter != mEntries.end() ? &iter->second.notification : 0;
+         }
+
+         /**
+          * @return true if at least one notification is set on the given notification id.
+          */
+         inline
+         bool contains(uint32_t notifyID) const
+         {
+            return mByNotifyID.find(notifyID) != mByNotifyID.end();
+         }
+
+         inline
+         size_t size() const
+         {
+            return mEntries.size();
+         }
+
+         inline
+         bool empty() const
+         {
+            return mEntries.empty();
+         }
+
+         /**
+          * Append the handles of all notifications set on the given notification id to @c handles.
+          * The handles are appended in the order the notifications were added.
+          */
+         void collect(uint32_t notifyID, handlelist_type& handles) const;
+
+         /**
+          * Append the handles of all notifications set by the given client to @c handles. If @c notifyID
+          * is not DSI::INVALID_ID only notifications with this notification id are taken into account.
+          * The handles are appended in the order the notifications were added.
+          */
+         void collectClient(uint64_t clientID, uint32_t notifyID, handlelist_type& handles) const;
+
+         /**
+          * Append the handles of all notifications correlated with the given session to @c handles.
+          */
+         void collectSession(int32_t sessionId, handlelist_type& handles) const;
+
+      private:
+
+         typedef std::multimap<uint32_t, handle_type> notifyidindex_type;
+         typedef std::multimap<uint64_t, handle_type> clientindex_type;
+         typedef std::multimap<int32_t, handle_type> sessionindex_type;
+
+         struct Entry
+         {
+            NotificationT notification;
+
+            typename notifyidindex_type::iterator byNotifyID;
+            typename clientindex_type::iterator byClient;
+            typename sessionindex_type::iterator bySession;
+         };
+
+         typedef std::map<handle_type, Entry> entrymap_type;
+
+         template<typename IndexT, typename KeyT>
+         static
+         void collectRange(const IndexT& index, KeyT key, handlelist_type& handles);
+
+         /// @return the entry at the given position, starting from the closest known position
+         typename entrymap_type::iterator at(size_t index);
+
+         void eraseEntry(typename entrymap_type::iterator iter);
+
+         entrymap_type mEntries;
+
+         /// the last position accessed via the vector compatible interface
+         bool mCursorValid;
+         size_t mCursorIndex;
+         typename entrymap_type::iterator mCursor;
+
+         notifyidindex_type mByNotifyID;
+         clientindex_type mByClient;
+         sessionindex_type mBySession;
+
+         handle_type mNextHandle;
+      };
+
+
+      // ---------------------------------------------------------------------------------------------
+
+
+      template<typename NotificationT>
+      typename TNotificationRegistry<NotificationT>::handle_type
+      TNotificationRegistry<NotificationT>::add(const NotificationT& n)
+      {
+         // skip handles still in use after a wrap-around
+         do
+         {
+            ++mNextHandle;
+         }
+         while(mEntries.find(mNextHandle) != mEntries.end());
+
+         // a wrapped around handle may shift the positions
+         mCursorValid = false;
+
+         Entry& entry = mEntries[mNextHandle];
+
+         entry.notification = n;
+         entry.byNotifyID = mByNotifyID.insert(std::make_pair(uint32_t(n.notifyID), mNextHandle));
+         entry.byClient = mByClient.insert(std::make_pair(uint64_t(n.clientID), mNextHandle));
+         entry.bySession = mBySession.insert(std::make_pair(int32_t(n.sessionId), mNextHandle));
+
+         return mNextHandle;
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::erase(handle_type handle)
+      {
+         typename entrymap_type::iterator iter = mEntries.find(handle);
+
+         if (iter != mEntries.end())
+         {
+            mCursorValid = false;
+            eraseEntry(iter);
+         }
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::erase(const iterator& pos)
+      {
+         typename entrymap_type::iterator iter = at(pos.index());
+
+         // generated code erases while iterating backwards, the predecessor keeps its position
+         if (pos.index() > 0)
+         {
+            --mCursor;
+            --mCursorIndex;
+         }
+         else
+            mCursorValid = false;
+
+         eraseEntry(iter);
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::eraseEntry(typename entrymap_type::iterator iter)
+      {
+         mByNotifyID.erase(iter->second.byNotifyID);
+         mByClient.erase(iter->second.byClient);
+         mBySession.erase(iter->second.bySession);
+
+         mEntries.erase(iter);
+      }
+
+
+      template<typename NotificationT>
+      typename TNotificationRegistry<NotificationT>::entrymap_type::iterator
+      TNotificationRegistry<NotificationT>::at(size_t index)
+      {
+         assert(index < mEntries.size());
+
+         const size_t last = mEntries.size() - 1;
+         const size_t distance = mCursorValid ? (index > mCursorIndex ? index - mCursorIndex : mCursorIndex - index) : last + 1;
+
+         if (index < distance)
+         {
+            mCursor = mEntries.begin();
+            mCursorIndex = 0;
+         }
+         else if (last - index < distance)
+         {
+            mCursor = --mEntries.end();
+            mCursorIndex = last;
+         }
+
+         mCursorValid = true;
+
+         for (; mCursorIndex < index; ++mCursorIndex)
+            ++mCursor;
+
+         for (; mCursorIndex > index; --mCursorIndex)
+            --mCursor;
+
+         return mCursor;
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::collect(uint32_t notifyID, handlelist_type& handles) const
+      {
+         collectRange(mByNotifyID, notifyID, handles);
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::collectClient(uint64_t clientID, uint32_t notifyID, handlelist_type& handles) const
+      {
+         std::pair<typename clientindex_type::const_iterator, typename clientindex_type::const_iterator> range
+            = mByClient.equal_range(clientID);
+
+         for (typename clientindex_type::const_iterator iter = range.first; iter != range.second; ++iter)
+         {
+            if (DSI::INVALID_ID == notifyID
+               || mEntries.find(iter->second)->second.notification.notifyID == notifyID)
+            {
+               handles.push_back(iter->second);
+            }
+         }
+      }
+
+
+      template<typename NotificationT>
+      void TNotificationRegistry<NotificationT>::collectSession(int32_t sessionId, handlelist_type& handles) const
+      {
+         collectRange(mBySession, sessionId, handles);
+      }
+
+
+      template<typename NotificationT>
+      template<typename IndexT, typename KeyT>
+      void TNotificationRegistry<NotificationT>::collectRange(const IndexT& index, KeyT key, handlelist_type& handles)
+      {
+         std::pair<typename IndexT::const_iterator, typename IndexT::const_iterator> range = index.equal_range(key);
+
+         for (typename IndexT::const_iterator iter = range.first; iter != range.second; ++iter)
+            handles.push_back(iter->second);
+      }
+
+   }   // namespace Private
+}   // namespace DSI
+
+
+#endif   // DSI_PRIVATE_TNOTIFICATIONREGISTRY_HPP
@@ -0,0 +1,83 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_PRIVATE_STREAMABLE_HPP
+#define DSI_PRIVATE_STREAMABLE_HPP
+
+
+#include <stdint.h>
+
+
+namespace DSI
+{
+
+   /**
+    * @internal
+    *
+    * Marks types whose memory layout equals their layout on the stream so vectors of them
+    * can be serialized with a single copy instead of element by element.
+    *
+    * @c alignment is the stream alignment of the type (its largest field), @c leading the
+    * alignment of its first field. The per element serialization aligns the first element to
+    * @c leading only, so the bulk copy can just be used if this also satisfies @c alignment.
+    */
+   template<typename T>
+   struct IsTriviallyStreamable
+   {
+      enum { value = false, alignment = 1, leading = 1 };
+   };
+
+}   // namespace DSI
+
+
+/**
+ * @internal
+ */
+#define DSI_TRIVIALLY_STREAMABLE_INTRINSIC(type)                                \
+   namespace DSI {                                                              \
+      template<>                                                                \
+      struct IsTriviallyStreamable<type>                                        \
+      {                                                                         \
+         enum { value = true, alignment = sizeof(type), leading = sizeof(type) }; \
+      };                                                                        \
+   }
+
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(int8_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(int16_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(int32_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(int64_t)
+
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(uint8_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(uint16_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(uint32_t)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(uint64_t)
+
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(double)
+DSI_TRIVIALLY_STREAMABLE_INTRINSIC(float)
+
+// bool is streamed as int32_t and enumerations as uint32_t, so they are not trivially streamable.
+
+
+/**
+ * Mark a plain structure of intrinsic fields as trivially streamable, used by the generated
+ * streaming code. The generator only emits it for field sequences without any padding on the
+ * stream, @c size is the sum of all field sizes. If the compiler pads the structure nevertheless
+ * its size differs and the vectors are streamed element by element.
+ *
+ * Must be used from within the global namespace.
+ */
+#define DSI_TRIVIALLY_STREAMABLE(type, size, leadingsize, alignmentsize)                 \
+   namespace DSI {                                                                       \
+      template<>                                                                         \
+      struct IsTriviallyStreamable< type >                                               \
+      {                                                                                  \
+         enum { value = (sizeof(type) == size), alignment = alignmentsize, leading = leadingsize }; \
+      };                                                                                 \
+   }
+
+
+#endif   // DSI_PRIVATE_STREAMABLE_HPP
@@ -28,8 +28,15 @@
 /** @brief The DSI protocol major version number. */
 #define DSI_PROTOCOL_VERSION_MAJOR 4
 
-/** @brief The DSI protocol minor version number. */
-#define DSI_PROTOCOL_VERSION_MINOR 0
+/**
+ * @brief The DSI protocol minor version number.
+ *
+ * @li 0 initial version, messages are fragmented into DSI_PACKET_SIZE frames
+ * @li 1 the maximum frame size is negotiated during connection setup
+ * @li 2 local connections may transfer payloads via shared memory rings
+ * @li 3 notifications may be set and cleared for a list of update ids with one request
+ */
+#define DSI_PROTOCOL_VERSION_MINOR 3
 
 
 /**
@@ -7,14 +7,54 @@
 ****************************************************************/
 #include "dsi/CChannel.hpp"
 
+#include <cstring>
+
+#include "CCorkScope.hpp"
+
 
 DSI::CChannel::CChannel() 
+ : mMaxFrameSize(DSI_PACKET_SIZE)
+ , mCorkScope(0)
 {
-   // NOOP
+   ::memset(&mTransportStats, 0, sizeof(mTransportStats));
 }
 
 
 DSI::CChannel::~CChannel()
+{
+   if (mCorkScope)
+      mCorkScope->remove(*this);
+}
+
+
+bool DSI::CChannel::recvShared(void* /*buf*/, size_t /*len*/, uint32_t /*position*/)
+{
+   return false;
+}
+
+
+void DSI::CChannel::setSendQueueConfig(const SendQueueConfig& /*config*/)
 {
    // NOOP
 }
+
+
+DSI::SendQueueStatistics DSI::CChannel::getSendQueueStatistics() const
+{
+   SendQueueStatistics stats;
+   ::memset(&stats, 0, sizeof(stats));
+
+   return stats;
+}
+
+
+void DSI::CChannel::cork()
+{
+   // NOOP
+}
+
+
+bool DSI::CChannel::uncork()
+{
+   return true;
+}
@@ -7,6 +7,7 @@
 ****************************************************************/
 #include "dsi/CClient.hpp"
 #include "dsi/CRequestWriter.hpp"
+#include "dsi/COStream.hpp"
 #include "dsi/CCommEngine.hpp"
 #include "dsi/Log.hpp"
 
@@ -174,7 +175,8 @@ int32_t DSI::CClient::sendDisconnectRequest()
 
    if (!mChannel.expired())
    {
-      CRequestWriter writer(*mChannel.lock(), DSI::DisconnectRequest, mClientID, mServerID);
+      CRequestWriter writer(*mChannel.lock(), DSI::DisconnectRequest, mClientID, mServerID, mProtoMinor);
+      writer.setTraceInterface(mIfDescription);
       (void)writer.flush();      
    }
    else
@@ -195,7 +197,8 @@ void DSI::CClient::setNotification( notificationid_t id )
    if (!mChannel.expired())
    {
       CRequestWriter writer(*mChannel.lock(), DSI::REQUEST_NOTIFY, DSI::DataRequest, id, mClientID, mServerID, 
-                            DSI::INVALID_SEQUENCE_NR, mProtoMinor);
+                            mProtoMinor);
+      writer.setTraceInterface(mIfDescription);
       (void)writer.flush();      
    }
    else
@@ -215,7 +218,8 @@ void DSI::CClient::clearNotification( notificationid_t id )
    if (!mChannel.expired())
    {
       CRequestWriter writer(*mChannel.lock(), DSI::REQUEST_STOP_NOTIFY, DSI::DataRequest, id, mClientID, mServerID,
-                            DSI::INVALID_SEQUENCE_NR);
+                            mProtoMinor);
+      writer.setTraceInterface(mIfDescription);
       (void)writer.flush();
    }
    else
@@ -226,6 +230,70 @@ void DSI::CClient::clearNotification( notificationid_t id )
 }
 
 
+void DSI::CClient::setNotifications( const std::vector<notificationid_t>& ids )
+{
+   TRC_SCOPE( dsi_base, CClient, global );
+   DBG_MSG(("CClient::setNotifications() %s %d.%d - %d ids", mIfDescription.name,
+            mIfDescription.version.majorVersion, mIfDescription.version.minorVersion, (int)ids.size() ));
+
+   if (mProtoMinor < DSI::NotifyListProtoMinor)
+   {
+      for (std::vector<notificationid_t>::const_iterator iter = ids.begin(); iter != ids.end(); ++iter)
+         setNotification(*iter);
+   }
+   else if (!mChannel.expired())
+   {
+      if (!ids.empty())
+      {
+         CRequestWriter writer(*mChannel.lock(), DSI::REQUEST_NOTIFY_LIST, DSI::DataRequest, DSI::INVALID_ID, mClientID, mServerID,
+                               mProtoMinor);
+         writer.setTraceInterface(mIfDescription);
+
+         COStream ostream(writer);
+         ostream << ids;
+
+         (void)writer.flush();
+      }
+   }
+   else
+   {
+      assert(!mChannel.expired());
+   }
+}
+
+
+void DSI::CClient::clearNotifications( const std::vector<notificationid_t>& ids )
+{
+   TRC_SCOPE( dsi_base, CClient, global );
+   DBG_MSG(("CClient::clearNotifications() %s %d.%d - %d ids", mIfDescription.name,
+            mIfDescription.version.majorVersion, mIfDescription.version.minorVersion, (int)ids.size() ));
+
+   if (mProtoMinor < DSI::NotifyListProtoMinor)
+   {
+      for (std::vector<notificationid_t>::const_iterator iter = ids.begin(); iter != ids.end(); ++iter)
+         clearNotification(*iter);
+   }
+   else if (!mChannel.expired())
+   {
+      if (!ids.empty())
+      {
+         CRequestWriter writer(*mChannel.lock(), DSI::REQUEST_STOP_NOTIFY_LIST, DSI::DataRequest, DSI::INVALID_ID, mClientID, mServerID,
+                               mProtoMinor);
+         writer.setTraceInterface(mIfDescription);
+
+         COStream ostream(writer);
+         ostream << ids;
+
+         (void)writer.flush();
+      }
+   }
+   else
+   {
+      assert(!mChannel.expired());
+   }
+}
+
+
 void DSI::CClient::clearAllNotifications()
 {
    TRC_SCOPE( dsi_base, CClient, global );
@@ -235,7 +303,8 @@ void DSI::CClient::clearAllNotifications()
    if (!mChannel.expired())
    {
       CRequestWriter writer(*mChannel.lock(), DSI::REQUEST_STOP_ALL_NOTIFY, DSI::DataRequest, DSI::INVALID_ID, mClientID, mServerID,
-                            DSI::INVALID_SEQUENCE_NR) ;
+                            mProtoMinor) ;
+      writer.setTraceInterface(mIfDescription);
       (void)writer.flush();
    }
    else
@@ -8,6 +8,7 @@
 #include "io.hpp"
 #include "CClientConnectSM.hpp"
 #include "CConnectRequestHandle.hpp"
+#include "CShmChannel.hpp"
 #include "CDummyChannel.hpp"
 #include "CTCPChannel.hpp"
 #include "bind.hpp"
@@ -40,7 +41,9 @@ namespace DSI
 
 DSI::CClientConnectSM::CClientConnectSM(DSI::CClient& client)
  : mClient(client)
+ , mBroker(client.mCommEngine->getServicebroker())
  , mChannel()
+ , mPrivateChannel(false)
  , mBuffer()
 {
    ::memset(&mConnInfo, 0, sizeof(mConnInfo));
@@ -50,6 +53,13 @@ DSI::CClientConnectSM::CClientConnectSM(DSI::CClient& client)
 
 DSI::CClientConnectSM::~CClientConnectSM()
 {
+   // responses of the servicebroker still on their way must not reach us any more
+   mBroker.cancel(this);
+
+   // the engine resets the client's pointer when it is gone first
+   if (mPrivateChannel && mChannel && mClient.mCommEngine)
+      mClient.mCommEngine->releasePrivateChannel(*mChannel);
+
    // we must drop it since otherwise we recurse into destructor calls
    (void)mClient.mConnector.release();
 }
@@ -57,73 +67,137 @@ DSI::CClientConnectSM::~CClientConnectSM()
 
 void DSI::CClientConnectSM::attach()
 {
-   bool detach = true;
-   int ret;
+   if (!requestAttach(false))
+   {
+      DBG_ERROR(( "Error attaching to interface %s: servicebroker not available", mClient.mIfDescription.name ));
+      (void)onFailure();
+   }
+}
+
+
+bool DSI::CClientConnectSM::requestAttach(bool tcp)
+{
+   SFNDInterfaceAttachArg arg;
+   ::memset(&arg, 0, sizeof(arg));
 
-   if ((ret = CServicebroker::attachInterface(mClient.mIfDescription, mConnInfo)) != 0)
+   arg.i.sbVersion.majorVersion = DSI_SERVICEBROKER_VERSION_MAJOR;
+   arg.i.sbVersion.minorVersion = DSI_SERVICEBROKER_VERSION_MINOR;
+   arg.i.ifDescription.version = mClient.mIfDescription.version;
+
+   if (tcp)
    {
-      DBG_ERROR(( "Error attaching to interface %s: rc=%d", mClient.mIfDescription.name , ret));
+      // TCP/IP servers are registered with the '_tcp' suffix
+      ::strncpy(arg.i.ifDescription.name, mClient.mIfDescription.name, sizeof(arg.i.ifDescription.name) - 4);
+      ::strcat(arg.i.ifDescription.name, "_tcp");
    }
    else
+      ::strncpy(arg.i.ifDescription.name, mClient.mIfDescription.name, sizeof(arg.i.ifDescription.name));
+
+   return mBroker.request(DCMD_FND_ATTACH_INTERFACE, &arg, sizeof(arg.i),
+                          std::tr1::bind(tcp ? &CClientConnectSM::onAttachedTCP : &CClientConnectSM::onAttached,
+                                         this, _1, _2, _3), this);
+}
+
+
+void DSI::CClientConnectSM::onAttached(int rc, const void* data, size_t len)
+{
+   if (rc != 0 || len < sizeof(SConnectionInfo))
    {
+      DBG_ERROR(( "Error attaching to interface %s: rc=%d", mClient.mIfDescription.name , rc));
+      (void)onFailure();
+   }
+   else
+   {
+      ::memcpy(&mConnInfo, data, sizeof(mConnInfo));
       CTraceManager::add(mConnInfo.clientID, mClient.mIfDescription);
-      
+
       // forced TCP/IP transport?
       if (isTCPForced() || mConnInfo.channel.nid != 0)   // tcp transport adequate?
       {
-         if ((ret = CServicebroker::attachInterfaceTCP(mClient.mIfDescription, mTcpConnInfo)) != 0)
-         {
-            DBG_ERROR(( "Error attaching to interface %s via TCP: rc=%d", mClient.mIfDescription.name , ret));
-         }
-         else
-         {
-            mChannel = mClient.mCommEngine->attachTCP(mTcpConnInfo.socket.ipaddress, mTcpConnInfo.socket.port, true);
+         if (!requestAttach(true))
+            onAttachedTCP(-1, 0, 0);
+      }
+      else
+         connectLocal();
+   }
+}
 
-            if (mChannel)
-            {
-               if (initiateConnectRequestTCP())
-               {
-                  detach = false;
 
-                  CServicebroker::detachInterface(mConnInfo.clientID);
-                  mConnInfo.clientID = 0;
-               }
-            }
-            else
-            {
-               DBG_ERROR(("CClient: Error connecting TCP %d.%d.%d.%d:%d",
-                    mTcpConnInfo.socket.ipaddress & 0xFF,
-                    mTcpConnInfo.socket.ipaddress >> 8  & 0xFF,
-                    mTcpConnInfo.socket.ipaddress >> 16 & 0xFF,
-                    mTcpConnInfo.socket.ipaddress >> 24,
-                    ntohs(mTcpConnInfo.socket.port)));
-            }
+void DSI::CClientConnectSM::onAttachedTCP(int rc, const void* data, size_t len)
+{
+   if (rc != 0 || len < sizeof(SConnectionInfo))
+   {
+      DBG_ERROR(( "Error attaching to interface %s via TCP: rc=%d", mClient.mIfDescription.name , rc));
+   }
+   else
+   {
+      SConnectionInfo info;
+      ::memcpy(&info, data, sizeof(info));
+
+      mTcpConnInfo.ifVersion = info.ifVersion;
+      mTcpConnInfo.serverID = info.serverID;
+      mTcpConnInfo.clientID = info.clientID;
+      mTcpConnInfo.socket.ipaddress = info.channel.pid;
+      mTcpConnInfo.socket.port = info.channel.chid;
+
+      if (mPrivateChannel && mChannel)
+         mClient.mCommEngine->releasePrivateChannel(*mChannel);
+
+      mChannel = mClient.mCommEngine->attachTCP(mTcpConnInfo.socket.ipaddress, mTcpConnInfo.socket.port, true);
+      mPrivateChannel = true;
+
+      if (mChannel)
+      {
+         if (initiateConnectRequestTCP())
+         {
+            detachInterface(mConnInfo.clientID);
+            mConnInfo.clientID = 0;
+
+            return;
          }
       }
+      else
+      {
+         DBG_ERROR(("CClient: Error connecting TCP %d.%d.%d.%d:%d",
+              mTcpConnInfo.socket.ipaddress & 0xFF,
+              mTcpConnInfo.socket.ipaddress >> 8  & 0xFF,
+              mTcpConnInfo.socket.ipaddress >> 16 & 0xFF,
+              mTcpConnInfo.socket.ipaddress >> 24,
+              ntohs(mTcpConnInfo.socket.port)));
+      }
+   }
+
+   connectLocal();
+}
+
+
+void DSI::CClientConnectSM::connectLocal()
+{
+   bool detach = true;
 
-      if (!mChannel)
+   if (!mChannel)
+   {
+      if (mConnInfo.channel.nid == 0)
       {
-         if (mConnInfo.channel.nid == 0)
-         {
-            // local attach possible?
-            mChannel = mClient.mCommEngine->attach(mConnInfo.channel.pid, mConnInfo.channel.chid);
-
-            if (mChannel)
-            {               
-               if (initiateConnectRequest())
-               {
-                  detach = false;
-
-                  if (mTcpConnInfo.clientID != 0)
-                     CServicebroker::detachInterface(mTcpConnInfo.clientID);
-               }
-            }
-            else
+         // local attach possible?
+         mChannel = mClient.mCommEngine->attach(mConnInfo.channel.pid, mConnInfo.channel.chid);
+         mPrivateChannel = false;
+
+         if (mChannel)
+         {               
+            if (initiateConnectRequest())
             {
-               DBG_ERROR(("Error attaching to interface %s: Invalid Channel (%d, %d, %d)",
-                          mClient.mIfDescription.name, mConnInfo.channel.pid, mConnInfo.channel.chid));
+               detach = false;
+
+               if (mTcpConnInfo.clientID != 0)
+                  detachInterface(mTcpConnInfo.clientID);
             }
          }
+         else
+         {
+            DBG_ERROR(("Error attaching to interface %s: Invalid Channel (%d, %d, %d)",
+                       mClient.mIfDescription.name, mConnInfo.channel.pid, mConnInfo.channel.chid));
+         }
       }
    }
 
@@ -132,6 +206,19 @@ void DSI::CClientConnectSM::attach()
 }
 
 
+void DSI::CClientConnectSM::detachInterface(const SPartyID& clientID)
+{
+   SFNDInterfaceDetachArg arg;
+   ::memset(&arg, 0, sizeof(arg));
+
+   arg.i.sbVersion.majorVersion = DSI_SERVICEBROKER_VERSION_MAJOR;
+   arg.i.sbVersion.minorVersion = DSI_SERVICEBROKER_VERSION_MINOR;
+   arg.i.clientID = clientID;
+
+   (void)mBroker.request(DCMD_FND_DETACH_INTERFACE, &arg, sizeof(arg.i), CServicebrokerConnection::handler_type());
+}
+
+
 bool DSI::CClientConnectSM::initiateConnectRequest()
 {
    TRC_SCOPE( dsi_base, CClient, global );
@@ -141,6 +228,7 @@ bool DSI::CClientConnectSM::initiateConnectRequest()
    mClient.mClientID = mConnInfo.clientID;   
       
    CRequestWriter writer(*mChannel, DSI::ConnectRequest, mConnInfo.clientID, mConnInfo.serverID, DSI_PROTOCOL_VERSION_MINOR);      
+   writer.setTraceInterface(mClient.mIfDescription);
    
    DSI::ConnectRequestInfo* rci = (DSI::ConnectRequestInfo*)writer.pptr();
    rci->pid = ::getpid();
@@ -177,6 +265,7 @@ bool DSI::CClientConnectSM::initiateConnectRequestTCP()
 
          // be aware that the mServerID correlates the mTCPServerID of the server
          CRequestWriter writer(*mChannel, DSI::ConnectRequest, mTcpConnInfo.clientID, mTcpConnInfo.serverID, DSI_PROTOCOL_VERSION_MINOR);            
+         writer.setTraceInterface(mClient.mIfDescription);
          
          DSI::TCPConnectRequestInfo* rci = (DSI::TCPConnectRequestInfo*)writer.pptr();
          rci->ipAddress = ep.getIP();
@@ -201,11 +290,18 @@ void DSI::CClientConnectSM::handleConnectResponse(const CConnectRequestHandle& h
    if (handle.info().pid)
    {
       mClient.mServerID = handle.getServerID();
-      mClient.mChannel = mClient.mCommEngine->attach(handle.info().pid, handle.info().channel);
+      std::tr1::shared_ptr<CChannel> chnl = mClient.mCommEngine->attach(handle.info().pid, handle.info().channel);
       uint16_t isprotoMinor = (uint16_t)DSI_PROTOCOL_VERSION_MINOR;
       uint16_t protoMinor = (handle.getProtoMinor() < isprotoMinor) ? handle.getProtoMinor() : isprotoMinor;
       mClient.mProtoMinor = protoMinor;
 
+      if (chnl)
+      {
+         chnl->setMaxFrameSize(DSI::negotiateMaxFrameSize(protoMinor, handle.getMaxFrameSize()));
+         CShmChannel::upgrade(chnl.get(), protoMinor);
+      }
+      mClient.mChannel = chnl;
+
       (void)finalizeConnectRequest();
    }
    else
@@ -240,7 +336,7 @@ bool DSI::CClientConnectSM::onLegacyConnectRequestTCP(DSI::TCPConnectRequestInfo
          mClient.mServerID = mTcpConnInfo.serverID;
 
          mClient.mChannel = mClient.mCommEngine->attachTCP(info.ipAddress, info.port);
-         mClient.mProtoMinor = DSI_PROTOCOL_VERSION_MINOR;
+         mClient.mProtoMinor = 0;   // legacy server, no protocol negotiation
 
          return finalizeConnectRequest();
       }
@@ -256,11 +352,15 @@ bool DSI::CClientConnectSM::onConnectRequestTCP(sExtendedTCPRequestInfo &extende
       mClient.mClientID = mTcpConnInfo.clientID;
       mClient.mServerID =  mTcpConnInfo.serverID;
 
-      mClient.mChannel = mClient.mCommEngine->attachTCP( extendedInfo.info.ipAddress,  extendedInfo.info.port);
+      std::tr1::shared_ptr<CChannel> chnl = mClient.mCommEngine->attachTCP( extendedInfo.info.ipAddress,  extendedInfo.info.port);
       uint16_t isprotoMinor = (uint16_t)DSI_PROTOCOL_VERSION_MINOR;
       uint16_t protoMinor = (extendedInfo.hdr.protoMinor < isprotoMinor) ? extendedInfo.hdr.protoMinor : isprotoMinor;
       mClient.mProtoMinor = protoMinor;
 
+      if (chnl)
+         chnl->setMaxFrameSize(DSI::negotiateMaxFrameSize(protoMinor, uint32_t(extendedInfo.hdr.reserved[0])));
+      mClient.mChannel = chnl;
+
       return finalizeConnectRequest();
    }
    else
@@ -273,11 +373,11 @@ bool DSI::CClientConnectSM::onConnectRequestTCP(sExtendedTCPRequestInfo &extende
 bool DSI::CClientConnectSM::onFailure()
 {
    if (mTcpConnInfo.clientID != 0)
-      CServicebroker::detachInterface(mTcpConnInfo.clientID);
+      detachInterface(mTcpConnInfo.clientID);
 
    if (mConnInfo.clientID != 0)
    {     
-      CServicebroker::detachInterface(mConnInfo.clientID);   
+      detachInterface(mConnInfo.clientID);   
       CTraceManager::remove(mConnInfo.clientID);
    }
       
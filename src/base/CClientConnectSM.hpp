@@ -12,6 +12,7 @@
 
 #include "DSI.hpp"
 #include "CServicebroker.hpp"
+#include "CServicebrokerConnection.hpp"
 
 
 namespace DSI
@@ -22,13 +23,15 @@ namespace DSI
  * following steps are necessary:
  * 
  * <ul>
+ *   <li>(asynchronously) attach to the interface at the servicebroker
  *   <li>(asnychronously) connect a private temporary channel to the server's communication engine
  *   <li>send a connect request
  *   <li>wait for the response from the server
  *   <li>connect a (potentially shared) channel to the server's communication engine
  * </ul>
  *
- * @note we assume the servicebroker to be reactive so we don't have asynchronous servicebroker calls in here.
+ * The servicebroker attach requests are sent over the communication engine's non-blocking servicebroker
+ * connection, so other clients and servers of the engine are served while the servicebroker answers.
  */
 class CClientConnectSM
 {
@@ -56,6 +59,18 @@ public:
   
 private:   
 
+   /// send the (TCP) attach request to the servicebroker
+   bool requestAttach(bool tcp);
+
+   void onAttached(int rc, const void* data, size_t len);
+   void onAttachedTCP(int rc, const void* data, size_t len);
+
+   /// connect via local transport unless a channel was already established
+   void connectLocal();
+
+   /// release a servicebroker client id without waiting for the result
+   void detachInterface(const SPartyID& clientID);
+
    bool initiateConnectRequest();   
    bool initiateConnectRequestTCP();
       
@@ -71,12 +86,16 @@ private:
    
    
    CClient& mClient;                  ///< The client we belong to.
+   CServicebrokerConnection& mBroker; ///< The servicebroker connection of the client's engine.
    
    SConnectionInfo mConnInfo;
    STCPConnectionInfo mTcpConnInfo;
    
    /// channel to use for connect request on local connections
    std::tr1::shared_ptr<CChannel> mChannel;
+
+   /// mChannel is a private TCP channel, its counters go to the engine on destruction
+   bool mPrivateChannel;
       
    /// receive buffer - there is no DSI message header at all when receiving (TCP)ConnectRequests.   
 
@@ -18,14 +18,23 @@
 
 #include "CTraceManager.hpp"
 #include "CServicebroker.hpp"
+#include "CServicebrokerConnection.hpp"
 #include "io.hpp"
 #include "bind.hpp"
 #include "CLocalChannel.hpp"
+#include "CShmChannel.hpp"
 #include "CTCPChannel.hpp"
 #include "CRequestReader.hpp"
 #include "CConnectRequestHandle.hpp"
 #include "DSI.hpp"
 #include "CClientConnectSM.hpp"
+#include "CCorkScope.hpp"
+#include "CSendQueue.hpp"
+#include "CReceiveBufferPool.hpp"
+#include "MpscQueue.hpp"
+#include "Thread.hpp"
+#include "Trigger.hpp"
+#include "LockGuard.hpp"
 
 #include <algorithm>
 #include <tr1/functional>
@@ -33,7 +42,9 @@
 #include <cassert>
 #include <errno.h>
 #include <cxxabi.h>
+#include <unistd.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h>
 #include <sys/syscall.h>
 
 #define gettid() syscall(SYS_gettid)
@@ -89,6 +100,54 @@ namespace /*anonymous*/
    }
 
 
+   void accumulate(DSI::SendQueueStatistics& sum, const DSI::SendQueueStatistics& stats)
+   {
+      sum.queuedBytes += stats.queuedBytes;
+      sum.peakQueuedBytes = std::max(sum.peakQueuedBytes, stats.peakQueuedBytes);
+      sum.deferredMessages += stats.deferredMessages;
+      sum.droppedMessages += stats.droppedMessages;
+      sum.disconnects += stats.disconnects;
+   }
+
+
+   template<typename MapT>
+   void accumulateChannels(DSI::SendQueueStatistics& sum, const MapT& map)
+   {
+      for(typename MapT::const_iterator iter = map.begin(); iter != map.end(); ++iter)
+         accumulate(sum, iter->second->channel()->getSendQueueStatistics());
+   }
+
+
+   void accumulate(DSI::TransportStatistics& sum, const DSI::TransportStatistics& stats)
+   {
+      sum.bytesSent += stats.bytesSent;
+      sum.bytesReceived += stats.bytesReceived;
+      sum.messagesSent += stats.messagesSent;
+      sum.messagesReceived += stats.messagesReceived;
+      sum.fragmentsSent += stats.fragmentsSent;
+      sum.fragmentsReassembled += stats.fragmentsReassembled;
+      sum.writeCalls += stats.writeCalls;
+      sum.readCalls += stats.readCalls;
+      sum.partialReads += stats.partialReads;
+   }
+
+
+   template<typename MapT>
+   void accumulateTransport(DSI::TransportStatistics& sum, const MapT& map)
+   {
+      for(typename MapT::const_iterator iter = map.begin(); iter != map.end(); ++iter)
+         accumulate(sum, iter->second->channel()->getTransportStatistics());
+   }
+
+
+   template<typename MapT>
+   void configureChannels(MapT& map, const DSI::SendQueueConfig& config)
+   {
+      for(typename MapT::iterator iter = map.begin(); iter != map.end(); ++iter)
+         iter->second->channel()->setSendQueueConfig(config);
+   }
+
+
    template<typename MapT, typename ValueT>
    void removeFromCache(MapT& map, ValueT* value)
    {
@@ -181,7 +240,7 @@ namespace DSI
       static inline
       CChannel* createChannel(Unix::StreamSocket& sock)
       {
-         return new CLocalChannel(sock);
+         return new CShmChannel(sock);
       }
 
       static inline
@@ -217,6 +276,12 @@ namespace DSI
    // ---------------------------------------------------------------------------------------
 
 
+   /**
+    * One shard of the communication engine. A single-threaded engine consists of just one shard,
+    * the primary one. Each further shard has its own dispatcher, acceptors, channels and party caches
+    * and is only touched by its own event loop thread. Other threads hand over work through the
+    * shard's inbox.
+    */
    struct CCommEngine::Private : public DSI::Private::CNonCopyable
    {
       typedef std::vector<CClient*> clientlist_type;
@@ -224,12 +289,46 @@ namespace DSI
 
       typedef std::map<SPartyID, CBase*> partycache_type;
 
-      Private();
+      typedef std::tr1::function<void()> task_type;
+
+      /// create the primary shard
+      explicit
+      Private(unsigned int shards);
+
+      /// create a further shard of the given primary one
+      explicit
+      Private(Private* primary);
+
       ~Private();
 
+      void init();
+
+      /// assign a client or server to a shard (primary only)
+      Private* assign(CBase* base, int shard);
+      Private* release(CBase* base);
+
+      /// run the task in this shard: queued if its event loop runs in another thread, otherwise
+      /// synchronously in the calling thread, after all tasks queued so far
+      void execute(const task_type& task);
+
+      /// run the task in this shard and wait for its completion
+      void call(const task_type& task);
+
+      void post(const task_type& task);
+      bool handleWakeup(GenericEventBase::Result result);
+      void processInbox();
+
+      void setSendQueueConfig(const SendQueueConfig& config);
+      void getSendQueueStatistics(SendQueueStatistics& stats);
+      void getStatistics(CommEngineStatistics& stats);
+
+      /// keep the counters of a channel of attachTCP(..., true) which is released by its owner
+      void addClosedStatistics(const TransportStatistics& transport, const SendQueueStatistics& queue);
+
       int loop();
 
-      int run();
+      /// @param started signalled once the shard accepts tasks through its inbox
+      int run(Trigger* started = 0);
       void stop(int rc);
       void startTCP();
 
@@ -259,6 +358,9 @@ namespace DSI
       CClient* findClient( int32_t id );
       CClient* findClient( const SPartyID& clientID );
 
+      /// interface of the local receiver of the message if tracing is enabled, 0 otherwise
+      const SFNDInterfaceDescription* findTraceInterface( const DSI::MessageHeader& hdr );
+
       int              mSBNotifyChid;
       int              mLocalChid;
       int              mSenderTid;
@@ -276,6 +378,9 @@ namespace DSI
 
       Dispatcher mDispatch;
 
+      /// asynchronous servicebroker requests
+      CServicebrokerConnection mServicebroker;
+
       // notification socket handling
       Unix::Acceptor mNotificationAcceptor;
       Unix::StreamSocket mNextNotificationSocket;
@@ -290,6 +395,29 @@ namespace DSI
 
       std::map<Unix::Endpoint, CClientConnection*> mLocalChannels;
       std::map<IPv4::Endpoint, CClientConnection*> mTCPChannels;
+
+      // outbound send queue handling
+      SendQueueConfig mSendQueueConfig;
+      SendQueueStatistics mClosedChannelStats;   ///< counters of all channels already gone
+      TransportStatistics mClosedTransportStats;
+
+      /// buffers for multi-fragment messages
+      CReceiveBufferPool mReceivePool;
+
+      // sharding
+      Private& mPrimary;
+      std::vector<Private*> mShards;             ///< all shards including this one (primary only)
+      unsigned int mNextShard;                   ///< round-robin assignment (primary only)
+      std::map<CBase*, Private*> mAssignments;   ///< shard of each client and server (primary only)
+      RecursiveMutex mAssignmentLock;
+
+      int mWakeupFd;                             ///< eventfd signalling the inbox
+      MpscQueue<task_type> mInbox;
+      volatile bool mLooping;                    ///< the event loop consumes the inbox
+      RecursiveMutex mDrainLock;                 ///< protects mLooping changes and foreign inbox draining
+
+      /// the shard running in the calling thread
+      static __thread Private* sCurrent;
    };
 
 }//namespace DSI
@@ -326,11 +454,21 @@ DSI::CClientConnection::CClientConnection(SocketT& sock, DSI::CCommEngine::Priva
 
    sock.async_read_all(&mBuf, sizeof(mBuf), bind3(&CClientConnection::handleMessageHeader, this, _1, _2));
    mChnl.reset(createChannel(sock));
+   mChnl->setSendQueueConfig(mCommEngineImp.mSendQueueConfig);
 }
 
 
 DSI::CClientConnection::~CClientConnection()
 {
+   accumulate(mCommEngineImp.mClosedChannelStats, mChnl->getSendQueueStatistics());
+   mCommEngineImp.mClosedChannelStats.queuedBytes = 0;
+
+   accumulate(mCommEngineImp.mClosedTransportStats, mChnl->getTransportStatistics());
+
+   // do not leave dangling connections in the channel caches
+   removeFromCache(mCommEngineImp.mLocalChannels, this);
+   removeFromCache(mCommEngineImp.mTCPChannels, this);
+
    mCommEngineImp.cleanupChannel(mChnl);
 }
 
@@ -352,22 +490,74 @@ bool DSI::CClientConnection::handleMessageHeader(size_t /*len*/, io::error_code
 // --------------------------------------------------------------------------------
 
 
-DSI::CCommEngine::Private::Private()
+DSI::CCommEngine::Private::Private(unsigned int shards)
    : mSBNotifyChid(SBOpenNotificationHandle())
    , mLocalChid(0)
    , mSenderTid(0)
    , mActive(false)
    , mDispatch()
+   , mServicebroker(mDispatch)
    , mNotificationAcceptor(mDispatch, mSBNotifyChid)
    , mNextNotificationSocket(mDispatch)
    , mTCPAcceptor(mDispatch, IPv4::Acceptor::traits_type::Invalid)
    , mNextTCPSocket(mDispatch)
    , mLocalAcceptor(mDispatch, Unix::Acceptor::traits_type::Invalid)
    , mNextLocalSocket(mDispatch)
+   , mSendQueueConfig(CSendQueue::defaultConfig())
+   , mPrimary(*this)
+   , mNextShard(0)
+   , mWakeupFd(-1)
+   , mLooping(false)
 {
+   mShards.push_back(this);
+
+   for (unsigned int i=1; i<shards; ++i)
+      mShards.push_back(new Private(this));
+
+   init();
+}
+
+
+DSI::CCommEngine::Private::Private(Private* primary)
+   : mSBNotifyChid(SBOpenNotificationHandle())
+   , mLocalChid(0)
+   , mSenderTid(0)
+   , mActive(false)
+   , mDispatch()
+   , mServicebroker(mDispatch)
+   , mNotificationAcceptor(mDispatch, mSBNotifyChid)
+   , mNextNotificationSocket(mDispatch)
+   , mTCPAcceptor(mDispatch, IPv4::Acceptor::traits_type::Invalid)
+   , mNextTCPSocket(mDispatch)
+   , mLocalAcceptor(mDispatch, Unix::Acceptor::traits_type::Invalid)
+   , mNextLocalSocket(mDispatch)
+   , mSendQueueConfig(primary->mSendQueueConfig)
+   , mPrimary(*primary)
+   , mNextShard(0)
+   , mWakeupFd(-1)
+   , mLooping(false)
+{
+   init();
+}
+
+
+void DSI::CCommEngine::Private::init()
+{
+   ::memset(&mClosedChannelStats, 0, sizeof(mClosedChannelStats));
+   ::memset(&mClosedTransportStats, 0, sizeof(mClosedTransportStats));
+
    (void)mNotificationAcceptor.listen();
    mNotificationAcceptor.async_accept(mNextNotificationSocket, bind3(&Private::handleNewNotificationConnection, this,
                                                                      _1, _2));
+
+   mWakeupFd = ::eventfd(0, EFD_NONBLOCK);
+   assert(mWakeupFd >= 0);
+
+   if (mWakeupFd >= 0)
+   {
+      mDispatch.enqueueEvent(mWakeupFd, new GenericEvent<std::tr1::function<bool(GenericEventBase::Result)> >(
+                                std::tr1::bind(&Private::handleWakeup, this, _1)), POLLIN);
+   }
 }
 
 
@@ -375,6 +565,188 @@ DSI::CCommEngine::Private::~Private()
 {
    std::for_each(mServerList.begin(), mServerList.end(), ConnectionResetter());
    std::for_each(mClientList.begin(), mClientList.end(), ConnectionResetter());
+
+   if (mWakeupFd >= 0)
+   {
+      mDispatch.removeAll(mWakeupFd);
+      (void)::close(mWakeupFd);
+   }
+
+   for (size_t i=1; i<mShards.size(); ++i)
+      delete mShards[i];
+}
+
+
+DSI::CCommEngine::Private* DSI::CCommEngine::Private::assign(CBase* base, int shard)
+{
+   if (mShards.size() == 1)
+      return this;
+
+   LockGuard<> guard(mAssignmentLock);
+
+   Private* rc = mShards[(shard == CCommEngine::AnyShard ? mNextShard++ : shard) % mShards.size()];
+   mAssignments[base] = rc;
+
+   return rc;
+}
+
+
+DSI::CCommEngine::Private* DSI::CCommEngine::Private::release(CBase* base)
+{
+   if (mShards.size() == 1)
+      return this;
+
+   LockGuard<> guard(mAssignmentLock);
+
+   Private* rc = this;
+
+   std::map<CBase*, Private*>::iterator iter = mAssignments.find(base);
+   if (iter != mAssignments.end())
+   {
+      rc = iter->second;
+      mAssignments.erase(iter);
+   }
+
+   return rc;
+}
+
+
+void DSI::CCommEngine::Private::post(const task_type& task)
+{
+   mInbox.push(task);
+
+   uint64_t one = 1;
+   (void)::write(mWakeupFd, &one, sizeof(one));
+}
+
+
+void DSI::CCommEngine::Private::execute(const task_type& task)
+{
+   if (mWakeupFd < 0 || sCurrent == this)
+   {
+      task();
+   }
+   else
+   {
+      LockGuard<> guard(mDrainLock);
+
+      if (mLooping)
+      {
+         post(task);
+      }
+      else
+      {
+         // nobody else runs in this shard, keep the order of all tasks posted so far
+         processInbox();
+         task();
+      }
+   }
+}
+
+
+namespace /*anonymous*/
+{
+
+   void callAndSignal(const std::tr1::function<void()>& task, DSI::Trigger& done)
+   {
+      task();
+      (void)done.signal();
+   }
+
+}   // namespace anonymous
+
+
+void DSI::CCommEngine::Private::call(const task_type& task)
+{
+   if (mWakeupFd < 0 || sCurrent == this)
+   {
+      task();
+   }
+   else
+   {
+      Trigger done;
+      execute(std::tr1::bind(&callAndSignal, task, ref(done)));
+
+      Private* self = (sCurrent && &sCurrent->mPrimary == &mPrimary) ? sCurrent : 0;
+
+      while(!done.timed_wait(10))
+      {
+         // the target shard may wait for us, too
+         if (self)
+            self->processInbox();
+
+         // the target shard's event loop has finished meanwhile
+         if (!mLooping)
+         {
+            LockGuard<> guard(mDrainLock);
+
+            if (!mLooping)
+               processInbox();
+         }
+      }
+   }
+}
+
+
+bool DSI::CCommEngine::Private::handleWakeup(GenericEventBase::Result /*result*/)
+{
+   uint64_t count;
+   (void)::read(mWakeupFd, &count, sizeof(count));
+
+   processInbox();
+   return true;
+}
+
+
+void DSI::CCommEngine::Private::processInbox()
+{
+   task_type task;
+
+   while(mInbox.pop(task))
+      task();
+}
+
+
+void DSI::CCommEngine::Private::setSendQueueConfig(const SendQueueConfig& config)
+{
+   mSendQueueConfig = config;
+
+   configureChannels(mLocalChannels, config);
+   configureChannels(mTCPChannels, config);
+}
+
+
+void DSI::CCommEngine::Private::getSendQueueStatistics(SendQueueStatistics& stats)
+{
+   SendQueueStatistics closed = mClosedChannelStats;
+   accumulate(stats, closed);
+
+   accumulateChannels(stats, mLocalChannels);
+   accumulateChannels(stats, mTCPChannels);
+}
+
+
+void DSI::CCommEngine::Private::getStatistics(CommEngineStatistics& stats)
+{
+   accumulate(stats.transport, mClosedTransportStats);
+
+   accumulateTransport(stats.transport, mLocalChannels);
+   accumulateTransport(stats.transport, mTCPChannels);
+
+   const DispatcherStatistics& loop = mDispatch.statistics();
+
+   stats.loopIterations += loop.rounds;
+   stats.loopBusyNs += loop.busyNs;
+   stats.maxLoopBusyNs = std::max(stats.maxLoopBusyNs, loop.maxBusyNs);
+}
+
+
+void DSI::CCommEngine::Private::addClosedStatistics(const TransportStatistics& transport, const SendQueueStatistics& queue)
+{
+   accumulate(mClosedChannelStats, queue);
+   mClosedChannelStats.queuedBytes = 0;
+
+   accumulate(mClosedTransportStats, transport);
 }
 
 
@@ -442,14 +814,7 @@ void DSI::CCommEngine::Private::add(CServer &server)
    mServerList.push_back( &server );
 
    if( mActive )
-   {
-      server.registerInterface(mLocalAcceptor.fd()) ;
-
-      if( server.isTCPIPEnabled() )
-         server.registerInterfaceTCP( DSI::getLocalIpAddress(), getIPPort() ) ;
-
-      server.registerInterface(mLocalAcceptor.fd()) ;
-   }
+      registerInterface(&server);
 }
 
 
@@ -472,11 +837,23 @@ void DSI::CCommEngine::Private::registerInterface(CServer* server)
 }
 
 
-int DSI::CCommEngine::Private::run()
+int DSI::CCommEngine::Private::run(Trigger* started)
 {
    TRC_SCOPE( dsi_base, CCommEngine, global );
    DBG_MSG(( "CCommEngine::run()" ));
 
+   Private* previous = sCurrent;
+   sCurrent = this;
+
+   if (mWakeupFd >= 0)
+   {
+      LockGuard<> guard(mDrainLock);
+      mLooping = true;
+   }
+
+   if (started)
+      (void)started->signal();
+
    int retval = -1 ;
    if (!mLocalAcceptor)
    {
@@ -490,9 +867,12 @@ int DSI::CCommEngine::Private::run()
          {
             mSenderTid = gettid();
 
-            // Servicebroker registration for servers and clients
-            std::for_each(mServerList.begin(), mServerList.end(), std::tr1::bind(
-                             &CCommEngine::Private::registerInterface, this, _1));
+            // Servicebroker registration for servers (batched) and clients
+            // the tcp acceptor is only started if necessary
+            const bool tcp = std::find_if(mServerList.begin(), mServerList.end(), std::tr1::bind(
+                                             &CServer::isTCPIPEnabled, _1)) != mServerList.end();
+
+            CServer::registerInterfaces(mServerList, mLocalAcceptor.fd(), DSI::getLocalIpAddress(), tcp ? getIPPort() : 0);
             std::for_each(mClientList.begin(), mClientList.end(), std::tr1::bind(
                              &CClient::setServerAvailableNotification, _1, mSBNotifyChid));
 
@@ -519,6 +899,16 @@ int DSI::CCommEngine::Private::run()
          DBG_ERROR(( "Error creating the communication engine" ));
    }
 
+   if (mWakeupFd >= 0)
+   {
+      // foreign threads run their tasks themselves from now on
+      LockGuard<> guard(mDrainLock);
+      mLooping = false;
+
+      processInbox();
+   }
+
+   sCurrent = previous;
    return retval;
 }
 
@@ -541,8 +931,9 @@ void DSI::CCommEngine::Private::startTCP()
       ec = mTCPAcceptor.open();
       assert(ec == io::ok);
 
+      // only one shard can bind to the configured port
       const char* port = ::getenv("DSI_COMMENGINE_PORT");
-      if (port)
+      if (port && this == &mPrimary)
       {
          int iport = ::atoi(port);
          assert(iport > 0 && iport < 65536);
@@ -569,6 +960,7 @@ int DSI::CCommEngine::Private::loop()
 
    try
    {
+      CCorkScope corks(mDispatch);
       return mDispatch.run();
    }
    catch (abi::__forced_unwind&)
@@ -597,7 +989,7 @@ bool DSI::CCommEngine::Private::handleMessage(const DSI::MessageHeader& hdr, std
 {
    TRC_SCOPE( dsi_base, CCommEngine, handleMessage );
 
-   CRequestReader reader(hdr, *chnl);
+   CRequestReader reader(hdr, *chnl, mReceivePool);
    bool rc = false;
 
    DBG_MSG(( "CCommEngine::handleMessage() %s c:<%d.%d> s:<%d.%d>"
@@ -627,7 +1019,7 @@ bool DSI::CCommEngine::Private::handleMessage(const DSI::MessageHeader& hdr, std
                     , DSI_PROTOCOL_VERSION_MAJOR, DSI_PROTOCOL_VERSION_MINOR
                     , hdr.protoMajor, hdr.protoMinor, hdr.cmd ));
       }
-      rc = reader.receiveAll();
+      rc = reader.receiveAll(findTraceInterface(hdr));
 
       if (rc)
       {
@@ -745,6 +1137,24 @@ bool DSI::CCommEngine::Private::handleMessage(const DSI::MessageHeader& hdr, std
             }
             break;
 
+            case DSI::ShmSetupRequest:
+            {
+               CShmChannel* shm = dynamic_cast<CShmChannel*>(chnl.get());
+
+               if (shm && hdr.packetLength == sizeof(DSI::ShmSetupInfo))
+                  rc = shm->handleSetupRequest(*(const DSI::ShmSetupInfo*)reader.buffer());
+            }
+            break;
+
+            case DSI::ShmSetupResponse:
+            {
+               CShmChannel* shm = dynamic_cast<CShmChannel*>(chnl.get());
+
+               if (shm && hdr.packetLength == sizeof(DSI::ShmSetupInfo))
+                  shm->handleSetupResponse(*(const DSI::ShmSetupInfo*)reader.buffer());
+            }
+            break;
+
             default:
                break;
          }
@@ -879,6 +1289,36 @@ DSI::CClient* DSI::CCommEngine::Private::findClient( const SPartyID& clientID )
 }
 
 
+const SFNDInterfaceDescription* DSI::CCommEngine::Private::findTraceInterface( const DSI::MessageHeader& hdr )
+{
+   if (CTraceManager::isEnabled())
+   {
+      switch(hdr.cmd)
+      {
+         case DSI::ConnectRequest:
+         case DSI::DisconnectRequest:
+         case DSI::DataRequest:
+         {
+            CServer* server = findServer(hdr.serverID);
+            return server ? &server->mIfDescription : 0;
+         }
+
+         case DSI::ConnectResponse:
+         case DSI::DataResponse:
+         {
+            CClient* client = findClient(hdr.clientID);
+            return client ? &client->mIfDescription : 0;
+         }
+
+         default:
+            break;
+      }
+   }
+
+   return 0;
+}
+
+
 DSI::CClient* DSI::CCommEngine::Private::findClient( int32_t id )
 {
    clientlist_type::iterator iter = std::find_if(mClientList.begin(), mClientList.end(), FindById(id));
@@ -896,8 +1336,11 @@ DSI::CServer* DSI::CCommEngine::Private::findServer( int32_t id )
 // ----------------------------------------------------------------------------------------
 
 
-DSI::CCommEngine::CCommEngine()
-   : d(new CCommEngine::Private())
+__thread DSI::CCommEngine::Private* DSI::CCommEngine::Private::sCurrent = 0;
+
+
+DSI::CCommEngine::CCommEngine(unsigned int shards)
+   : d(new CCommEngine::Private(std::max(shards, 1u)))
 {
    // NOOP
 }
@@ -909,25 +1352,77 @@ DSI::CCommEngine::~CCommEngine()
 }
 
 
+DSI::CCommEngine::Private* DSI::CCommEngine::current() const
+{
+   Private* rc = Private::sCurrent;
+   return (rc && &rc->mPrimary == d) ? rc : d;
+}
+
+
+unsigned int DSI::CCommEngine::getShardCount() const
+{
+   return d->mShards.size();
+}
+
+
 int32_t DSI::CCommEngine::getNotificationSocketChid()
 {
-   return d->mSBNotifyChid;
+   return current()->mSBNotifyChid;
 }
 
 
 int DSI::CCommEngine::run()
 {
-   return d->run();
+   if (d->mShards.size() == 1)
+      return d->run();
+
+   std::vector<Thread*> threads;
+   Trigger started;
+
+   if (d->mWakeupFd >= 0)
+   {
+      // the other shards may already stop us before our event loop is entered, so queue such
+      // requests instead of letting them hit the dispatcher right before it resets its exit condition
+      LockGuard<> guard(d->mDrainLock);
+      d->mLooping = true;
+   }
+
+   for (size_t i=1; i<d->mShards.size(); ++i)
+   {
+      threads.push_back(new Thread(std::tr1::bind(&Private::run, d->mShards[i], &started)));
+
+      // a stop request must not reach a shard before its event loop is running
+      while(!started.timed_wait(1000))
+         ;
+   }
+
+   int rc = d->run();
+
+   for (size_t i=1; i<d->mShards.size(); ++i)
+      d->mShards[i]->execute(std::tr1::bind(&Private::stop, d->mShards[i], rc));
+
+   // joins the threads
+   for (size_t i=0; i<threads.size(); ++i)
+      delete threads[i];
+
+   return rc;
 }
 
 
 void DSI::CCommEngine::stop(int exitcode)
 {
-   d->stop(exitcode);
+   // the other shards are stopped by run()
+   d->execute(std::tr1::bind(&Private::stop, d, exitcode));
 }
 
 
-bool DSI::CCommEngine::add( CClient &client )
+void DSI::CCommEngine::post(const std::tr1::function<void()>& task, unsigned int shard)
+{
+   d->mShards[shard % d->mShards.size()]->post(task);
+}
+
+
+bool DSI::CCommEngine::add( CClient &client, int shard_ )
 {
    TRC_SCOPE( dsi_base, CCommEngine, global );
    DBG_MSG(("CCommEngine::add() client %s %d.%d", client.mIfDescription.name,
@@ -936,7 +1431,9 @@ bool DSI::CCommEngine::add( CClient &client )
    if( !client.mCommEngine )
    {
       client.mCommEngine = this ;
-      d->add(client);
+
+      Private* shard = d->assign(&client, shard_);
+      shard->execute(std::tr1::bind(static_cast<void(Private::*)(CClient&)>(&Private::add), shard, ref(client)));
 
       return true ;
    }
@@ -953,7 +1450,9 @@ bool DSI::CCommEngine::remove( CClient &client )
 
    if (this == client.mCommEngine)
    {
-      d->remove(client);
+      Private* shard = d->release(&client);
+      shard->call(std::tr1::bind(static_cast<void(Private::*)(CClient&)>(&Private::remove), shard, ref(client)));
+
       client.mCommEngine = 0 ;
 
       return true ;
@@ -963,7 +1462,7 @@ bool DSI::CCommEngine::remove( CClient &client )
 }
 
 
-bool DSI::CCommEngine::add( CServer &server )
+bool DSI::CCommEngine::add( CServer &server, int shard_ )
 {
    TRC_SCOPE( dsi_base, CCommEngine, global );
    DBG_MSG(("CCommEngine::add() server %s %d.%d", server.mIfDescription.name,
@@ -972,7 +1471,9 @@ bool DSI::CCommEngine::add( CServer &server )
    if (!server.mCommEngine)
    {
       server.mCommEngine = this ;
-      d->add(server);
+
+      Private* shard = d->assign(&server, shard_);
+      shard->execute(std::tr1::bind(static_cast<void(Private::*)(CServer&)>(&Private::add), shard, ref(server)));
 
       return true ;
    }
@@ -989,7 +1490,9 @@ bool DSI::CCommEngine::remove( CServer &server )
 
    if (this == server.mCommEngine)
    {
-      d->remove(server);
+      Private* shard = d->release(&server);
+      shard->call(std::tr1::bind(static_cast<void(Private::*)(CServer&)>(&Private::remove), shard, ref(server)));
+
       server.mCommEngine = 0 ;
 
       return true ;
@@ -1001,13 +1504,13 @@ bool DSI::CCommEngine::remove( CServer &server )
 
 int32_t DSI::CCommEngine::getLocalChannel()
 {
-   return d->mLocalChid;
+   return current()->mLocalChid;
 }
 
 
 int32_t DSI::CCommEngine::getIPPort()
 {
-   return d->getIPPort();
+   return current()->getIPPort();
 }
 
 
@@ -1016,6 +1519,7 @@ std::tr1::shared_ptr<DSI::CChannel> DSI::CCommEngine::attach(int32_t pid, int32_
    TRC_SCOPE( dsi_base, CCommEngine, global );
 
    std::tr1::shared_ptr<CChannel> rc;
+   Private* d = current();
 
    char buf[32];
    Unix::Endpoint ep(makeLocalPath(buf, sizeof(buf), pid, chid));
@@ -1056,6 +1560,7 @@ std::tr1::shared_ptr<DSI::CChannel> DSI::CCommEngine::attachTCP(uint32_t host, u
    TRC_SCOPE( dsi_base, CCommEngine, global );
 
    std::tr1::shared_ptr<CChannel> rc;
+   Private* d = current();
 
    IPv4::Endpoint ep(host, port);
    char buf[24];
@@ -1093,7 +1598,12 @@ std::tr1::shared_ptr<DSI::CChannel> DSI::CCommEngine::attachTCP(uint32_t host, u
             if (getTimeoutMs<Send>() > 0)
                sock.setSocketOption(SocketSendTimeoutOption(getTimeoutMs<Send>()));
 
-            rc.reset(new CTCPChannel(sock));
+            // the connect request must not outlive the send timeout
+            CTCPChannel* chnl = new CTCPChannel(sock);
+            chnl->setSynchronous(true);
+
+            // not cached, the owner hands in the counters, see releasePrivateChannel()
+            rc.reset(chnl);
          }
       }
       else
@@ -1104,21 +1614,66 @@ std::tr1::shared_ptr<DSI::CChannel> DSI::CCommEngine::attachTCP(uint32_t host, u
 }
 
 
+void DSI::CCommEngine::releasePrivateChannel(const CChannel& chnl)
+{
+   // the counters are only updated from within the shard's loop
+   Private* p = current();
+   p->execute(std::tr1::bind(&Private::addClosedStatistics, p, chnl.getTransportStatistics(), chnl.getSendQueueStatistics()));
+}
+
+
 void DSI::CCommEngine::removeGenericDevice(int fd)
 {
    d->mDispatch.removeAll(fd);
 }
 
 
+void DSI::CCommEngine::setSendQueueConfig(const SendQueueConfig& config)
+{
+   for (size_t i=0; i<d->mShards.size(); ++i)
+      d->mShards[i]->execute(std::tr1::bind(&Private::setSendQueueConfig, d->mShards[i], config));
+}
+
+
+DSI::SendQueueStatistics DSI::CCommEngine::getSendQueueStatistics() const
+{
+   SendQueueStatistics stats;
+   ::memset(&stats, 0, sizeof(stats));
+
+   for (size_t i=0; i<d->mShards.size(); ++i)
+      d->mShards[i]->call(std::tr1::bind(&Private::getSendQueueStatistics, d->mShards[i], ref(stats)));
+
+   return stats;
+}
+
+
+DSI::CommEngineStatistics DSI::CCommEngine::getStatistics() const
+{
+   CommEngineStatistics stats;
+   ::memset(&stats, 0, sizeof(stats));
+
+   for (size_t i=0; i<d->mShards.size(); ++i)
+      d->mShards[i]->call(std::tr1::bind(&Private::getStatistics, d->mShards[i], ref(stats)));
+
+   return stats;
+}
+
+
 DSI::CClient* DSI::CCommEngine::findClient(int32_t id)
 {
-   return d->findClient(id);
+   return current()->findClient(id);
 }
 
 
 DSI::CServer* DSI::CCommEngine::findServer(int32_t id)
 {
-   return d->findServer(id);
+   return current()->findServer(id);
+}
+
+
+DSI::CServicebrokerConnection& DSI::CCommEngine::getServicebroker()
+{
+   return current()->mServicebroker;
 }
 
 
@@ -35,6 +35,13 @@ namespace DSI
       {
          return mInfo;
       }
+
+      /// @return the maximum frame size announced by the peer, 0 for legacy peers.
+      inline
+      uint32_t getMaxFrameSize() const
+      {
+         return uint32_t(header().reserved[0]);
+      }
             
    private:
 
@@ -59,6 +66,13 @@ namespace DSI
       {
          return mInfo;
       }
+
+      /// @return the maximum frame size announced by the peer, 0 for legacy peers.
+      inline
+      uint32_t getMaxFrameSize() const
+      {
+         return uint32_t(header().reserved[0]);
+      }
       
       /// Explicitely cast the channel to TCP.
       inline
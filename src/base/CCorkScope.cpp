@@ -0,0 +1,71 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CCorkScope.hpp"
+
+#include <algorithm>
+
+
+__thread DSI::CCorkScope* DSI::CCorkScope::sCurrent = 0;
+
+
+DSI::CCorkScope::CCorkScope(Dispatcher& dispatcher)
+ : mDispatcher(dispatcher)
+ , mPrevious(sCurrent)
+{
+   sCurrent = this;
+   mDispatcher.setRoundHandler(std::tr1::bind(&CCorkScope::flush, this));
+}
+
+
+DSI::CCorkScope::~CCorkScope()
+{
+   mDispatcher.setRoundHandler(std::tr1::function<void()>());
+   flush();
+
+   sCurrent = mPrevious;
+}
+
+
+void DSI::CCorkScope::flush()
+{
+   // uncorking must not see the channels of the next round
+   std::vector<CChannel*> channels;
+   channels.swap(mChannels);
+
+   for (std::vector<CChannel*>::iterator iter = channels.begin(); iter != channels.end(); ++iter)
+   {
+      (*iter)->mCorkScope = 0;
+      (*iter)->uncork();
+   }
+
+   // keep the capacity for the next round
+   channels.clear();
+   mChannels.swap(channels);
+}
+
+
+void DSI::CCorkScope::cork(CChannel& chnl)
+{
+   if (sCurrent && !chnl.mCorkScope)
+   {
+      chnl.mCorkScope = sCurrent;
+      sCurrent->mChannels.push_back(&chnl);
+
+      chnl.cork();
+   }
+}
+
+
+void DSI::CCorkScope::remove(CChannel& chnl)
+{
+   std::vector<CChannel*>::iterator iter = std::find(mChannels.begin(), mChannels.end(), &chnl);
+   if (iter != mChannels.end())
+      mChannels.erase(iter);
+
+   chnl.mCorkScope = 0;
+}
@@ -0,0 +1,78 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CCORKSCOPE_HPP
+#define DSI_BASE_CCORKSCOPE_HPP
+
+
+#include <vector>
+
+#include "dsi/private/CNonCopyable.hpp"
+#include "dsi/CChannel.hpp"
+
+#include "CDispatcher.hpp"
+
+
+namespace DSI
+{
+
+   /**
+    * Coalesces the outgoing data messages of one dispatcher round. Each channel a single frame
+    * data message is written to during the round is corked and uncorked after the round, so all
+    * messages to the same peer go out with a single write. The order of the messages per channel
+    * does not change and their errors were never reported to the writers anyway. Corked data is
+    * subject to the channel's send queue watermarks and is written early beyond a size limit.
+    * Control messages like connect responses and multi fragment messages are not corked, they
+    * are written directly unless they follow corked data.
+    *
+    * The scope is the current one of the constructing thread until its destruction.
+    */
+   class CCorkScope : public Private::CNonCopyable
+   {
+   public:
+
+      /**
+       * Activate the scope for the calling thread, flushing after each round of the given dispatcher.
+       */
+      explicit
+      CCorkScope(Dispatcher& dispatcher);
+
+      /**
+       * Flush and restore the previous scope.
+       */
+      ~CCorkScope();
+
+      /**
+       * Uncork all channels corked within the current round.
+       */
+      void flush();
+
+      /**
+       * Cork the channel until the end of the round if there is an active scope in the calling thread.
+       */
+      static
+      void cork(CChannel& chnl);
+
+      /**
+       * The channel is destroyed, it must not be uncorked any more.
+       */
+      void remove(CChannel& chnl);
+
+   private:
+
+      Dispatcher& mDispatcher;
+      CCorkScope* mPrevious;
+
+      std::vector<CChannel*> mChannels;
+
+      static __thread CCorkScope* sCurrent;
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CCORKSCOPE_HPP
@@ -10,12 +10,17 @@
 
 
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <tr1/functional>
 
 #include "dsi/CServer.hpp"
 #include "dsi/CIStream.hpp"
 #include "dsi/CChannel.hpp"
 
 #include "io.hpp"
+#include "CSendQueue.hpp"
 #include "CClientConnectSM.hpp"
 
 
@@ -54,7 +59,11 @@ namespace DSI
 
       inline
       CBaseChannel(SocketT& sock)
-       : mSock(sock)
+       : mQueue()
+       , mWriteArmed(false)
+       , mSynchronous(false)
+       , mCorked(0)
+       , mSock(sock)
       {
          // NOOP
       }
@@ -62,12 +71,28 @@ namespace DSI
 
       inline
       CBaseChannel(typename SocketT::endpoint_type& ep)
-       : mSock()
+       : mQueue()
+       , mWriteArmed(false)
+       , mSynchronous(false)
+       , mCorked(0)
+       , mSock()
       {
          mSock.open(ep);
       }
 
 
+      ~CBaseChannel()
+      {
+         // last chance for corked data, there is no one left to queue it for
+         if (!mCork.empty() && mSock.is_open())
+         {
+            io::error_code ec = io::ok;
+            iov_t iov = { &mCork[0], mCork.size() };
+            (void)mSock.write_some(&iov, 1, ec);
+         }
+      }
+
+
       bool isOpen() const
       {
          return mSock.is_open();
@@ -76,20 +101,55 @@ namespace DSI
 
       bool sendAll(const void* data, size_t len)
       {
-         io::error_code ec;
-         mSock.write_all(data, len, ec);
-
-         return ec == io::ok;
+         iov_t iov = { const_cast<void*>(data), len };
+         return sendAll(&iov, 1);
       }
 
       bool sendAll(const iov_t* iov, size_t iov_len)
       {
          assert(iov && iov_len);
 
-         io::error_code ec = io::ok;
-         mSock.write_all(iov, iov_len, ec);
+         // nobody would drain the queue
+         if (mSynchronous || !mSock.dispatcher())
+            return sendAllBlocking(iov, iov_len);
+
+         switch(mQueue.admit(iov, iov_len))
+         {
+         case CSendQueue::Drop:
+            return true;
+
+         case CSendQueue::Disconnect:
+            disconnect();
+            return false;
+
+         case CSendQueue::Block:
+            if (!drain())
+               return false;
+            break;
+
+         default:
+            break;
+         }
+
+         // hold back until uncorked, pending data of an earlier congestion goes first anyway
+         if (mCorked && mQueue.empty())
+         {
+            // beyond the limit the copy does not pay off, the corked data goes out along with it
+            if (mCork.size() + io::detail::calculate_total_length(iov, iov_len) > CorkLimit)
+               return flushCork(iov, iov_len);
+
+            for (size_t i=0; i<iov_len; ++i)
+            {
+               const char* base = (const char*)iov[i].iov_base;
+               mCork.insert(mCork.end(), base, base + iov[i].iov_len);
+            }
+
+            // corked data counts against the watermarks like queued data
+            mQueue.hold(io::detail::calculate_total_length(iov, iov_len));
+            return true;
+         }
 
-         return ec == io::ok;
+         return send(iov, iov_len);
       }
 
       bool recvAll(void* buf, size_t len)
@@ -97,9 +157,18 @@ namespace DSI
          assert(buf && len);
 
          io::error_code ec;
-         mSock.read_all(buf, len, ec);
+         const unsigned int calls = mSock.read_all(buf, len, ec);
 
-         return ec == io::ok;
+         mTransportStats.readCalls += calls;
+         mTransportStats.partialReads += calls - 1;
+
+         if (ec == io::ok)
+         {
+            mTransportStats.bytesReceived += len;
+            return true;
+         }
+
+         return false;
       }
             
       void asyncRead(CClientConnectSM* sm)
@@ -107,6 +176,42 @@ namespace DSI
          ConnectRequestReader<SocketT>::eval(mSock, *sm);
       }      
 
+      void setSendQueueConfig(const SendQueueConfig& config)
+      {
+         mQueue.setConfig(config);
+      }
+
+      SendQueueStatistics getSendQueueStatistics() const
+      {
+         return mQueue.statistics();
+      }
+
+      /**
+       * Write all data synchronously and bypass the send queue, so the socket's send timeout applies.
+       * Channels without a dispatcher are always synchronous.
+       */
+      void setSynchronous(bool enable)
+      {
+         mSynchronous = enable;
+      }
+
+      void cork()
+      {
+         ++mCorked;
+      }
+
+      bool uncork()
+      {
+         assert(mCorked > 0);
+
+         bool rc = true;
+
+         if (--mCorked == 0 && !mCork.empty())
+            rc = flushCork(0, 0);
+
+         return rc;
+      }
+
       inline
       typename SocketT::endpoint_type getPeerName()
       {
@@ -121,6 +226,227 @@ namespace DSI
 
    private:
 
+      typedef std::tr1::function<bool(GenericEventBase::Result)> tWriteHandler;
+
+
+      void armWrite()
+      {
+         if (!mWriteArmed && mSock.dispatcher())
+         {
+            mWriteArmed = true;
+            mSock.dispatcher()->enqueueEvent(mSock.fd(), new GenericEvent<tWriteHandler>(
+               std::tr1::bind(&CBaseChannel::handleWrite, this, std::tr1::placeholders::_1)), POLLOUT);
+         }
+      }
+
+
+      /// send the corked data followed by the given one with a single write
+      bool flushCork(const iov_t* iov, size_t iov_len)
+      {
+         std::vector<iov_t> vec;
+         vec.reserve(iov_len + 1);
+
+         if (!mCork.empty())
+         {
+            mQueue.release(mCork.size());
+
+            iov_t cork = { &mCork[0], mCork.size() };
+            vec.push_back(cork);
+         }
+
+         vec.insert(vec.end(), iov, iov + iov_len);
+
+         const bool rc = vec.empty() || send(&vec[0], vec.size());
+
+         // keep the capacity for the next time
+         mCork.clear();
+
+         return rc;
+      }
+
+
+      /// write what is possible without blocking and queue the rest, keeping the order of pending data
+      bool send(const iov_t* iov, size_t iov_len)
+      {
+         size_t total = io::detail::calculate_total_length(iov, iov_len);
+         size_t sent = 0;
+
+         // keep the order, only write directly if nothing is pending
+         if (mQueue.empty())
+         {
+            io::error_code ec = io::ok;
+            ssize_t rc = write(iov, iov_len, ec);
+
+            if (rc > 0)
+            {
+               sent = rc;
+            }
+            else if (rc < 0 && ec != io::would_block && io::getLastError() != EINTR)
+               return false;
+         }
+
+         if (sent < total)
+         {
+            mQueue.push(iov, iov_len, sent);
+            armWrite();
+         }
+
+         return true;
+      }
+
+
+      /// slow consumer with the Block policy: write all pending data, waiting for the peer
+      bool drain()
+      {
+         if (!mCork.empty())
+         {
+            mQueue.release(mCork.size());
+
+            const bool rc = sendAllBlocking(&mCork[0], mCork.size());
+            mCork.clear();
+
+            if (!rc)
+               return false;
+         }
+
+         while (!mQueue.empty())
+         {
+            iov_t iov[16];
+            size_t iov_len = mQueue.fill(iov, sizeof(iov) / sizeof(iov[0]));
+            size_t len = io::detail::calculate_total_length(iov, iov_len);
+
+            if (!sendAllBlocking(iov, iov_len))
+            {
+               // errors are handled by the reading side of the connection
+               mQueue.clear();
+               return false;
+            }
+
+            mQueue.consume(len);
+         }
+
+         return true;
+      }
+
+
+      bool sendAllBlocking(const void* data, size_t len)
+      {
+         iov_t iov = { const_cast<void*>(data), len };
+         return sendAllBlocking(&iov, 1);
+      }
+
+
+      bool sendAllBlocking(const iov_t* iov, size_t iov_len)
+      {
+         // write_all adjusts the vector on partial writes, the caller's one is reused
+         iov_t vec[8];
+         std::vector<iov_t> heap;
+
+         iov_t* copy = vec;
+         if (iov_len > sizeof(vec) / sizeof(vec[0]))
+         {
+            heap.assign(iov, iov + iov_len);
+            copy = &heap[0];
+         }
+         else
+            std::copy(iov, iov + iov_len, vec);
+
+         io::error_code ec = io::ok;
+         mSock.write_all(copy, iov_len, ec);
+
+         ++mTransportStats.writeCalls;
+
+         if (ec == io::ok)
+         {
+            mTransportStats.bytesSent += io::detail::calculate_total_length(iov, iov_len);
+            return true;
+         }
+
+         return false;
+      }
+
+
+      /// counted write_some
+      inline
+      ssize_t write(const iov_t* iov, size_t iov_len, io::error_code& ec)
+      {
+         ssize_t rc = mSock.write_some(iov, iov_len, ec);
+
+         ++mTransportStats.writeCalls;
+         if (rc > 0)
+            mTransportStats.bytesSent += rc;
+
+         return rc;
+      }
+
+
+      /// asynchronous part of sendAll: drain the queue as far as possible
+      bool handleWrite(GenericEventBase::Result result)
+      {
+         if (result == GenericEventBase::CanWriteNow)
+         {
+            while (!mQueue.empty())
+            {
+               iov_t iov[16];
+               size_t iov_len = mQueue.fill(iov, sizeof(iov) / sizeof(iov[0]));
+
+               io::error_code ec = io::ok;
+               ssize_t rc = write(iov, iov_len, ec);
+
+               if (rc > 0)
+               {
+                  mQueue.consume(rc);
+               }
+               else
+               {
+                  // errors are handled by the reading side of the connection
+                  if (rc == 0 || (ec != io::would_block && io::getLastError() != EINTR))
+                     mQueue.clear();
+
+                  break;
+               }
+            }
+         }
+         else
+            mQueue.clear();
+
+         mWriteArmed = !mQueue.empty();
+         return mWriteArmed;
+      }
+
+
+      /// slow consumer: let the reading side detect the end of the connection
+      void disconnect()
+      {
+         if (mWriteArmed)
+         {
+            mSock.cancel_write();
+            mWriteArmed = false;
+         }
+
+         mQueue.clear();
+         mQueue.countDisconnect();
+
+         if (!mCork.empty())
+         {
+            mQueue.release(mCork.size());
+            mCork.clear();
+         }
+
+         (void)mSock.shutdown();
+      }
+
+
+      /// corked bytes at most, larger data is not copied but written along with the corked data
+      enum { CorkLimit = 64 * 1024 };
+
+      CSendQueue mQueue;
+      bool mWriteArmed;
+      bool mSynchronous;          ///< see setSynchronous()
+
+      unsigned int mCorked;       ///< nesting level of cork()
+      std::vector<char> mCork;    ///< data held back while corked
+
       SocketT mSock;
    };
 
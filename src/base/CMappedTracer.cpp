@@ -0,0 +1,259 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "dsi/CMappedTracer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "dsi/Log.hpp"
+
+#include "tracefile.h"
+
+
+TRC_SCOPE_DEF(dsi_base, CMappedTracer, global);
+
+
+namespace /*anonymous*/
+{
+
+   inline
+   uint64_t now(clockid_t clock)
+   {
+      struct timespec ts;
+      (void)::clock_gettime(clock, &ts);
+
+      return 1000000000ULL * ts.tv_sec + ts.tv_nsec;
+   }
+
+
+   inline
+   unsigned int hash(const SFNDInterfaceDescription& iface)
+   {
+      unsigned int h = iface.version.majorVersion * 31 + iface.version.minorVersion;
+
+      for (const char* p = iface.name; *p; ++p)
+         h = h * 31 + (unsigned char)*p;
+
+      return h;
+   }
+
+}   // namespace anonymous
+
+
+// ---------------------------------------------------------------------------------------
+
+
+struct DSI::Trace::CMappedTracer::Private
+{
+   Private(const char* path, unsigned int records, unsigned int payloadSize);
+
+   ~Private();
+
+   int intern(const SFNDInterfaceDescription& iface);
+
+   dsi_tracefile_record_t* claim(uint64_t& position);
+
+   const unsigned int mPayloadSize;
+
+   void* mBase;
+   size_t mSize;
+
+   dsi_tracefile_header_t* mHeader;
+   char* mRecords;
+};
+
+
+DSI::Trace::CMappedTracer::Private::Private(const char* path, unsigned int records, unsigned int payloadSize)
+ : mPayloadSize(payloadSize)
+ , mBase(MAP_FAILED)
+ , mSize(0)
+ , mHeader(0)
+ , mRecords(0)
+{
+   TRC_SCOPE(dsi_base, CMappedTracer, global);
+
+   const size_t recordSize = (sizeof(dsi_tracefile_record_t) + payloadSize + 7) & ~7;
+
+   int fd = ::open(path, O_RDWR|O_CREAT|O_TRUNC, 0644);
+   if (fd >= 0)
+   {
+      mSize = DSI_TRACEFILE_RECORDS_OFFSET + recordSize * records;
+
+      if (records > 0 && ::ftruncate(fd, mSize) == 0)
+         mBase = ::mmap(0, mSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+
+      while(::close(fd) < 0 && errno == EINTR);
+   }
+
+   if (mBase != MAP_FAILED)
+   {
+      // the file is zero filled, so all interfaces and records are still unused
+      mHeader = static_cast<dsi_tracefile_header_t*>(mBase);
+      mRecords = static_cast<char*>(mBase) + DSI_TRACEFILE_RECORDS_OFFSET;
+
+      mHeader->version = DSI_TRACEFILE_VERSION;
+      mHeader->recordSize = recordSize;
+      mHeader->recordCount = records;
+      mHeader->startRealtime = now(CLOCK_REALTIME);
+      mHeader->startMonotonic = now(CLOCK_MONOTONIC);
+      mHeader->pid = ::getpid();
+
+      // the magic marks a complete header
+      __sync_synchronize();
+      mHeader->magic = DSI_TRACEFILE_MAGIC;
+   }
+   else
+      DBG_ERROR(("CMappedTracer: cannot map trace file '%s': errno=%d", path, errno));
+}
+
+
+DSI::Trace::CMappedTracer::Private::~Private()
+{
+   if (mBase != MAP_FAILED)
+      (void)::munmap(mBase, mSize);
+}
+
+
+int DSI::Trace::CMappedTracer::Private::intern(const SFNDInterfaceDescription& iface)
+{
+   const unsigned int start = hash(iface);
+
+   for (unsigned int i=0; i<DSI_TRACEFILE_MAX_INTERFACES; ++i)
+   {
+      dsi_tracefile_interface_t& entry = mHeader->interfaces[(start + i) % DSI_TRACEFILE_MAX_INTERFACES];
+
+      if (entry.state == 0 && __sync_bool_compare_and_swap(&entry.state, 0, 1))
+      {
+         entry.majorVersion = iface.version.majorVersion;
+         entry.minorVersion = iface.version.minorVersion;
+         ::strncpy(entry.name, iface.name, sizeof(entry.name) - 1);
+
+         __sync_synchronize();
+         entry.state = 2;
+      }
+      else
+      {
+         // another thread is just claiming this entry
+         while(entry.state == 1)
+            (void)::sched_yield();
+
+         __sync_synchronize();
+      }
+
+      if (entry.majorVersion == iface.version.majorVersion
+          && entry.minorVersion == iface.version.minorVersion
+          && ::strncmp(entry.name, iface.name, sizeof(entry.name) - 1) == 0)
+      {
+         return &entry - mHeader->interfaces;
+      }
+   }
+
+   return -1;
+}
+
+
+dsi_tracefile_record_t* DSI::Trace::CMappedTracer::Private::claim(uint64_t& position)
+{
+   position = __sync_fetch_and_add(&mHeader->next, 1);
+
+   dsi_tracefile_record_t* rec = reinterpret_cast<dsi_tracefile_record_t*>(
+      mRecords + (position % mHeader->recordCount) * mHeader->recordSize);
+
+   // invalidate the slot while it is written
+   rec->position = 0;
+   __sync_synchronize();
+
+   return rec;
+}
+
+
+// ---------------------------------------------------------------------------------------
+
+
+DSI::Trace::CMappedTracer::CMappedTracer(const char* path, unsigned int records, unsigned int payloadSize)
+ : d(new Private(path, records, payloadSize))
+{
+   // NOOP
+}
+
+
+DSI::Trace::CMappedTracer::~CMappedTracer()
+{
+   delete d;
+}
+
+
+int DSI::Trace::CMappedTracer::open(const SFNDInterfaceDescription& iface, DSI::Trace::Direction dir, uint32_t /*updateId*/)
+{
+   if (!d->mHeader)
+      return -1;
+
+   int index = d->intern(iface);
+   return index < 0 ? -1 : (index << 1) | (dir == DSI::Trace::In ? 0 : 1);
+}
+
+
+void DSI::Trace::CMappedTracer::close(int /*handle*/)
+{
+   // NOOP, the interfaces stay in the file
+}
+
+
+bool DSI::Trace::CMappedTracer::isActive(int /*handle*/)
+{
+   return true;
+}
+
+
+bool DSI::Trace::CMappedTracer::isPayloadEnabled(int /*handle*/)
+{
+   return d->mPayloadSize > 0;
+}
+
+
+void DSI::Trace::CMappedTracer::write(int handle, const DSI::MessageHeader* hdr, const DSI::EventInfo* info, const void* payload, size_t len)
+{
+   assert(hdr);
+   assert(handle >= 0 && d->mHeader);
+
+   uint64_t position;
+   dsi_tracefile_record_t* rec = d->claim(position);
+
+   rec->timestamp = now(CLOCK_MONOTONIC);
+   rec->serverID = hdr->serverID.globalID;
+   rec->clientID = hdr->clientID.globalID;
+   rec->cmd = hdr->cmd;
+   rec->flags = hdr->flags;
+   rec->packetLength = hdr->packetLength;
+
+   rec->iface = handle >> 1;
+   rec->direction = (handle & 1) ? DSI::Trace::Out : DSI::Trace::In;
+   rec->hasInfo = info != 0;
+
+   if (info)
+   {
+      rec->requestID = info->requestID;
+      rec->sequenceNumber = info->sequenceNumber;
+      rec->type = info->requestType;
+   }
+
+   rec->payloadLength = payload ? std::min(len, (size_t)d->mPayloadSize) : 0;
+   if (rec->payloadLength)
+      ::memcpy(rec + 1, payload, rec->payloadLength);
+
+   // publish the record
+   __sync_synchronize();
+   rec->position = position + 1;
+}
@@ -0,0 +1,72 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CReceiveBufferPool.hpp"
+
+#include <cstdlib>
+
+
+DSI::CReceiveBufferPool::CReceiveBufferPool()
+{
+   size_t capacity = MaxPooledCapacity;
+   mFree.resize(sizeClass(capacity) + 1);
+}
+
+
+DSI::CReceiveBufferPool::~CReceiveBufferPool()
+{
+   for (size_t i=0; i<mFree.size(); ++i)
+   {
+      for (size_t j=0; j<mFree[i].size(); ++j)
+         ::free(mFree[i][j]);
+   }
+}
+
+
+size_t DSI::CReceiveBufferPool::sizeClass(size_t& capacity)
+{
+   size_t idx = 0;
+   size_t rc = MinCapacity;
+
+   while(rc < capacity)
+   {
+      rc <<= 1;
+      ++idx;
+   }
+
+   capacity = rc;
+   return idx;
+}
+
+
+char* DSI::CReceiveBufferPool::acquire(size_t& capacity)
+{
+   size_t idx = sizeClass(capacity);
+
+   if (idx < mFree.size() && !mFree[idx].empty())
+   {
+      char* buf = mFree[idx].back();
+      mFree[idx].pop_back();
+
+      return buf;
+   }
+
+   return (char*)::malloc(capacity);
+}
+
+
+void DSI::CReceiveBufferPool::release(char* buf, size_t capacity)
+{
+   size_t idx = sizeClass(capacity);
+
+   if (idx < mFree.size() && mFree[idx].size() < MaxBuffersPerClass)
+   {
+      mFree[idx].push_back(buf);
+   }
+   else
+      ::free(buf);
+}
@@ -0,0 +1,69 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CRECEIVEBUFFERPOOL_HPP
+#define DSI_BASE_CRECEIVEBUFFERPOOL_HPP
+
+
+#include <vector>
+#include <cstddef>
+
+#include "dsi/private/CNonCopyable.hpp"
+
+
+namespace DSI
+{
+   /**
+    * Recycles the buffers for multi-fragment messages received by a communication engine.
+    * Buffers are handed out in size classes of powers of two, starting at @c MinCapacity.
+    * Buffers larger than @c MaxPooledCapacity are allocated and freed directly.
+    *
+    * The pool is not thread-safe, it must only be used from the thread running the engine.
+    */
+   class CReceiveBufferPool : public Private::CNonCopyable
+   {
+   public:
+
+      enum
+      {
+         MinCapacity = 8 * 1024,
+         MaxPooledCapacity = 1024 * 1024,
+         MaxBuffersPerClass = 4
+      };
+
+      CReceiveBufferPool();
+
+      ~CReceiveBufferPool();
+
+      /**
+       * Get a buffer with at least the given capacity.
+       *
+       * @param capacity in: the wanted capacity, out: the actual capacity of the buffer.
+       *
+       * @return the buffer or 0 if out of memory.
+       */
+      char* acquire(size_t& capacity);
+
+      /**
+       * Give a buffer formerly acquired from this pool back.
+       *
+       * @param capacity the actual capacity as returned by acquire.
+       */
+      void release(char* buf, size_t capacity);
+
+   private:
+
+      /// @return the size class index for the given capacity, the capacity is rounded up.
+      static size_t sizeClass(size_t& capacity);
+
+      std::vector<std::vector<char*> > mFree;
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CRECEIVEBUFFERPOOL_HPP
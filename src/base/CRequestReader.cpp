@@ -8,12 +8,14 @@
 #include "CRequestReader.hpp"
 
 #include <errno.h>
+#include <cstring>
 
 #include "dsi/CChannel.hpp"
 #include "dsi/Streaming.hpp"
 #include "dsi/Log.hpp"
 
 #include "CTraceManager.hpp"
+#include "CReceiveBufferPool.hpp"
 #include "DSI.hpp"
 
 
@@ -56,21 +58,77 @@ private:
 // ------------------------------------------------------------------------------------------------
 
 
-bool DSI::CRequestReader::receiveAll()
+DSI::CRequestReader::~CRequestReader()
+{
+   if (mBuf != mBuffer)
+      mPool.release(mBuf, mCapacity);
+}
+
+
+bool DSI::CRequestReader::reserve(size_t capacity)
+{
+   if (capacity > mCapacity)
+   {
+      char* buf = mPool.acquire(capacity);
+      if (!buf)
+         return false;
+
+      ::memcpy(buf, mBuf, mSize);
+
+      if (mBuf != mBuffer)
+         mPool.release(mBuf, mCapacity);
+
+      mBuf = buf;
+      mCapacity = capacity;
+   }
+
+   return true;
+}
+
+
+bool DSI::CRequestReader::recvPayload(const MessageHeader& hdr)
+{
+   if (hdr.flags & DSI_SHARED_DATA_FLAG)
+      return mChnl.recvShared(mBuf + mSize, hdr.packetLength, uint32_t(hdr.reserved[0]));
+
+   return mChnl.recvAll(mBuf + mSize, hdr.packetLength);
+}
+
+
+bool DSI::CRequestReader::receiveAll(const SFNDInterfaceDescription* iface)
 {
    TRC_SCOPE(dsi_base, CRequestReader, receiveAll);
 
    bool rc = true;
    errno = EINVAL;
       
-   if (mCurrent->packetLength > 0)
+   if (mCurrent->packetLength > getMaxFrameSize() - sizeof(MessageHeader))
    {
-      if (mBuf.setCapacity(mBuf.size() + mCurrent->packetLength))
+      DBG_ERROR(("CRequestReader: frame too large (%d bytes)", mCurrent->packetLength));
+      errno = EMSGSIZE;
+      rc = false;
+   }
+   else if (mCurrent->packetLength > 0)
+   {
+      // the total length is announced by the sender in the first fragment (if supported)
+      size_t announced = 0;
+      if ((mCurrent->flags & (DSI_MORE_DATA_FLAG|DSI_SHARED_DATA_FLAG)) == DSI_MORE_DATA_FLAG
+         && uint32_t(mCurrent->reserved[0]) > mCurrent->packetLength)
+         announced = uint32_t(mCurrent->reserved[0]);
+
+      const size_t capacity = announced ? announced : mCurrent->packetLength;
+
+      if (capacity > getMaxMessageSize())
+      {
+         DBG_ERROR(("CRequestReader: message too large (%d bytes announced)", capacity));
+         errno = EMSGSIZE;
+         rc = false;
+      }
+      else if (reserve(capacity))
       {
-         SFNDInterfaceDescription iface;         
          uint32_t requestId = 0;
 
-         if (!mChnl.recvAll(mBuf.pptr(), mCurrent->packetLength))
+         if (!recvPayload(*mCurrent))
          {
             CErrnoSafe e;
             DBG_ERROR(( "CRequestReader: receiving payload failed: errno=%d", e.error() ));
@@ -78,39 +136,53 @@ bool DSI::CRequestReader::receiveAll()
          }
          else
          {            
-            if (CTraceManager::resolve(mCurrent->serverID, mCurrent->clientID, iface))            
+            if (iface)
             {
-               requestId = reinterpret_cast<const EventInfo*>(mBuf.gptr())->requestID;
+               requestId = reinterpret_cast<const EventInfo*>(mBuf)->requestID;
                
-               CInputTraceSession session(iface, requestId);
+               CInputTraceSession session(*iface, requestId);
                if (session.isActive()) 
                {         
-                  session.write(mCurrent, (const EventInfo*)mBuf.gptr(), mBuf.gptr() + sizeof(EventInfo), mCurrent->packetLength - sizeof(EventInfo));
+                  session.write(mCurrent, (const EventInfo*)mBuf, mBuf + sizeof(EventInfo), mCurrent->packetLength - sizeof(EventInfo));
                }
                else
                   requestId = 0;
             }
 
-            mBuf.pbump(mCurrent->packetLength);
+            mSize += mCurrent->packetLength;
          }
 
          while((mCurrent->flags & DSI_MORE_DATA_FLAG) && rc)
          {
             if (mChnl.recvAll(&mHdr, sizeof(mHdr)))
             {
-               if (mHdr.packetLength > 0)
+               if (mHdr.packetLength > getMaxFrameSize() - sizeof(MessageHeader))
                {
-                  if (!mBuf.setCapacity(mBuf.size() + mHdr.packetLength))
+                  DBG_ERROR(("CRequestReader: frame too large (%d bytes)", mHdr.packetLength));
+                  errno = EMSGSIZE;
+                  rc = false;
+               }
+               else if ((announced && mSize + mHdr.packetLength > announced)
+                  || mSize + mHdr.packetLength > getMaxMessageSize())
+               {
+                  DBG_ERROR(("CRequestReader: message exceeds its announced or the maximum size (%d bytes)", mSize + mHdr.packetLength));
+                  errno = EMSGSIZE;
+                  rc = false;
+               }
+               else if (mHdr.packetLength > 0)
+               {
+                  if (!reserve(mSize + mHdr.packetLength))
                   {
-                     DBG_ERROR(("CRequestReader: out of Memory (capacity :%d)", mBuf.size() + mHdr.packetLength));
+                     DBG_ERROR(("CRequestReader: out of Memory (capacity :%d)", mSize + mHdr.packetLength));
                      errno = ENOMEM;
                      rc = false;
                   }
                   else
                   {
                      mCurrent = &mHdr;
+                     ++mChnl.mTransportStats.fragmentsReassembled;
 
-                     if (!mChnl.recvAll(mBuf.pptr(), mHdr.packetLength))
+                     if (!recvPayload(mHdr))
                      {
                         CErrnoSafe e;
                         DBG_ERROR(("CRequestReader: receiving payload failed: errno=%d", e.error()));
@@ -120,14 +192,14 @@ bool DSI::CRequestReader::receiveAll()
                      {             
                         if (requestId != 0)            
                         {
-                           CInputTraceSession session(iface, requestId);
+                           CInputTraceSession session(*iface, requestId);
                            if (session.isPayloadEnabled()) 
                            {                                       
-                              session.write(mCurrent, 0, mBuf.pptr(), mHdr.packetLength);                     
+                              session.write(mCurrent, 0, mBuf + mSize, mHdr.packetLength);                     
                            }
                         }
                         
-                        mBuf.pbump(mHdr.packetLength);
+                        mSize += mHdr.packetLength;
                      }
                   }
                }
@@ -139,10 +211,17 @@ bool DSI::CRequestReader::receiveAll()
                rc = false;
             }
          }
+
+         if (rc && announced && mSize != announced)
+         {
+            DBG_ERROR(("CRequestReader: message shorter than announced (%d of %d bytes)", mSize, announced));
+            errno = EPROTO;
+            rc = false;
+         }
       }
       else
       {
-         DBG_ERROR(("CRequestReader: out of Memory (capacity :%d)", mBuf.size() + mHdr.packetLength));
+         DBG_ERROR(("CRequestReader: out of Memory (capacity :%d)", capacity));
          errno = ENOMEM;
          rc = false;
       }
@@ -10,45 +10,70 @@
 
 
 #include "dsi/DSI.hpp"
-#include "dsi/private/CBuffer.hpp"
+#include "dsi/CChannel.hpp"
+#include "dsi/private/CNonCopyable.hpp"
 
 namespace DSI
 {
 
-   class CChannel;
+   class CReceiveBufferPool;
 
 
-   /// scatter gather reader for reading complete DSI requests
-   class CRequestReader
+   /**
+    * Scatter gather reader for reading complete DSI requests. Single fragment messages
+    * are received into the reader object itself, multi-fragment messages into a buffer
+    * of the given pool. The buffer is allocated once if the sender announces the total
+    * message length in the first fragment.
+    */
+   class CRequestReader : public Private::CNonCopyable
    {
    public:
 
-      CRequestReader(const DSI::MessageHeader& hdr, CChannel& chnl);
+      CRequestReader(const DSI::MessageHeader& hdr, CChannel& chnl, CReceiveBufferPool& pool);
 
-      /// receive all data for this request
-      bool receiveAll();
+      ~CRequestReader();
+
+      /**
+       * Receive all data for this request.
+       *
+       * @param iface Interface of the receiving client or server if the request should be traced.
+       */
+      bool receiveAll(const SFNDInterfaceDescription* iface = 0);
 
       /// pointer to first byte after MessageHeader
       inline
       const char* buffer() const
       {
-         return mBuf.gptr();
+         return mBuf;
       }
 
       /// complete request size (including EventInfo and data payload)
       inline
       size_t size() const
       {
-         return mBuf.size();
+         return mSize;
       }
 
    private:
 
+      /// make sure the buffer can hold at least @c capacity bytes
+      bool reserve(size_t capacity);
+
+      /// receive the payload of the given packet from the socket or the shared memory ring
+      bool recvPayload(const MessageHeader& hdr);
+
       DSI::MessageHeader* mCurrent;
       CChannel& mChnl;
+      CReceiveBufferPool& mPool;
+
+      char* mBuf;                   ///< buffer for payload data
+      size_t mSize;
+      size_t mCapacity;
 
-      Private::CBuffer mBuf;                  ///< buffer for payload data
       DSI::MessageHeader mHdr;      ///< temporary buffer for multi-frame messages
+
+      // buffer for single fragment messages
+      char mBuffer[DSI_PAYLOAD_SIZE] __attribute__((aligned(8)));
    };
 
 
@@ -56,11 +81,18 @@ namespace DSI
 
 
    inline
-   CRequestReader::CRequestReader(const DSI::MessageHeader& hdr, CChannel& chnl)
+   CRequestReader::CRequestReader(const DSI::MessageHeader& hdr, CChannel& chnl, CReceiveBufferPool& pool)
       : mCurrent(const_cast<DSI::MessageHeader*>(&hdr))
       , mChnl(chnl)
+      , mPool(pool)
+      , mBuf(mBuffer)
+      , mSize(0)
+      , mCapacity(sizeof(mBuffer))
    {
-      // NOOP
+      // the header was read asynchronously by the dispatcher
+      ++mChnl.mTransportStats.messagesReceived;
+      ++mChnl.mTransportStats.readCalls;
+      mChnl.mTransportStats.bytesReceived += sizeof(hdr);
    }
 }//namespace DSI
 
@@ -11,6 +11,7 @@
 
 #include "CTraceManager.hpp"
 #include "CDummyChannel.hpp"
+#include "CCorkScope.hpp"
 #include "DSI.hpp"
 
 #include <cassert>
@@ -27,6 +28,7 @@ DSI::CRequestWriter::CRequestWriter(DSI::CChannel& channel
  : mChannel(channel)
  , mHeader(serverID, clientID, cmd, proto_minor)
  , mBuf(&Private::CBuffer::powerOf2) 
+ , mTraceIface(0)
 {
    mInfo.requestID = id;
    mInfo.requestType = type;
@@ -45,6 +47,7 @@ DSI::CRequestWriter::CRequestWriter(DSI::CChannel& channel
  : mChannel(channel)
  , mHeader(serverID, clientID, cmd, proto_minor)
  , mBuf(&Private::CBuffer::powerOf2) 
+ , mTraceIface(0)
 {
    mInfo.requestID = id;
    mInfo.responseType = result;
@@ -57,14 +60,34 @@ DSI::CRequestWriter::CRequestWriter(DSI::CChannel& channel, DSI::Command cmd
                                    , uint16_t proto_minor)
  : mChannel(channel)
  , mHeader(serverID, clientID, cmd, proto_minor) 
+ , mTraceIface(0)
 {
-   // NOOP
+   // announce the frame size we accept during connection setup
+   if ((cmd == DSI::ConnectRequest || cmd == DSI::ConnectResponse) && proto_minor >= DSI::LargeFramesProtoMinor)
+      mHeader.reserved[0] = DSI::getMaxFrameSize();
 }
                  
 
+DSI::CRequestWriter::CRequestWriter(DSI::ResultType result
+                                   , DSI::Command cmd
+                                   , uint32_t id)
+ : mChannel(*DSI::CDummyChannel::getInstancePtr())
+ , mHeader(SPartyID(), SPartyID(), cmd)
+ , mBuf(&Private::CBuffer::powerOf2) 
+ , mTraceIface(0)
+{
+   mHeader.type = 0;   // never flush automatically
+
+   mInfo.requestID = id;
+   mInfo.responseType = result;
+   mInfo.sequenceNumber = DSI::INVALID_SEQUENCE_NR;
+}
+
+
 DSI::CRequestWriter::CRequestWriter()
  : mChannel(*DSI::CDummyChannel::getInstancePtr())
  , mBuf(&Private::CBuffer::powerOf2) 
+ , mTraceIface(0)
 {
    // NOOP
 }
@@ -76,6 +99,30 @@ bool DSI::CRequestWriter::flush()
          
    mHeader.type = 0;   // marker for EOF
    
+   return send(mChannel);
+}
+
+
+bool DSI::CRequestWriter::flush(CChannel& channel
+                               , const SPartyID &clientID
+                               , const SPartyID &serverID
+                               , uint16_t proto_minor
+                               , int32_t sequenceNr)
+{
+   mHeader.type = 0;   // marker for EOF, do not flush again on destruction
+
+   mHeader.clientID = clientID;
+   mHeader.serverID = serverID;
+   mHeader.protoMinor = proto_minor;
+
+   mInfo.sequenceNumber = sequenceNr;
+
+   return send(channel);
+}
+
+
+bool DSI::CRequestWriter::send(CChannel& channel)
+{
    bool ret = false;
 
    // set header data
@@ -84,18 +131,31 @@ bool DSI::CRequestWriter::flush()
    if (haveEventInfo())
       totalLength += sizeof(DSI::EventInfo);
    
-   if (totalLength > DSI_PAYLOAD_SIZE)
+   // negotiated per connection, DSI_PACKET_SIZE for legacy peers
+   const size_t payloadSize = channel.getMaxFrameSize() - sizeof(DSI::MessageHeader);
+
+   // data messages of one dispatcher round go out together, multi fragment ones are large enough on their own
+   if (haveEventInfo() && totalLength <= payloadSize)
+      CCorkScope::cork(channel);
+
+   if (totalLength > payloadSize)
    {
-      mHeader.packetLength = DSI_PAYLOAD_SIZE ;
+      mHeader.packetLength = payloadSize;
       mHeader.flags |= DSI_MORE_DATA_FLAG;
+      mHeader.reserved[0] = totalLength;   // announce the total length to the receiver
    }
    else
    {
       mHeader.packetLength = totalLength;
       mHeader.flags &= ~DSI_MORE_DATA_FLAG;
+
+      // no stale total of a former message of a reused writer, connect messages carry the frame size
+      if (haveEventInfo())
+         mHeader.reserved[0] = 0;
    }
 
-   SFNDInterfaceDescription iface;
+   SFNDInterfaceDescription resolved;
+   const SFNDInterfaceDescription* iface = 0;
    uint32_t requestId = 0;
      
    iov_t iov[3] = {
@@ -104,11 +164,23 @@ bool DSI::CRequestWriter::flush()
       { const_cast<char*>(mBuf.gptr()), mHeader.packetLength }
    };
    
-   if (CTraceManager::resolve(mHeader.clientID, mHeader.serverID, iface))
+   if (CTraceManager::isEnabled())
+   {
+      if (mTraceIface)
+      {
+         iface = mTraceIface;
+      }
+      else if (CTraceManager::resolve(mHeader.clientID, mHeader.serverID, resolved))
+      {
+         iface = &resolved;
+      }
+   }
+
+   if (iface)
    {
       requestId = mInfo.requestID;
       
-      COutputTraceSession session(iface, requestId);
+      COutputTraceSession session(*iface, requestId);
       if (session.isActive())
       {
          if (haveEventInfo())
@@ -136,17 +208,22 @@ bool DSI::CRequestWriter::flush()
       iov[2].iov_len -= sizeof(DSI::EventInfo);
    }
    
-   ret = mChannel.sendAll(iov, 3);
+   ret = channel.sendAll(iov, 3);
+   ++channel.mTransportStats.messagesSent;
 
-   if( totalLength > DSI_PAYLOAD_SIZE )
+   if( totalLength > payloadSize )
    {
-      // send remaining data to sub channel
-      size_t dataSent = DSI_PAYLOAD_SIZE - sizeof(DSI::EventInfo);
+      // send remaining data to sub channel, dataSent counts the EventInfo (if any)
+      size_t infoLength = haveEventInfo() ? sizeof(DSI::EventInfo) : 0;
+      size_t dataSent = payloadSize;
+
+      mHeader.reserved[0] = 0;
+
       while(ret && dataSent < totalLength)
       {
-         if( (totalLength - dataSent) > DSI_PAYLOAD_SIZE )
+         if( (totalLength - dataSent) > payloadSize )
          {
-            mHeader.packetLength = DSI_PAYLOAD_SIZE;
+            mHeader.packetLength = payloadSize;
             mHeader.flags |= DSI_MORE_DATA_FLAG;
          }
          else
@@ -155,21 +232,22 @@ bool DSI::CRequestWriter::flush()
             mHeader.flags &= ~DSI_MORE_DATA_FLAG;
          }
 
-         iov[1].iov_base = const_cast<char*>(mBuf.gptr()) + dataSent;
+         iov[1].iov_base = const_cast<char*>(mBuf.gptr()) + dataSent - infoLength;
          iov[1].iov_len = mHeader.packetLength;
 
          if (requestId != 0)
          {            
-            COutputTraceSession session(iface, requestId);
+            COutputTraceSession session(*iface, requestId);
             if (session.isPayloadEnabled())
             {
                session.write(&mHeader, 0, iov[1].iov_base, iov[1].iov_len);
             }            
          }   
          
-         ret = mChannel.sendAll(iov, 2);
+         ret = channel.sendAll(iov, 2);
+         ++channel.mTransportStats.fragmentsSent;
 
-         dataSent += DSI_PAYLOAD_SIZE ;
+         dataSent += payloadSize;
       }
    }
 
@@ -0,0 +1,227 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CSendQueue.hpp"
+#include "DSI.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+
+
+namespace /*anonymous*/
+{
+
+   DSI::SendQueueConfig makeDefaultConfig()
+   {
+      DSI::SendQueueConfig config;
+
+      config.highWatermark = 1024 * 1024;
+      config.lowWatermark = 256 * 1024;
+      config.policy = DSI::SendQueueConfig::Block;
+
+      const char* env = ::getenv("DSI_SEND_QUEUE_HIGH_WATERMARK");
+      if (env && ::atoi(env) > 0)
+         config.highWatermark = ::atoi(env);
+
+      env = ::getenv("DSI_SEND_QUEUE_LOW_WATERMARK");
+      if (env && ::atoi(env) >= 0)
+         config.lowWatermark = ::atoi(env);
+
+      if (config.lowWatermark > config.highWatermark)
+         config.lowWatermark = config.highWatermark;
+
+      env = ::getenv("DSI_SEND_QUEUE_POLICY");
+      if (env && !::strcmp(env, "drop"))
+         config.policy = DSI::SendQueueConfig::Drop;
+
+      if (env && !::strcmp(env, "disconnect"))
+         config.policy = DSI::SendQueueConfig::Disconnect;
+
+      return config;
+   }
+
+}   // namespace anonymous
+
+
+DSI::CSendQueue::CSendQueue()
+ : mConfig(defaultConfig())
+ , mHeld(0)
+ , mCongested(false)
+ , mMidMessage(false)
+ , mDropping(false)
+{
+   ::memset(&mStats, 0, sizeof(mStats));
+}
+
+
+DSI::CSendQueue::~CSendQueue()
+{
+   clear();
+}
+
+
+const DSI::SendQueueConfig& DSI::CSendQueue::defaultConfig()
+{
+   static SendQueueConfig config = makeDefaultConfig();
+   return config;
+}
+
+
+DSI::CSendQueue::Admission DSI::CSendQueue::admit(const iov_t* iov, size_t iov_len)
+{
+   Admission rc = Accept;
+
+   if (!mMidMessage)
+   {
+      // start of a new message, only here it is allowed to drop something
+      mDropping = mCongested && mConfig.policy == SendQueueConfig::Drop;
+
+      if (mDropping)
+         ++mStats.droppedMessages;
+
+      if (mCongested && mConfig.policy == SendQueueConfig::Disconnect)
+         rc = Disconnect;
+
+      if (mCongested && mConfig.policy == SendQueueConfig::Block)
+         rc = Block;
+   }
+
+   if (mDropping)
+      rc = Drop;
+
+   // DSI messages start with the header, the more flag announces further fragments
+   mMidMessage = iov_len > 0 && iov[0].iov_len == sizeof(MessageHeader)
+      && (((const MessageHeader*)iov[0].iov_base)->flags & DSI_MORE_DATA_FLAG);
+
+   return rc;
+}
+
+
+void DSI::CSendQueue::push(const iov_t* iov, size_t iov_len, size_t offset)
+{
+   size_t total = 0;
+   for (size_t i=0; i<iov_len; ++i)
+      total += iov[i].iov_len;
+
+   assert(offset < total);
+
+   Chunk chunk;
+   chunk.len = total - offset;
+   chunk.offset = 0;
+   chunk.data = new char[chunk.len];
+
+   size_t pos = 0;
+   for (size_t i=0; i<iov_len; ++i)
+   {
+      const char* base = (const char*)iov[i].iov_base;
+      size_t len = iov[i].iov_len;
+
+      if (offset >= len)
+      {
+         offset -= len;
+         continue;
+      }
+
+      ::memcpy(chunk.data + pos, base + offset, len - offset);
+      pos += len - offset;
+      offset = 0;
+   }
+
+   mChunks.push_back(chunk);
+
+   ++mStats.deferredMessages;
+   mStats.queuedBytes += chunk.len;
+
+   if (mStats.queuedBytes > mStats.peakQueuedBytes)
+      mStats.peakQueuedBytes = mStats.queuedBytes;
+
+   update();
+}
+
+
+void DSI::CSendQueue::hold(size_t len)
+{
+   mHeld += len;
+   update();
+}
+
+
+void DSI::CSendQueue::release(size_t len)
+{
+   assert(len <= mHeld);
+
+   mHeld -= len;
+   update();
+}
+
+
+size_t DSI::CSendQueue::fill(iov_t* iov, size_t iov_len) const
+{
+   size_t n = 0;
+
+   for (std::deque<Chunk>::const_iterator iter = mChunks.begin(); iter != mChunks.end() && n < iov_len; ++iter, ++n)
+   {
+      iov[n].iov_base = iter->data + iter->offset;
+      iov[n].iov_len = iter->len - iter->offset;
+   }
+
+   return n;
+}
+
+
+void DSI::CSendQueue::consume(size_t len)
+{
+   assert(len <= mStats.queuedBytes);
+   mStats.queuedBytes -= len;
+
+   while (len > 0)
+   {
+      Chunk& chunk = mChunks.front();
+      size_t avail = chunk.len - chunk.offset;
+
+      if (len < avail)
+      {
+         chunk.offset += len;
+         len = 0;
+      }
+      else
+      {
+         len -= avail;
+
+         delete[] chunk.data;
+         mChunks.pop_front();
+      }
+   }
+
+   update();
+}
+
+
+void DSI::CSendQueue::clear()
+{
+   for (std::deque<Chunk>::iterator iter = mChunks.begin(); iter != mChunks.end(); ++iter)
+      delete[] iter->data;
+
+   mChunks.clear();
+
+   mStats.queuedBytes = 0;
+   update();
+}
+
+
+void DSI::CSendQueue::update()
+{
+   const size_t pending = mStats.queuedBytes + mHeld;
+
+   if (pending > mConfig.highWatermark)
+   {
+      mCongested = true;
+   }
+   else if (pending <= mConfig.lowWatermark)
+      mCongested = false;
+}
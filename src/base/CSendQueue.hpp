@@ -0,0 +1,147 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CSENDQUEUE_HPP
+#define DSI_BASE_CSENDQUEUE_HPP
+
+
+#include <deque>
+
+#include "dsi/CChannel.hpp"
+
+#include "dsi/private/CNonCopyable.hpp"
+
+
+namespace DSI
+{
+   /**
+    * Outbound data of a channel which could not be written without blocking. The queue
+    * also tracks the DSI message fragment boundaries, so a message is only dropped as a whole.
+    */
+   class CSendQueue : public Private::CNonCopyable
+   {
+   public:
+
+      /// Decision for a new message fragment.
+      enum Admission
+      {
+         Accept = 0,
+         Drop,
+         Disconnect,
+         Block       ///< accept after all pending data was written
+      };
+
+      CSendQueue();
+
+      ~CSendQueue();
+
+      /**
+       * The default configuration. May be modified by the environment variables
+       * @c DSI_SEND_QUEUE_HIGH_WATERMARK, @c DSI_SEND_QUEUE_LOW_WATERMARK (both in bytes)
+       * and @c DSI_SEND_QUEUE_POLICY ('drop', 'disconnect' or 'block', the default).
+       */
+      static const SendQueueConfig& defaultConfig();
+
+      inline
+      void setConfig(const SendQueueConfig& config)
+      {
+         mConfig = config;
+      }
+
+      inline
+      bool empty() const
+      {
+         return mChunks.empty();
+      }
+
+      /**
+       * Decide what to do with the given message fragment. Must be called exactly
+       * once for each fragment before sending it. Congestion is only evaluated at the
+       * start of a message, so a message larger than the high watermark is never cut off.
+       */
+      Admission admit(const iov_t* iov, size_t iov_len);
+
+      /**
+       * Append the given data to the queue, skipping the first @c offset bytes which
+       * have already been written.
+       */
+      void push(const iov_t* iov, size_t iov_len, size_t offset);
+
+      /**
+       * Account for @c len bytes the channel holds back outside of the queue, e.g. while corked.
+       * They count against the watermarks just like queued data.
+       */
+      void hold(size_t len);
+
+      /**
+       * The given number of held bytes were written, queued or thrown away.
+       */
+      void release(size_t len);
+
+      /**
+       * Fill the given iovec array with the front of the queue.
+       *
+       * @return the number of iovec entries filled.
+       */
+      size_t fill(iov_t* iov, size_t iov_len) const;
+
+      /**
+       * Remove @c len bytes from the front of the queue.
+       */
+      void consume(size_t len);
+
+      /**
+       * Throw away all queued data, e.g. after the connection broke.
+       */
+      void clear();
+
+      inline
+      void countDisconnect()
+      {
+         ++mStats.disconnects;
+      }
+
+      inline
+      const SendQueueStatistics& statistics() const
+      {
+         return mStats;
+      }
+
+   private:
+
+      /// evaluate the watermarks after the amount of pending data changed
+      void update();
+
+      struct Chunk
+      {
+         char* data;
+         size_t len;
+         size_t offset;
+      };
+
+      std::deque<Chunk> mChunks;
+
+      SendQueueConfig mConfig;
+      SendQueueStatistics mStats;
+
+      /// bytes held back by the channel, see hold()
+      size_t mHeld;
+
+      /// the queue exceeded the high watermark and has not been drained to the low watermark yet
+      bool mCongested;
+
+      /// the last admitted fragment announced further fragments of the same message
+      bool mMidMessage;
+
+      /// the fragments of the current message are dropped
+      bool mDropping;
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CSENDQUEUE_HPP
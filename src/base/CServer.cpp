@@ -18,6 +18,7 @@
 #include "io.hpp"
 #include "CTCPChannel.hpp"
 #include "CConnectRequestHandle.hpp"
+#include "CShmChannel.hpp"
 #include "DSI.hpp"
 
 #include <cstdio>
@@ -55,38 +56,6 @@ DSI::CServer::ClientConnection::ClientConnection()
 }
 
 
-// --------------------------------------------------------------------------------------------
-
-
-namespace /* anonymous */
-{
-
-class SessionHandleComparator
-{
-public:
-
-   explicit inline
-   SessionHandleComparator(int32_t sessionid)
-      : mSessionid(sessionid)
-   {
-      // NOOP
-   }
-
-   /// The 'template' function is a workaround in order to avoid public/private clashes.
-   /// The functor will always be called for DSI::CServer::Notification.
-   template<typename T>
-   inline
-   bool operator()(const T& n)
-   {
-      return n.sessionId == mSessionid;
-   }
-
-   int32_t mSessionid;
-};
-
-}   // namespace
-
-
 // --------------------------------------------------------------------------------------------------------
 
 
@@ -126,16 +95,19 @@ int DSI::CServer::unblockRequest()
 
    if (DSI::INVALID_ID != mResponseId)
    {
-      for( int idx=(int)mNotifications.size()-1; idx>=0; idx-- )
+      notificationlist_type::handlelist_type handles;
+      mNotifications.collectClient(mClientID, mResponseId, handles);
+
+      for( int idx=(int)handles.size()-1; idx>=0; idx-- )
       {
-         if( mNotifications[idx].notifyID == mResponseId
-             && mNotifications[idx].sessionId == DSI::INVALID_SESSION_ID
-             && mNotifications[idx].clientID == mClientID )
+         Notification* n = mNotifications.find(handles[idx]);
+
+         if( n->sessionId == DSI::INVALID_SESSION_ID )
          {
             handle = DSI::createId();
-            mUnblockedSessions[handle] = mNotifications[idx] ;
+            mUnblockedSessions[handle] = *n ;
 
-            mNotifications.erase( mNotifications.begin() + idx );
+            mNotifications.erase( handles[idx] );
             break;
          }
       }
@@ -163,7 +135,7 @@ void DSI::CServer::prepareResponse(int handle)
 
       mResponseId = n.notifyID ;
       mClientID = n.clientID;
-      mNotifications.push_back( n );
+      (void)mNotifications.add( n );
       setResponseState( n.notifyID, true );
    }
 }
@@ -204,6 +176,54 @@ void DSI::CServer::registerInterfaceTCP( uint32_t address, int32_t port )
 }
 
 
+void DSI::CServer::registerInterfaces( const std::vector<CServer*>& servers, int32_t channel, uint32_t address, int32_t port )
+{
+   TRC_SCOPE( dsi_base, CServer, global );
+   DBG_MSG(("DSI::CServer::registerInterfaces() %u servers", (unsigned int)servers.size() ));
+
+   std::vector<CServer*> tcp;
+   std::vector<CServer*> local;
+
+   for (std::vector<CServer*>::const_iterator iter = servers.begin(); iter != servers.end(); ++iter)
+   {
+      if ((*iter)->mTCPIPEnabled && port > 0)
+         tcp.push_back(*iter);
+
+      if ((*iter)->mUserGroup.empty())
+      {
+         local.push_back(*iter);
+      }
+      else
+         (*iter)->registerInterface(channel);
+   }
+
+   // tcp first, see registerInterfaceTCP
+   (void)CServicebroker::registerInterfaceTCP( tcp, address, port );
+
+   for (std::vector<CServer*>::iterator iter = tcp.begin(); iter != tcp.end(); ++iter)
+   {
+      if ((*iter)->mTCPServerID)
+      {
+         CTraceManager::add((*iter)->mTCPServerID, (*iter)->mIfDescription);
+      }
+      else
+         DBG_ERROR(( "Error registering %s %d.%d", (*iter)->mIfDescription.name, (*iter)->mIfDescription.version.majorVersion, (*iter)->mIfDescription.version.minorVersion ));
+   }
+
+   (void)CServicebroker::registerInterface( local, channel );
+
+   for (std::vector<CServer*>::iterator iter = local.begin(); iter != local.end(); ++iter)
+   {
+      if ((*iter)->mServerID)
+      {
+         CTraceManager::add((*iter)->mServerID, (*iter)->mIfDescription);
+      }
+      else
+         DBG_ERROR(( "Error registering %s %d.%d", (*iter)->mIfDescription.name, (*iter)->mIfDescription.version.majorVersion, (*iter)->mIfDescription.version.minorVersion ));
+   }
+}
+
+
 void DSI::CServer::cleanupClientConnection(const CServer::ClientConnection& c)
 {
    // clear the client detach notification first
@@ -282,7 +302,7 @@ void DSI::CServer::handleDataRequest( Private::CDataRequestHandle &handle )
                n.clientID = handle.getClientID();
                n.notifyID = mResponseId ;
                n.sequenceNr = handle.getSequenceNumber() ;
-               mNotifications.push_back(n);
+               (void)mNotifications.add(n);
                setResponseState(mResponseId, true);
             }
 
@@ -308,85 +328,30 @@ void DSI::CServer::handleDataRequest( Private::CDataRequestHandle &handle )
 
       case DSI::REQUEST_NOTIFY:
       case DSI::REQUEST_REGISTER_NOTIFY:
+         addNotification( handle.getClientID(), handle.getRequestId(), handle.getRequestType(), handle.getSequenceNumber() );
+         break;
+
+      case DSI::REQUEST_NOTIFY_LIST:
       {
-         // a cliern set a notification on an attribute
-         uint32_t requestId = handle.getRequestId() ;
-         SPartyID clientID = handle.getClientID() ;
+         std::vector<notificationid_t> ids;
 
-         // first we check if the notification already exists
-         bool found = false ;
-         for( int idx=0; !found && idx<(int)mNotifications.size(); idx++ )
-         {
-            found = mNotifications[idx].clientID == clientID
-               && mNotifications[idx].notifyID == requestId
-               && (DSI::REQUEST_NOTIFY == handle.getRequestType() || (mNotifications[idx].sequenceNr == handle.getSequenceNumber()));
-         }
+         CIStream istream(handle.payload(), handle.size());
+         istream >> ids;
 
-         if( !found )
+         if (0 == istream.getError())
          {
-            // It's a new notification -> add it
-            Notification n ;
-            n.clientID = clientID;
-            n.notifyID = requestId;
-            if(DSI::REQUEST_REGISTER_NOTIFY == handle.getRequestType())
-            {
-               // client side session id
-               n.sequenceNr = handle.getSequenceNumber();
-
-               // server side session id
-               SessionData* session = findSession(n.sequenceNr, clientID);
-
-               if (session)
-               {
-                  n.sessionId = session->sessionId;   
-               }
-               else
-               {
-                  SessionData sd ;
-                  sd.sessionId = n.sessionId = DSI::createId();
-                  sd.clientID = clientID ;
-                  sd.sequenceNr = handle.getSequenceNumber();
-                  mSessions.push_back( sd );
-
-               }
-            }
-            mNotifications.push_back( n );
-         }
+            // all initial attribute values go out with one write
+            ClientConnection* conn = findClientConnection(handle.getClientID());
+            std::tr1::shared_ptr<CChannel> chnl = conn ? conn->channel.lock() : std::tr1::shared_ptr<CChannel>();
 
-         if (DSI::isAttributeId(requestId))
-         {
-            if (DSI::DATA_OK == getAttributeState(requestId))
-            {
-               // Send the attribute back to the client right away.
-               ClientConnection* conn = findClientConnection(clientID);
-               if (conn && !conn->channel.expired())
-               {
-                  DBG_MSG(( "DSI::CServer::sendNotification() c:<%d.%d> %s (0x%08X) DATA_OK"
-                          , conn->clientID.s.extendedID, conn->clientID.s.localID
-                          , getUpdateIDString(requestId), requestId ));
-
-                  CRequestWriter writer(*conn->channel.lock()
-                                       , DSI::RESULT_DATA_OK
-                                       , DSI::DataResponse
-                                       , requestId
-                                       , DSI::INVALID_SEQUENCE_NR
-                                       , conn->clientID
-                                       , conn->serverID
-                                       , conn->protoMinor);
-                  COStream ostream(writer);
-
-                  writeAttribute(requestId, ostream, DSI::UPDATE_COMPLETE, -1, -1);
-                  (void)writer.flush();   // FIXME should handle return code here
-               }
-               else
-               {
-                  assert(!conn->channel.expired());
-               }
-            }
-            else if (DSI::DATA_INVALID == getAttributeState(requestId))
-            {
-               sendNotification((uint32_t)requestId);
-            }
+            if (chnl)
+               chnl->cork();
+
+            for (std::vector<notificationid_t>::const_iterator iter = ids.begin(); iter != ids.end(); ++iter)
+               addNotification( handle.getClientID(), *iter, DSI::REQUEST_NOTIFY, handle.getSequenceNumber() );
+
+            if (chnl)
+               chnl->uncork();
          }
       }
       break;
@@ -400,6 +365,21 @@ void DSI::CServer::handleDataRequest( Private::CDataRequestHandle &handle )
          removeNotification( handle.getClientID() );
          break;
 
+      case DSI::REQUEST_STOP_NOTIFY_LIST:
+      {
+         std::vector<notificationid_t> ids;
+
+         CIStream istream(handle.payload(), handle.size());
+         istream >> ids;
+
+         if (0 == istream.getError())
+         {
+            for (std::vector<notificationid_t>::const_iterator iter = ids.begin(); iter != ids.end(); ++iter)
+               removeNotification( handle.getClientID(), *iter );
+         }
+      }
+      break;
+
       case DSI::REQUEST_STOP_ALL_REGISTER_NOTIFY:
       {
          // this is currently never sent by a normal client, just MoCCA clients send this
@@ -417,6 +397,90 @@ void DSI::CServer::handleDataRequest( Private::CDataRequestHandle &handle )
 }
 
 
+void DSI::CServer::addNotification(const SPartyID& clientID, uint32_t requestId, DSI::RequestType requestType, int32_t sequenceNr)
+{
+   // a cliern set a notification on an attribute
+   // first we check if the notification already exists
+   notificationlist_type::handlelist_type handles;
+   mNotifications.collectClient(clientID, requestId, handles);
+
+   bool found = false ;
+   for( int idx=0; !found && idx<(int)handles.size(); idx++ )
+   {
+      found = DSI::REQUEST_NOTIFY == requestType
+         || mNotifications.find(handles[idx])->sequenceNr == sequenceNr;
+   }
+
+   if( !found )
+   {
+      // It's a new notification -> add it
+      Notification n ;
+      n.clientID = clientID;
+      n.notifyID = requestId;
+      if(DSI::REQUEST_REGISTER_NOTIFY == requestType)
+      {
+         // client side session id
+         n.sequenceNr = sequenceNr;
+
+         // server side session id
+         SessionData* session = findSession(n.sequenceNr, clientID);
+
+         if (session)
+         {
+            n.sessionId = session->sessionId;   
+         }
+         else
+         {
+            SessionData sd ;
+            sd.sessionId = n.sessionId = DSI::createId();
+            sd.clientID = clientID ;
+            sd.sequenceNr = sequenceNr;
+            mSessions.push_back( sd );
+
+         }
+      }
+      (void)mNotifications.add( n );
+   }
+
+   if (DSI::isAttributeId(requestId))
+   {
+      if (DSI::DATA_OK == getAttributeState(requestId))
+      {
+         // Send the attribute back to the client right away.
+         ClientConnection* conn = findClientConnection(clientID);
+         if (conn && !conn->channel.expired())
+         {
+            DBG_MSG(( "DSI::CServer::sendNotification() c:<%d.%d> %s (0x%08X) DATA_OK"
+                    , conn->clientID.s.extendedID, conn->clientID.s.localID
+                    , getUpdateIDString(requestId), requestId ));
+
+            CRequestWriter writer(*conn->channel.lock()
+                                 , DSI::RESULT_DATA_OK
+                                 , DSI::DataResponse
+                                 , requestId
+                                 , DSI::INVALID_SEQUENCE_NR
+                                 , conn->clientID
+                                 , conn->serverID
+                                 , conn->protoMinor);
+            writer.setTraceInterface(mIfDescription);
+            COStream ostream(writer);
+
+            writeAttribute(requestId, ostream, DSI::UPDATE_COMPLETE, -1, -1);
+            (void)writer.flush();   // FIXME should handle return code here
+         }
+         else
+         {
+            assert(!conn->channel.expired());
+         }
+      }
+      else if (DSI::DATA_INVALID == getAttributeState(requestId))
+      {
+         sendNotification((uint32_t)requestId);
+      }
+   }
+}
+
+
 DSI::CServer::SessionData* DSI::CServer::findSession(int32_t seqNr, const SPartyID &clientID)
 {
    SessionData* session = 0;
@@ -454,7 +518,11 @@ void DSI::CServer::removeSession( int32_t sessionId )
 
 void DSI::CServer::removeSessionNotifications( int32_t sessionId )
 {
-   std::remove_if(mNotifications.begin(), mNotifications.end(), SessionHandleComparator(sessionId));
+   notificationlist_type::handlelist_type handles;
+   mNotifications.collectSession(sessionId, handles);
+
+   for (notificationlist_type::handlelist_type::const_iterator iter = handles.begin(); iter != handles.end(); ++iter)
+      mNotifications.erase(*iter);
 }
 
 
@@ -479,93 +547,112 @@ bool DSI::CServer::isSessionActive(int32_t sessionId)
 void DSI::CServer::sendNotification( uint32_t id, DSI::UpdateType type, int16_t position, int16_t count )
 {
    TRC_SCOPE( dsi_base, CServer, sendNotification );
-   for( int idx=0; idx<(int)mNotifications.size(); idx++ )
-   {
-      if( mNotifications[idx].notifyID == id )
-      {
-         ClientConnection* conn = findClientConnection(mNotifications[idx].clientID);
-         if (conn && !conn->channel.expired())
-         {
-            DSI::ResultType rtyp = DSI::DATA_OK == getAttributeState( id ) ? DSI::RESULT_DATA_OK : DSI::RESULT_DATA_INVALID ;
 
-            DBG_MSG(( "DSI::CServer::sendNotification() c:<%d.%d> %s (0x%08X) %s"
-                              , conn->clientID.s.extendedID, conn->clientID.s.localID
-                              , getUpdateIDString(id), id
-                              , DSI::toString( rtyp )));
+   // collect the receivers first since looking up the connections may modify the notification list
+   notificationlist_type::handlelist_type handles;
+   mNotifications.collect(id, handles);
 
-            CRequestWriter writer( *conn->channel.lock()
-                                 , rtyp
-                                 , DSI::DataResponse
-                                 , id
-                                 , DSI::INVALID_SEQUENCE_NR
-                                 , conn->clientID
-                                 , conn->serverID
-                                 , conn->protoMinor) ;
+   std::vector<SPartyID> receivers;
+   receivers.reserve(handles.size());
 
-            if( rtyp == DSI::RESULT_DATA_OK )
-            {
-               COStream ostream(writer);
-               writeAttribute(id, ostream, type, position, count);
-            }
+   for (notificationlist_type::handlelist_type::const_iterator iter = handles.begin(); iter != handles.end(); ++iter)
+      receivers.push_back(mNotifications.find(*iter)->clientID);
 
-            (void)writer.flush();   // FIXME should handle return value here
-         }
-         else
+   if (receivers.empty())
+      return;
+
+   DSI::ResultType rtyp = DSI::DATA_OK == getAttributeState( id ) ? DSI::RESULT_DATA_OK : DSI::RESULT_DATA_INVALID ;
+
+   // the payload is the same for all receivers, so serialize it only once
+   CRequestWriter writer(rtyp, DSI::DataResponse, id);
+   writer.setTraceInterface(mIfDescription);
+   bool serialized = false;
+
+   for (std::vector<SPartyID>::const_iterator iter = receivers.begin(); iter != receivers.end(); ++iter)
+   {
+      ClientConnection* conn = findClientConnection(*iter);
+      if (conn && !conn->channel.expired())
+      {
+         DBG_MSG(( "DSI::CServer::sendNotification() c:<%d.%d> %s (0x%08X) %s"
+                           , conn->clientID.s.extendedID, conn->clientID.s.localID
+                           , getUpdateIDString(id), id
+                           , DSI::toString( rtyp )));
+
+         if( rtyp == DSI::RESULT_DATA_OK && !serialized )
          {
-            assert(!conn->channel.expired());
+            COStream ostream(writer);
+            writeAttribute(id, ostream, type, position, count);
+            serialized = true;
          }
+
+         (void)writer.flush(*conn->channel.lock(), conn->clientID, conn->serverID, conn->protoMinor
+                          , DSI::INVALID_SEQUENCE_NR);   // FIXME should handle return value here
+      }
+      else
+      {
+         assert(!conn || !conn->channel.expired());
       }
    }
 }
 
 void DSI::CServer::sendResponse(uint32_t responseId, uint32_t id, DSI::ResultType typ, uint32_t* err)
 {
+   CRequestWriter writer(typ, DSI::DataResponse, id);
+   if (err)
+   {
+      COStream ostream(writer);
+      ostream << *err;
+   }
+
+   sendResponse(responseId, writer);
+}
 
-   for( int32_t idx=mNotifications.size()-1; idx>=0; idx-- )
+
+void DSI::CServer::sendResponse(uint32_t responseId, CRequestWriter& writer)
+{
+   writer.setTraceInterface(mIfDescription);
+
+   // work on the handles since looking up the connections may modify the notification list
+   notificationlist_type::handlelist_type handles;
+   mNotifications.collect(responseId, handles);
+
+   for( int32_t idx=handles.size()-1; idx>=0; idx-- )
    {
-      if(  mNotifications[idx].notifyID == (uint32_t) responseId
-        && (mNotifications[idx].sessionId == DSI::INVALID_SESSION_ID
-        || isSessionActive( mNotifications[idx].sessionId )))
+      Notification* n = mNotifications.find(handles[idx]);
+
+      if(  n
+        && (n->sessionId == DSI::INVALID_SESSION_ID
+        || isSessionActive( n->sessionId )))
       {
-         ClientConnection* conn = findClientConnection(mNotifications[idx].clientID);
+         Notification receiver = *n;
+
+         ClientConnection* conn = findClientConnection(receiver.clientID);
          if (conn && !conn->channel.expired())
          {
-            CRequestWriter writer( *conn->channel.lock()
-                                 , typ
-                                 , DSI::DataResponse
-                                 , id
-                                 , mNotifications[idx].sequenceNr
-                                 , mNotifications[idx].clientID
-                                 , conn->serverID
-                                 , conn->protoMinor);
-            if (err)
-            {
-               COStream ostream(writer);
-               ostream << *err;
-            }
-
-            (void)writer.flush();
+            (void)writer.flush(*conn->channel.lock(), receiver.clientID, conn->serverID, conn->protoMinor
+                             , receiver.sequenceNr);
 
-            if( DSI::INVALID_SEQUENCE_NR != mNotifications[idx].sequenceNr
-             && DSI::INVALID_SESSION_ID == mNotifications[idx].sessionId )
+            if( DSI::INVALID_SEQUENCE_NR != receiver.sequenceNr
+             && DSI::INVALID_SESSION_ID == receiver.sessionId )
             {
                // one shot notification
-               mNotifications.erase( mNotifications.begin() + idx );
+               mNotifications.erase( handles[idx] );
             }
          }
          else
          {
-            assert(!conn->channel.expired());
+            assert(!conn || !conn->channel.expired());
          }
       }
    }
+
    if (mResponseId == responseId)
    {
       mResponseId = DSI::INVALID_ID;
    }
-
 }
 
+
 DSI::CServer::ClientConnection* DSI::CServer::findClientConnection(const SPartyID& clientID)
 {
    ClientConnection* rc = 0;
@@ -591,18 +678,17 @@ void DSI::CServer::removeNotification( const SPartyID &clientID, uint32_t id )
 {
    TRC_SCOPE( dsi_base, CServer, removeNotification );
 
-   for( int idx=(int)mNotifications.size()-1; idx>=0; idx-- )
+   notificationlist_type::handlelist_type handles;
+   mNotifications.collectClient(clientID, id, handles);
+
+   for (notificationlist_type::handlelist_type::const_iterator iter = handles.begin(); iter != handles.end(); ++iter)
    {
-      if(( mNotifications[idx].clientID == clientID )
-         && ( DSI::INVALID_ID == id || mNotifications[idx].notifyID == id ))
-      {
-         DBG_MSG(("DSI::CServer::removeNotification() %s %d.%d - c:<%d.%d> %s"
-                  , mIfDescription.name, mIfDescription.version.majorVersion, mIfDescription.version.minorVersion
-                  , clientID.s.extendedID, clientID.s.localID
-                  , getUpdateIDString(mNotifications[idx].notifyID)));
+      DBG_MSG(("DSI::CServer::removeNotification() %s %d.%d - c:<%d.%d> %s"
+               , mIfDescription.name, mIfDescription.version.majorVersion, mIfDescription.version.minorVersion
+               , clientID.s.extendedID, clientID.s.localID
+               , getUpdateIDString(mNotifications.find(*iter)->notifyID)));
 
-         mNotifications.erase( mNotifications.begin() + idx );
-      }
+      mNotifications.erase( *iter );
    }
 }
 
@@ -624,6 +710,11 @@ void DSI::CServer::handleConnectRequest(CConnectRequestHandle &handle)
    uint16_t protoMinor = (handle.getProtoMinor() < isprotoMinor) ? handle.getProtoMinor() : isprotoMinor;
 
    conn.protoMinor = protoMinor;
+   if (!conn.channel.expired())
+   {
+      conn.channel.lock()->setMaxFrameSize(DSI::negotiateMaxFrameSize(protoMinor, handle.getMaxFrameSize()));
+      CShmChannel::upgrade(conn.channel.lock().get(), protoMinor);
+   }
    conn.id = DSI::createId() ;
    conn.clientID = handle.getClientID();
    conn.serverID = handle.getServerID();
@@ -637,6 +728,8 @@ void DSI::CServer::handleConnectRequest(CConnectRequestHandle &handle)
    rci.channel = mCommEngine->getLocalChannel();
 
    DSI::MessageHeader msg(handle.getServerID(), handle.getClientID(), DSI::ConnectResponse, conn.protoMinor, sizeof(rci));
+   if (conn.protoMinor >= DSI::LargeFramesProtoMinor)
+      msg.reserved[0] = DSI::getMaxFrameSize();
 
    iov_t iov[2] = {
       { &msg, sizeof(msg) },
@@ -679,6 +772,8 @@ void DSI::CServer::handleConnectRequestTCP(CTCPConnectRequestHandle &handle)
       uint16_t protoMinor = (handle.getProtoMinor() < isprotoMinor) ? handle.getProtoMinor() : isprotoMinor;
 
       conn.protoMinor = protoMinor;
+      if (!conn.channel.expired())
+         conn.channel.lock()->setMaxFrameSize(DSI::negotiateMaxFrameSize(protoMinor, handle.getMaxFrameSize()));
       conn.id = DSI::createId() ;
       conn.clientID = handle.getClientID();
       conn.serverID = handle.getServerID();
@@ -702,6 +797,8 @@ void DSI::CServer::handleConnectRequestTCP(CTCPConnectRequestHandle &handle)
          rci.port = mCommEngine->getIPPort();
 
          DSI::MessageHeader msg(handle.getServerID(), handle.getClientID(), DSI::ConnectResponse, conn.protoMinor, sizeof(rci));
+         if (conn.protoMinor >= DSI::LargeFramesProtoMinor)
+            msg.reserved[0] = DSI::getMaxFrameSize();
 
          iov_t iov[2] = {
             { &msg, sizeof(msg) },
@@ -873,6 +970,7 @@ void DSI::CServer::sendErrorToClient( const SPartyID &clientID, uint32_t id, DSI
                            , conn->clientID
                            , conn->serverID
                            , conn->protoMinor) ;
+      writer.setTraceInterface(mIfDescription);
 
       COStream ostream(writer);
       ostream.write(0);
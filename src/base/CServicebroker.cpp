@@ -33,22 +33,27 @@ int DSI::CServicebroker::GetSBHandle()
    LockGuard<> lock(SBAccessLock);
 
    if( SBHandle <= 0 )
-   {
-      // try to open the servicebroker
-      const char* mountpoint = ::getenv("DSI_SERVICEBROKER");
+      SBHandle = openHandle();
 
-      if (!mountpoint)
-         mountpoint = FND_SERVICEBROKER_PATHNAME;
+   return SBHandle;
+}
 
-      SBHandle = SBOpen( mountpoint );
 
-      if( -1 == SBHandle )
-      {
-         Log::syslog(Log::Critical, "DSI: Error opening servicebroker (%s)", mountpoint );
-      }
+int DSI::CServicebroker::openHandle()
+{
+   const char* mountpoint = ::getenv("DSI_SERVICEBROKER");
+
+   if (!mountpoint)
+      mountpoint = FND_SERVICEBROKER_PATHNAME;
+
+   int handle = SBOpen( mountpoint );
+
+   if( -1 == handle )
+   {
+      Log::syslog(Log::Critical, "DSI: Error opening servicebroker (%s)", mountpoint );
    }
 
-   return SBHandle;
+   return handle;
 }
 
 
@@ -121,7 +126,8 @@ bool DSI::CServicebroker::registerInterface( std::vector<CServer*>& serverlist,
          {
             for( unsigned int idx=0; idx<serverlist.size(); idx++ )
             {
-               serverlist[idx]->mServerID = serverIDs[idx] ;
+               // the servicebroker marks each rejected interface with an invalid id
+               serverlist[idx]->mServerID = serverIDs[idx].globalID == (uint64_t)-1 ? 0 : serverIDs[idx].globalID ;
             }
          }
       }
@@ -130,6 +136,38 @@ bool DSI::CServicebroker::registerInterface( std::vector<CServer*>& serverlist,
 }
 
 
+bool DSI::CServicebroker::registerInterfaceTCP( std::vector<CServer*>& serverlist, uint32_t address, uint32_t port )
+{
+   TRC_SCOPE( dsi_base, CServicebroker, global );
+   bool retval = true ;
+
+   if( 0 < serverlist.size() )
+   {
+      std::vector<SFNDInterfaceDescription> ifs(serverlist.size());
+      std::vector<SPartyID> serverIDs(serverlist.size());
+
+      for( unsigned int idx=0; idx<serverlist.size(); idx++ )
+      {
+         ifs[idx] = serverlist[idx]->mIfDescription ;
+      }
+
+      if( 0 != SBRegisterInterfaceExTCP( GetSBHandle(), &ifs[0], ifs.size(), address, port, &serverIDs[0] ))
+      {
+         DBG_ERROR(( "SBRegisterInterfaceExTCP failed" ));
+         retval = false ;
+      }
+      else
+      {
+         for( unsigned int idx=0; idx<serverlist.size(); idx++ )
+         {
+            serverlist[idx]->mTCPServerID = serverIDs[idx].globalID == (uint64_t)-1 ? 0 : serverIDs[idx].globalID ;
+         }
+      }
+   }
+   return retval ;
+}
+
+
 bool DSI::CServicebroker::registerInterfaceTCP( CServer& server, uint32_t address, uint32_t port )
 {
    // Call service broker and handle result
@@ -31,11 +31,18 @@ namespace DSI
       static bool registerInterface( CServer& server, int32_t chid, const std::string& userGroup = "" );
 
       /**
-       * @param serverlist The servers that should be registered. Note that the internal fields mServerID of the
-       *                   CServer will be updated if the call is successful.
+       * @param serverlist The servers that should be registered with a single servicebroker request. Note that
+       *                   the internal fields mServerID of the CServer will be updated if the call is successful.
+       *                   Interfaces rejected by the servicebroker get an mServerID of 0.
        */
       static bool registerInterface( std::vector<CServer*>& serverlist, int32_t chid );
 
+      /**
+       * @param serverlist The servers that should be registered as TCP servers with a single servicebroker
+       *                   request. The internal fields mTCPServerID are updated like in @c registerInterface.
+       */
+      static bool registerInterfaceTCP( std::vector<CServer*>& serverlist, uint32_t address, uint32_t port );
+
       /**
        * @param server The server that should be registered as TCP server. Note that the internal field
        *               mTCPServerID will be updated if the call is successful.
@@ -105,6 +112,12 @@ namespace DSI
        *        client lib unless an environment variable DSISERVICEBROKER is set.
        */
       static int GetSBHandle();
+
+      /**
+       * @brief opens a new connection to the servicebroker, independent of the shared handle.
+       * @return the handle or -1 on error.
+       */
+      static int openHandle();
    };
 }//namespace DSI
 
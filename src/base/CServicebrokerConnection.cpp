@@ -0,0 +1,288 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CServicebrokerConnection.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "dsi/Log.hpp"
+
+#include "CServicebroker.hpp"
+#include "../servicebroker/frames.h"
+
+
+TRC_SCOPE_DEF(dsi_base, CServicebrokerConnection, global);
+
+
+namespace /*anonymous*/
+{
+
+   /// id of the first request of a connection, only servicebrokers evaluating pipelined requests echo it
+   const int32_t PIPELINING_PROBE_ID = 1;
+
+
+   unsigned int getPipelineWindow()
+   {
+      static int window = -1;
+
+      if (window < 0)
+      {
+         const char* env = ::getenv("DSI_SERVICEBROKER_PIPELINE");
+         window = env ? ::atoi(env) : 16;
+
+         if (window < 1)
+            window = 1;
+      }
+
+      return window;
+   }
+
+}   // namespace anonymous
+
+
+DSI::CServicebrokerConnection::CServicebrokerConnection(Dispatcher& dispatcher)
+ : mDispatcher(dispatcher)
+ , mFd(-1)
+ , mWriteArmed(false)
+ , mWindow(1)
+ , mProbed(false)
+ , mGeneration(0)
+{
+   // NOOP
+}
+
+
+DSI::CServicebrokerConnection::~CServicebrokerConnection()
+{
+   if (mFd >= 0)
+   {
+      mDispatcher.removeAll(mFd);
+      while(::close(mFd) < 0 && errno == EINTR);
+   }
+}
+
+
+bool DSI::CServicebrokerConnection::open()
+{
+   if (mFd < 0)
+   {
+      int fd = CServicebroker::openHandle();
+
+      if (fd >= 0)
+      {
+         (void)::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+         mFd = fd;
+         mDispatcher.enqueueEvent(mFd, new GenericEvent<std::tr1::function<bool(GenericEventBase::Result)> >(
+                                     std::tr1::bind(&CServicebrokerConnection::handleRead, this, std::tr1::placeholders::_1)), POLLIN);
+      }
+   }
+
+   return mFd >= 0;
+}
+
+
+void DSI::CServicebrokerConnection::close()
+{
+   TRC_SCOPE(dsi_base, CServicebrokerConnection, global);
+   DBG_ERROR(("CServicebrokerConnection: lost servicebroker connection, failing %u requests", (unsigned int)pending()));
+
+   mDispatcher.removeAll(mFd);
+   while(::close(mFd) < 0 && errno == EINTR);
+
+   mFd = -1;
+   mWriteArmed = false;
+   ++mGeneration;
+
+   // the next servicebroker may be a different one
+   mWindow = 1;
+   mProbed = false;
+
+   mOut.clear();
+   mIn.clear();
+
+   std::deque<Request> failed;
+   failed.swap(mPending);
+   failed.insert(failed.end(), mQueued.begin(), mQueued.end());
+   mQueued.clear();
+
+   // the handlers may already send new requests
+   for (std::deque<Request>::iterator iter = failed.begin(); iter != failed.end(); ++iter)
+   {
+      if (iter->handler)
+         iter->handler(-1, 0, 0);
+   }
+}
+
+
+bool DSI::CServicebrokerConnection::request(dcmd_t cmd, const void* data, size_t len, const handler_type& handler, const void* owner)
+{
+   if (!open())
+      return false;
+
+   mQueued.push_back(Request());
+
+   Request& req = mQueued.back();
+   req.handler = handler;
+   req.owner = owner;
+   req.frame.resize(sizeof(sb_request_frame_t) + len);
+
+   INIT_REQUEST_FRAME((sb_request_frame_t*)&req.frame[0], len, cmd);
+   if (len)
+      ::memcpy(&req.frame[sizeof(sb_request_frame_t)], data, len);
+
+   // the request is accepted, errors are reported asynchronously through the handler
+   flush();
+
+   return true;
+}
+
+
+void DSI::CServicebrokerConnection::cancel(const void* owner)
+{
+   for (std::deque<Request>::iterator iter = mPending.begin(); iter != mPending.end(); ++iter)
+   {
+      if (iter->owner == owner)
+         iter->handler = handler_type();
+   }
+
+   for (std::deque<Request>::iterator iter = mQueued.begin(); iter != mQueued.end(); ++iter)
+   {
+      if (iter->owner == owner)
+         iter->handler = handler_type();
+   }
+}
+
+
+void DSI::CServicebrokerConnection::flush()
+{
+   while(!mQueued.empty() && mPending.size() < mWindow)
+   {
+      mPending.push_back(Request());
+      mPending.back().handler = mQueued.front().handler;
+      mPending.back().owner = mQueued.front().owner;
+      mPending.back().probe = !mProbed;
+
+      // the first request of the connection finds out whether the window may be opened
+      if (!mProbed)
+      {
+         ((sb_request_frame_t*)&mQueued.front().frame[0])->fr_id = PIPELINING_PROBE_ID;
+         mProbed = true;
+      }
+
+      mOut.insert(mOut.end(), mQueued.front().frame.begin(), mQueued.front().frame.end());
+
+      mQueued.pop_front();
+   }
+
+   while(!mOut.empty())
+   {
+      ssize_t rc = ::send(mFd, &mOut[0], mOut.size(), MSG_NOSIGNAL);
+
+      if (rc > 0)
+      {
+         mOut.erase(mOut.begin(), mOut.begin() + rc);
+      }
+      else if (rc < 0 && errno == EINTR)
+      {
+         continue;
+      }
+      else
+      {
+         // on errors the write event reports the failure from within the dispatcher
+         if (!mWriteArmed)
+         {
+            mWriteArmed = true;
+            mDispatcher.enqueueEvent(mFd, new GenericEvent<std::tr1::function<bool(GenericEventBase::Result)> >(
+                                        std::tr1::bind(&CServicebrokerConnection::handleWrite, this, std::tr1::placeholders::_1)), POLLOUT);
+         }
+
+         break;
+      }
+   }
+}
+
+
+bool DSI::CServicebrokerConnection::handleWrite(GenericEventBase::Result result)
+{
+   mWriteArmed = false;
+
+   if (result == GenericEventBase::CanWriteNow)
+   {
+      // arms a new write event if necessary
+      flush();
+   }
+   else
+      close();
+
+   return false;
+}
+
+
+bool DSI::CServicebrokerConnection::handleRead(GenericEventBase::Result result)
+{
+   if (result == GenericEventBase::DataAvailable)
+   {
+      char buf[1024];
+      ssize_t rc;
+
+      while((rc = ::recv(mFd, buf, sizeof(buf), 0)) > 0)
+         mIn.insert(mIn.end(), buf, buf + rc);
+
+      if (rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+      {
+         const unsigned int generation = mGeneration;
+
+         // complete as many requests as possible
+         while(mIn.size() >= sizeof(sb_response_frame_t))
+         {
+            sb_response_frame_t f;
+            ::memcpy(&f, &mIn[0], sizeof(f));
+
+            if (f.fr_envelope.fr_magic != SB_FRAME_MAGIC || f.fr_envelope.fr_size < 0 || mPending.empty())
+            {
+               close();
+               return false;
+            }
+
+            size_t total = sizeof(f) + f.fr_envelope.fr_size;
+            if (mIn.size() < total)
+               break;
+
+            Request req = mPending.front();
+            mPending.pop_front();
+
+            std::vector<char> body(mIn.begin() + sizeof(f), mIn.begin() + total);
+            mIn.erase(mIn.begin(), mIn.begin() + total);
+
+            if (req.probe && f.fr_id == PIPELINING_PROBE_ID)
+               mWindow = getPipelineWindow();
+
+            // the window has room for another queued request
+            flush();
+
+            // the handler may send new requests, cancel others or even lose the connection
+            if (req.handler)
+               req.handler(f.fr_returncode, body.empty() ? 0 : &body[0], body.size());
+
+            if (generation != mGeneration)
+               return false;
+         }
+
+         return true;
+      }
+   }
+
+   // closed by the servicebroker, I/O error or protocol violation
+   close();
+   return false;
+}
@@ -0,0 +1,116 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CSERVICEBROKERCONNECTION_HPP
+#define DSI_BASE_CSERVICEBROKERCONNECTION_HPP
+
+
+#include <deque>
+#include <vector>
+#include <tr1/functional>
+
+#include "dsi/private/servicebroker.h"
+#include "dsi/private/CNonCopyable.hpp"
+
+#include "CDispatcher.hpp"
+#include "CHandler.hpp"
+
+
+namespace DSI
+{
+   /**
+    * Non-blocking connection to the servicebroker driven by the dispatcher of a communication
+    * engine. The requests are framed like the ones of the synchronous client library but the
+    * caller does not wait for the response. Several requests may be on the wire at the same time,
+    * the servicebroker answers them in order so each response completes the oldest pending request.
+    *
+    * The first request of each connection probes the servicebroker. Only if the response echoes
+    * its id, the servicebroker evaluates pipelined requests and the number of requests on the wire
+    * is raised to the limit of the environment variable @c DSI_SERVICEBROKER_PIPELINE (default 16).
+    * Otherwise one request at a time is sent.
+    */
+   class CServicebrokerConnection : public Private::CNonCopyable
+   {
+   public:
+
+      /**
+       * Completion handler: the servicebroker's return code (-1 on I/O errors) and the response body.
+       */
+      typedef std::tr1::function<void(int, const void*, size_t)> handler_type;
+
+      explicit
+      CServicebrokerConnection(Dispatcher& dispatcher);
+
+      /**
+       * Closes the connection, pending handlers are not called any more.
+       */
+      ~CServicebrokerConnection();
+
+      /**
+       * Send a request to the servicebroker. The connection is opened if not yet done.
+       *
+       * @param handler Called from within the dispatcher once the response arrived, may be empty.
+       * @param owner Tag for cancelling the request, see @c cancel().
+       * @return false if the servicebroker is not reachable, the handler is not called in this case.
+       */
+      bool request(dcmd_t cmd, const void* data, size_t len, const handler_type& handler, const void* owner = 0);
+
+      /**
+       * Drop the handlers of all requests of the given owner. The requests themselves are still
+       * completed by the servicebroker.
+       */
+      void cancel(const void* owner);
+
+      /**
+       * @return the number of requests still waiting for their response.
+       */
+      inline
+      size_t pending() const
+      {
+         return mPending.size() + mQueued.size();
+      }
+
+   private:
+
+      struct Request
+      {
+         std::vector<char> frame;
+         handler_type handler;
+         const void* owner;
+         bool probe;           ///< the first request of the connection, see flush()
+      };
+
+      bool open();
+
+      /// close the connection and fail all requests
+      void close();
+
+      /// put queued requests on the wire as far as the window allows
+      void flush();
+
+      bool handleRead(GenericEventBase::Result result);
+      bool handleWrite(GenericEventBase::Result result);
+
+      Dispatcher& mDispatcher;
+      int mFd;
+
+      std::deque<Request> mQueued;    ///< not yet on the wire
+      std::deque<Request> mPending;   ///< on the wire, waiting for the response
+
+      std::vector<char> mOut;         ///< request data not yet written
+      std::vector<char> mIn;          ///< partially received responses
+
+      bool mWriteArmed;
+      unsigned int mWindow;
+      bool mProbed;                   ///< the first request of the connection was sent
+      unsigned int mGeneration;       ///< incremented with each closed connection
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CSERVICEBROKERCONNECTION_HPP
@@ -0,0 +1,204 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CShmChannel.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+
+#include "dsi/Log.hpp"
+
+
+TRC_SCOPE_DEF(dsi_base, CShmChannel, global);
+
+
+namespace /*anonymous*/
+{
+
+   /// ring size of new channels, the environment variable DSI_SHM_RING_SIZE=0 disables shared memory
+   uint32_t getRingSize()
+   {
+      static int ringSize = -1;
+
+      if (ringSize < 0)
+      {
+         const char* env = ::getenv("DSI_SHM_RING_SIZE");
+         ringSize = env ? ::atoi(env) : 4 * 1024 * 1024;
+
+         if (ringSize < 0)
+            ringSize = 0;
+      }
+
+      return ringSize;
+   }
+
+   /// delete the current ring and take over the new one
+   inline
+   void reset(DSI::CShmRing*& ring, DSI::CShmRing* value = 0)
+   {
+      delete ring;
+      ring = value;
+   }
+
+}   // namespace anonymous
+
+
+DSI::CShmChannel::CShmChannel(Unix::StreamSocket& sock)
+ : CLocalChannel(sock)
+ , mTxState(Idle)
+ , mTxRing(0)
+ , mRxRing(0)
+{
+   // NOOP
+}
+
+
+DSI::CShmChannel::~CShmChannel()
+{
+   delete mTxRing;
+   delete mRxRing;
+}
+
+
+bool DSI::CShmChannel::sendAll(const void* data, size_t len)
+{
+   iov_t iov = { const_cast<void*>(data), len };
+   return sendAll(&iov, 1);
+}
+
+
+bool DSI::CShmChannel::sendAll(const iov_t* iov, size_t iov_len)
+{
+   if (mTxState == Active && iov_len > 1 && iov[0].iov_len == sizeof(MessageHeader))
+   {
+      MessageHeader hdr = *(const MessageHeader*)iov[0].iov_base;
+      uint32_t position;
+
+      if (hdr.packetLength >= MinSharedPayload && mTxRing->write(iov + 1, iov_len - 1, position))
+      {
+         // only the header goes over the socket, it replaces the total length hint by the ring position
+         hdr.flags |= DSI_SHARED_DATA_FLAG;
+         hdr.reserved[0] = int32_t(position);
+
+         mTransportStats.bytesSent += hdr.packetLength;
+
+         iov_t ctrl = { &hdr, sizeof(hdr) };
+         return CLocalChannel::sendAll(&ctrl, 1);
+      }
+   }
+
+   return CLocalChannel::sendAll(iov, iov_len);
+}
+
+
+bool DSI::CShmChannel::recvShared(void* buf, size_t len, uint32_t position)
+{
+   if (mRxRing && mRxRing->read(position, buf, len))
+   {
+      mTransportStats.bytesReceived += len;
+      return true;
+   }
+
+   return false;
+}
+
+
+void DSI::CShmChannel::requestSharedMemory()
+{
+   TRC_SCOPE(dsi_base, CShmChannel, global);
+
+   if (mTxState == Idle && getRingSize() > 0)
+   {
+      reset(mTxRing, new CShmRing);
+      mTxState = Refused;
+
+      if (mTxRing->create(getRingSize()))
+      {
+         ShmSetupInfo info;
+         ::memset(&info, 0, sizeof(info));
+         ::strncpy(info.name, mTxRing->name(), sizeof(info.name) - 1);
+         info.capacity = mTxRing->capacity();
+
+         MessageHeader hdr(SPartyID(), SPartyID(), DSI::ShmSetupRequest, DSI_PROTOCOL_VERSION_MINOR, sizeof(info));
+
+         iov_t iov[2] = {
+            { &hdr, sizeof(hdr) },
+            { &info, sizeof(info) }
+         };
+
+         if (CLocalChannel::sendAll(iov, 2))
+            mTxState = Pending;
+      }
+      else
+         DBG_ERROR(("CShmChannel: cannot create shared memory ring, errno=%d", errno));
+
+      if (mTxState != Pending)
+         reset(mTxRing);
+   }
+}
+
+
+bool DSI::CShmChannel::handleSetupRequest(const ShmSetupInfo& info)
+{
+   TRC_SCOPE(dsi_base, CShmChannel, global);
+
+   ShmSetupInfo response(info);
+   response.name[sizeof(response.name) - 1] = '\0';
+
+   reset(mRxRing, new CShmRing);
+   if (!mRxRing->open(response.name, info.capacity))
+   {
+      DBG_ERROR(("CShmChannel: cannot map shared memory ring '%s'", response.name));
+
+      reset(mRxRing);
+      response.capacity = 0;
+   }
+
+   MessageHeader hdr(SPartyID(), SPartyID(), DSI::ShmSetupResponse, DSI_PROTOCOL_VERSION_MINOR, sizeof(response));
+
+   iov_t iov[2] = {
+      { &hdr, sizeof(hdr) },
+      { &response, sizeof(response) }
+   };
+
+   return CLocalChannel::sendAll(iov, 2);
+}
+
+
+void DSI::CShmChannel::handleSetupResponse(const ShmSetupInfo& info)
+{
+   TRC_SCOPE(dsi_base, CShmChannel, global);
+
+   if (mTxState == Pending)
+   {
+      // the peer has mapped the ring (or failed to), the name is no more needed
+      mTxRing->unlink();
+
+      if (info.capacity == mTxRing->capacity() && !::strncmp(info.name, mTxRing->name(), sizeof(info.name)))
+      {
+         DBG_MSG(("CShmChannel: using shared memory ring '%s' (%u bytes)", mTxRing->name(), mTxRing->capacity()));
+         mTxState = Active;
+      }
+      else
+      {
+         reset(mTxRing);
+         mTxState = Refused;
+      }
+   }
+}
+
+
+void DSI::CShmChannel::upgrade(CChannel* chnl, uint16_t protoMinor)
+{
+   if (protoMinor >= SharedMemoryProtoMinor)
+   {
+      CShmChannel* shm = dynamic_cast<CShmChannel*>(chnl);
+      if (shm)
+         shm->requestSharedMemory();
+   }
+}
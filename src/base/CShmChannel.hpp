@@ -0,0 +1,90 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CSHMCHANNEL_HPP
+#define DSI_BASE_CSHMCHANNEL_HPP
+
+
+#include "CLocalChannel.hpp"
+#include "CShmRing.hpp"
+#include "DSI.hpp"
+
+
+namespace DSI
+{
+
+   /**
+    * Local channel transferring large payloads through a shared memory ring. The message headers
+    * still flow over the UNIX socket, so the message order is defined by the socket and the socket
+    * wakes up the receiver. Payloads which do not fit into the ring are sent over the socket as usual.
+    *
+    * Each side offers a ring for the data it sends (ShmSetupRequest) once a connection with a peer
+    * of protocol minor version SharedMemoryProtoMinor was established. The ring is used after the
+    * peer accepted it (ShmSetupResponse), otherwise the channel stays a plain local channel.
+    */
+   class CShmChannel : public CLocalChannel
+   {
+   public:
+
+      enum
+      {
+         MinSharedPayload = 1024    ///< smaller payloads are cheaper to send inline
+      };
+
+      explicit
+      CShmChannel(Unix::StreamSocket& sock);
+
+      ~CShmChannel();
+
+      bool sendAll(const void* data, size_t len);
+
+      bool sendAll(const iov_t* iov, size_t iov_len);
+
+      bool recvShared(void* buf, size_t len, uint32_t position);
+
+      /**
+       * Offer a ring for the data sent over this channel if not yet done.
+       */
+      void requestSharedMemory();
+
+      /**
+       * Map the ring offered by the peer and send back the response.
+       */
+      bool handleSetupRequest(const ShmSetupInfo& info);
+
+      /**
+       * Start using the offered ring if the peer accepted it.
+       */
+      void handleSetupResponse(const ShmSetupInfo& info);
+
+      /**
+       * Offer a shared memory ring on the given channel if it is a local one and the negotiated
+       * protocol minor version supports it.
+       */
+      static
+      void upgrade(CChannel* chnl, uint16_t protoMinor);
+
+   private:
+
+      enum State
+      {
+         Idle = 0,
+         Pending,
+         Active,
+         Refused
+      };
+
+      State mTxState;
+
+      CShmRing* mTxRing;   ///< data sent by us, owned
+      CShmRing* mRxRing;   ///< data sent by the peer, owned
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CSHMCHANNEL_HPP
@@ -0,0 +1,210 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CShmRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dsi/private/util.hpp"
+
+
+#define DSI_SHM_RING_MAGIC 0x44534952   // 'DSIR'
+
+
+namespace /*anonymous*/
+{
+
+   /// copy @c len bytes from @c src into the ring starting at @c offset, wrapping around at the end
+   inline
+   void copyIn(char* ring, uint32_t capacity, uint32_t offset, const char* src, size_t len)
+   {
+      size_t first = std::min<size_t>(len, capacity - offset);
+
+      ::memcpy(ring + offset, src, first);
+      ::memcpy(ring, src + first, len - first);
+   }
+
+   inline
+   void copyOut(const char* ring, uint32_t capacity, uint32_t offset, char* dest, size_t len)
+   {
+      size_t first = std::min<size_t>(len, capacity - offset);
+
+      ::memcpy(dest, ring + offset, first);
+      ::memcpy(dest + first, ring, len - first);
+   }
+
+}   // namespace anonymous
+
+
+DSI::CShmRing::CShmRing()
+ : mCtrl(0)
+ , mData(0)
+ , mSize(0)
+ , mCapacity(0)
+ , mLinked(false)
+{
+   mName[0] = '\0';
+}
+
+
+DSI::CShmRing::~CShmRing()
+{
+   unlink();
+
+   if (mCtrl)
+      (void)::munmap(mCtrl, mSize);
+}
+
+
+bool DSI::CShmRing::create(uint32_t capacity)
+{
+   uint32_t size = 4096;
+   while(size < capacity && size < 0x80000000u)
+      size <<= 1;
+
+   ::snprintf(mName, sizeof(mName), "/dsi-%d-%u", ::getpid(), DSI::createId());
+
+   int fd = ::shm_open(mName, O_RDWR|O_CREAT|O_EXCL, 0600);
+   if (fd < 0)
+      return false;
+
+   mLinked = true;
+
+   bool rc = ::ftruncate(fd, sizeof(Control) + size) == 0 && map(fd, sizeof(Control) + size);
+   (void)::close(fd);
+
+   if (rc)
+   {
+      mCtrl->magic = DSI_SHM_RING_MAGIC;
+      mCtrl->capacity = size;
+      mCtrl->head = 0;
+      mCtrl->tail = 0;
+
+      mCapacity = size;
+   }
+   else
+      unlink();
+
+   return rc;
+}
+
+
+bool DSI::CShmRing::open(const char* name, uint32_t capacity)
+{
+   bool rc = false;
+
+   ::strncpy(mName, name, sizeof(mName) - 1);
+   mName[sizeof(mName) - 1] = '\0';
+
+   int fd = ::shm_open(mName, O_RDWR, 0600);
+   if (fd >= 0)
+   {
+      struct stat st;
+      if (capacity > 0 && (capacity & (capacity - 1)) == 0
+         && ::fstat(fd, &st) == 0 && size_t(st.st_size) == sizeof(Control) + capacity)
+         rc = map(fd, st.st_size) && mCtrl->magic == DSI_SHM_RING_MAGIC && mCtrl->capacity == capacity;
+
+      (void)::close(fd);
+   }
+
+   if (rc)
+      mCapacity = capacity;
+
+   return rc;
+}
+
+
+bool DSI::CShmRing::map(int fd, size_t size)
+{
+   void* addr = ::mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+   if (addr == MAP_FAILED)
+      return false;
+
+   mCtrl = (Control*)addr;
+   mData = (char*)addr + sizeof(Control);
+   mSize = size;
+
+   return true;
+}
+
+
+void DSI::CShmRing::unlink()
+{
+   if (mLinked)
+   {
+      (void)::shm_unlink(mName);
+      mLinked = false;
+   }
+}
+
+
+uint32_t DSI::CShmRing::capacity() const
+{
+   return mCapacity;
+}
+
+
+bool DSI::CShmRing::write(const iov_t* iov, size_t iov_len, uint32_t& position)
+{
+   size_t total = 0;
+   for (size_t i=0; i<iov_len; ++i)
+      total += iov[i].iov_len;
+
+   const uint32_t capacity = mCapacity;
+   const uint32_t head = mCtrl->head;
+   const uint32_t tail = mCtrl->tail;
+
+   // a tail beyond the head is a corrupted ring
+   if (capacity == 0 || head - tail > capacity || total > capacity - (head - tail))
+      return false;
+
+   // do not overwrite data the reader has not yet released
+   __sync_synchronize();
+
+   uint32_t offset = head & (capacity - 1);
+   for (size_t i=0; i<iov_len; ++i)
+   {
+      copyIn(mData, capacity, offset, (const char*)iov[i].iov_base, iov[i].iov_len);
+      offset = (offset + iov[i].iov_len) & (capacity - 1);
+   }
+
+   // publish the data before the new head
+   __sync_synchronize();
+   mCtrl->head = head + total;
+
+   position = head;
+   return true;
+}
+
+
+bool DSI::CShmRing::read(uint32_t position, void* buf, size_t len)
+{
+   const uint32_t capacity = mCapacity;
+   const uint32_t tail = mCtrl->tail;
+   const uint32_t head = mCtrl->head;
+
+   // the announced payload must lie completely between tail and head, which must fit into the ring
+   if (capacity == 0 || head - tail > capacity || len > capacity
+      || position - tail > head - tail || len > head - position)
+      return false;
+
+   __sync_synchronize();
+
+   copyOut(mData, capacity, position & (capacity - 1), (char*)buf, len);
+
+   // release the space only after the data was copied
+   __sync_synchronize();
+   mCtrl->tail = position + len;
+
+   return true;
+}
@@ -0,0 +1,111 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_CSHMRING_HPP
+#define DSI_BASE_CSHMRING_HPP
+
+
+#include <stdint.h>
+#include <cstddef>
+
+#include "dsi/CChannel.hpp"
+#include "dsi/private/CNonCopyable.hpp"
+
+
+namespace DSI
+{
+   /**
+    * Single producer, single consumer byte ring in a POSIX shared memory segment. The writing
+    * process creates the segment, the reading process maps it by name. The ring only carries
+    * payload data, the position of each payload is transferred together with the message header
+    * over the socket. Therefore, the reader always consumes the payloads in message order and
+    * payloads of messages never announced (e.g. dropped by the send queue) are skipped.
+    *
+    * Positions are 32 bit counters wrapping around, the capacity is a power of two. The peer is not
+    * trusted, head and tail are checked against the capacity before each access.
+    */
+   class CShmRing : public Private::CNonCopyable
+   {
+   public:
+
+      CShmRing();
+
+      /**
+       * Unmaps the segment and removes the name if not yet done.
+       */
+      ~CShmRing();
+
+      /**
+       * Create a new segment (writer side). The capacity is rounded up to a power of two.
+       */
+      bool create(uint32_t capacity);
+
+      /**
+       * Map the segment created by the peer (reader side).
+       */
+      bool open(const char* name, uint32_t capacity);
+
+      /**
+       * Remove the name of the segment from the system, the mapping stays valid.
+       */
+      void unlink();
+
+      inline
+      const char* name() const
+      {
+         return mName;
+      }
+
+      uint32_t capacity() const;
+
+      /**
+       * Copy the given data into the ring.
+       *
+       * @param position out: the ring position of the data to be announced to the reader.
+       * @return false if there is not enough free space.
+       */
+      bool write(const iov_t* iov, size_t iov_len, uint32_t& position);
+
+      /**
+       * Copy @c len bytes from the given ring position to @c buf and release all data up
+       * to the end of this payload.
+       *
+       * @return false if the position is invalid.
+       */
+      bool read(uint32_t position, void* buf, size_t len);
+
+   private:
+
+      /// shared control block, head and tail on different cache lines
+      struct Control
+      {
+         uint32_t magic;
+         uint32_t capacity;
+         char pad1[56];
+
+         volatile uint32_t head;   ///< written by the producer only
+         char pad2[60];
+
+         volatile uint32_t tail;   ///< written by the consumer only
+         char pad3[60];
+      };
+
+      bool map(int fd, size_t size);
+
+      Control* mCtrl;
+      char* mData;
+      size_t mSize;         ///< size of the mapping
+      uint32_t mCapacity;   ///< validated once, the control block may be changed by the peer any time
+
+      char mName[32];
+      bool mLinked;
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_BASE_CSHMRING_HPP
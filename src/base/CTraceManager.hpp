@@ -24,11 +24,21 @@ class CTraceManager
 public:
 
    static void init(Trace::IChannel& channel);
+
+   /**
+    * @return true if a trace channel is installed. Lock-free, the channel is never uninstalled.
+    */
+   static bool isEnabled();
       
    static void add(const SPartyID& id, const SFNDInterfaceDescription& iface);
    
    static void remove(const SPartyID& id);
    
+   /**
+    * Look up the interface of a registered client or server. The registry is protected by a
+    * lock, so the hot paths use the interface cached on the client and server objects and
+    * only requests not bound to an interface come here.
+    */
    static bool resolve(const SPartyID& clientId, const SPartyID& serverId, 
                        SFNDInterfaceDescription& iface);
    
@@ -39,6 +49,13 @@ private:
 };
 
 
+inline
+bool CTraceManager::isEnabled()
+{
+   return d != 0;
+}
+
+
 // -------------------------------------------------------------------------------------
 
 
@@ -76,6 +76,55 @@ namespace DSI
    }
 
 
+   uint32_t getMaxFrameSize()
+   {
+      static uint32_t maxFrameSize = 0;
+
+      if (!maxFrameSize)
+      {
+         maxFrameSize = DSI_MAX_FRAME_SIZE;
+
+         const char* env = ::getenv("DSI_MAX_FRAME_SIZE");
+         if (env && ::atoi(env) > 0)
+            maxFrameSize = ::atoi(env);
+
+         if (maxFrameSize < DSI_PACKET_SIZE)
+            maxFrameSize = DSI_PACKET_SIZE;
+      }
+
+      return maxFrameSize;
+   }
+
+
+   uint32_t getMaxMessageSize()
+   {
+      static uint32_t maxMessageSize = 0;
+
+      if (!maxMessageSize)
+      {
+         maxMessageSize = DSI_MAX_MESSAGE_SIZE;
+
+         const char* env = ::getenv("DSI_MAX_MESSAGE_SIZE");
+         if (env && ::atoi(env) > 0)
+            maxMessageSize = ::atoi(env);
+
+         if (maxMessageSize < DSI_PACKET_SIZE)
+            maxMessageSize = DSI_PACKET_SIZE;
+      }
+
+      return maxMessageSize;
+   }
+
+
+   uint32_t negotiateMaxFrameSize(uint16_t protoMinor, uint32_t peerMaxFrameSize)
+   {
+      if (protoMinor < LargeFramesProtoMinor || peerMaxFrameSize < DSI_PACKET_SIZE)
+         return DSI_PACKET_SIZE;
+
+      return peerMaxFrameSize < getMaxFrameSize() ? peerMaxFrameSize : getMaxFrameSize();
+   }
+
+
    const char* toString( RequestType rtype )
    {
       switch( rtype )
@@ -96,6 +145,10 @@ namespace DSI
             return "REQUEST_STOP_REGISTER_NOTIFY";
          case REQUEST_STOP_ALL_REGISTER_NOTIFY:
             return "REQUEST_STOP_ALL_REGISTER_NOTIFY";
+         case REQUEST_NOTIFY_LIST:
+            return "REQUEST_NOTIFY_LIST";
+         case REQUEST_STOP_NOTIFY_LIST:
+            return "REQUEST_STOP_NOTIFY_LIST";
          default:
             return "UNKNOWN" ;
       }
@@ -138,6 +191,10 @@ namespace DSI
             return "ConnectRequest";
          case DisconnectRequest:
             return "DisconnectRequest";
+         case ShmSetupRequest:
+            return "ShmSetupRequest";
+         case ShmSetupResponse:
+            return "ShmSetupResponse";
          default:
             return "UNKNOWN";
       }
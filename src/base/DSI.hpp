@@ -12,6 +12,9 @@
 /// multi packet message scattering flag
 #define DSI_MORE_DATA_FLAG 1   
 
+/// the payload of the packet was placed in the shared memory ring of the channel, see CShmChannel
+#define DSI_SHARED_DATA_FLAG 2
+
 /// DSI message magic
 #define DSI_MESSAGE_MAGIC 0x200
 
@@ -49,6 +52,17 @@ namespace DSI
       uint32_t port;        ///< port in big endian byte-order
    };
 
+
+   /**
+    * @brief Shared memory ring setup data (only exchanged via local transport).
+    */
+   struct ShmSetupInfo
+   {
+      char name[32];        ///< name of the POSIX shared memory object
+      uint32_t capacity;    ///< ring capacity in bytes, 0 in the response if the peer refused
+      uint32_t dummy;       ///< fillup
+   };
+
    
    const char* toString(PulseCode code);
    
@@ -69,6 +83,30 @@ namespace DSI
     * Returns the local IPv4 address as string in dotted quad notation.
     */
    const char* getLocalIpAddressString();
+
+   enum
+   {
+      LargeFramesProtoMinor  = 1,   ///< first protocol minor version supporting frames larger than DSI_PACKET_SIZE
+      SharedMemoryProtoMinor = 2,   ///< first protocol minor version supporting shared memory rings
+      NotifyListProtoMinor   = 3    ///< first protocol minor version supporting REQUEST_NOTIFY_LIST
+   };
+
+   /**
+    * Returns the maximum size of a message frame this process accepts, see DSI_MAX_FRAME_SIZE.
+    */
+   uint32_t getMaxFrameSize();
+
+   /**
+    * Returns the maximum total size of a message this process accepts, see DSI_MAX_MESSAGE_SIZE.
+    */
+   uint32_t getMaxMessageSize();
+
+   /**
+    * Returns the frame size to be used on a connection with the given negotiated protocol minor
+    * version where the peer announced @c peerMaxFrameSize. Falls back to DSI_PACKET_SIZE for
+    * legacy peers.
+    */
+   uint32_t negotiateMaxFrameSize(uint16_t protoMinor, uint32_t peerMaxFrameSize);
    
    /**
     * Find an object by internal id. An internally identifiable object must 
@@ -0,0 +1,181 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+/**
+ * Utility program to decode the trace files written by DSI::Trace::CMappedTracer.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "dsi/DSI.hpp"
+#include "dsi/Trace.hpp"
+
+#include "DSI.hpp"
+#include "tracefile.h"
+
+
+namespace /*anonymous*/
+{
+
+   struct ByPosition
+   {
+      inline
+      bool operator()(const dsi_tracefile_record_t* lhs, const dsi_tracefile_record_t* rhs) const
+      {
+         return lhs->position < rhs->position;
+      }
+   };
+
+
+   inline
+   std::ostream& operator<<(std::ostream& os, const SPartyID& id)
+   {
+      return os << id.s.localID << '.' << id.s.extendedID;
+   }
+
+
+   void printTime(std::ostream& os, uint64_t ns)
+   {
+      time_t sec = ns / 1000000000ULL;
+      struct tm tm;
+      char buf[32];
+
+      (void)::localtime_r(&sec, &tm);
+      (void)::strftime(buf, sizeof(buf), "%H:%M:%S", &tm);
+      os << buf;
+
+      (void)::snprintf(buf, sizeof(buf), ".%06u", (unsigned int)((ns % 1000000000ULL) / 1000));
+      os << buf;
+   }
+
+
+   void printPayload(std::ostream& os, const unsigned char* data, size_t len)
+   {
+      char buf[4];
+
+      for (size_t i=0; i<len; ++i)
+      {
+         if (i % 16 == 0)
+            os << std::endl << "   ";
+
+         (void)::snprintf(buf, sizeof(buf), " %02x", data[i]);
+         os << buf;
+      }
+   }
+
+
+   void printRecord(std::ostream& os, const dsi_tracefile_header_t& hdr, const dsi_tracefile_record_t& rec)
+   {
+      SPartyID serverID;
+      SPartyID clientID;
+      serverID.globalID = rec.serverID;
+      clientID.globalID = rec.clientID;
+
+      printTime(os, hdr.startRealtime + (rec.timestamp - hdr.startMonotonic));
+
+      os << (rec.direction == DSI::Trace::In ? " ==> " : " <== ")
+         << DSI::commandToString(rec.cmd)
+         << " s:<" << serverID << "> c:<" << clientID << ">";
+
+      if (rec.iface < DSI_TRACEFILE_MAX_INTERFACES && hdr.interfaces[rec.iface].state == 2)
+      {
+         const dsi_tracefile_interface_t& iface = hdr.interfaces[rec.iface];
+         os << ' ' << iface.name << ':' << iface.majorVersion << '.' << iface.minorVersion;
+      }
+
+      if (rec.hasInfo)
+      {
+         os << ' ' << (rec.cmd == DSI::DataRequest ? DSI::toString((DSI::RequestType)rec.type)
+                                                   : DSI::toString((DSI::ResultType)rec.type))
+            << " id=" << rec.requestID
+            << " seq=" << rec.sequenceNumber;
+      }
+
+      os << " len=" << rec.packetLength;
+
+      if (rec.flags & DSI_MORE_DATA_FLAG)
+         os << " more";
+
+      printPayload(os, reinterpret_cast<const unsigned char*>(&rec + 1), rec.payloadLength);
+      os << std::endl;
+   }
+
+
+   void printUsage(std::ostream& os)
+   {
+      os << "Utility program to decode DSI binary trace files." << std::endl
+         << std::endl
+         << "Usage: dsitrace <file>" << std::endl
+         << std::endl
+         << "<file>      trace file written by DSI::Trace::CMappedTracer" << std::endl
+         << std::endl;
+   }
+
+}   // namespace anonymous
+
+
+int main(int argc, char** argv)
+{
+   if (argc != 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
+   {
+      printUsage(std::cout);
+      return argc == 2 ? EXIT_SUCCESS : EXIT_FAILURE;
+   }
+
+   std::ifstream ifs(argv[1], std::ios::in | std::ios::binary);
+   if (!ifs)
+   {
+      std::cerr << "Cannot open " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   std::vector<char> file((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+   const dsi_tracefile_header_t* hdr = file.size() < DSI_TRACEFILE_RECORDS_OFFSET
+      ? 0 : reinterpret_cast<const dsi_tracefile_header_t*>(&file[0]);
+
+   if (!hdr
+       || hdr->magic != DSI_TRACEFILE_MAGIC || hdr->version != DSI_TRACEFILE_VERSION
+       || hdr->recordSize < sizeof(dsi_tracefile_record_t)
+       || file.size() < DSI_TRACEFILE_RECORDS_OFFSET + (uint64_t)hdr->recordSize * hdr->recordCount)
+   {
+      std::cerr << argv[1] << " is not a DSI trace file" << std::endl;
+      return EXIT_FAILURE;
+   }
+
+   // records still being written when the file was copied have no position
+   std::vector<const dsi_tracefile_record_t*> records;
+
+   for (uint32_t i=0; i<hdr->recordCount; ++i)
+   {
+      const dsi_tracefile_record_t* rec = reinterpret_cast<const dsi_tracefile_record_t*>(
+         &file[DSI_TRACEFILE_RECORDS_OFFSET + (size_t)i * hdr->recordSize]);
+
+      if (rec->position != 0 && rec->payloadLength <= hdr->recordSize - sizeof(dsi_tracefile_record_t))
+         records.push_back(rec);
+   }
+
+   std::sort(records.begin(), records.end(), ByPosition());
+
+   std::cout << "pid " << hdr->pid << ", " << records.size() << " records";
+   if (hdr->next > hdr->recordCount)
+      std::cout << ", " << (hdr->next - hdr->recordCount) << " overwritten";
+   std::cout << std::endl;
+
+   for (std::vector<const dsi_tracefile_record_t*>::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+      printRecord(std::cout, *hdr, **iter);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_BASE_TRACEFILE_H
+#define DSI_BASE_TRACEFILE_H
+
+#include <stdint.h>
+#include <limits.h>
+
+
+/// The trace file magic, equal to 'D' 'S' 'I' 'T'.
+#define DSI_TRACEFILE_MAGIC 0x54495344
+
+#define DSI_TRACEFILE_VERSION 1
+
+/// maximum number of distinct interfaces per trace file
+#define DSI_TRACEFILE_MAX_INTERFACES 256
+
+/// the records start at this alignment behind the file header
+#define DSI_TRACEFILE_ALIGNMENT 64
+
+
+/**
+ * An interface traced into the file. Entries are claimed once and never released.
+ */
+typedef struct dsi_tracefile_interface
+{
+   volatile uint32_t state;   ///< 0 = free, 1 = being claimed, 2 = valid
+   uint16_t majorVersion;
+   uint16_t minorVersion;
+   char name[NAME_MAX+1];
+
+} dsi_tracefile_interface_t;
+
+
+/**
+ * The trace file header, followed by @c recordCount records of @c recordSize bytes each.
+ */
+typedef struct dsi_tracefile_header
+{
+   uint32_t magic;
+   uint32_t version;
+
+   uint32_t recordSize;          ///< size of a record including its payload area
+   uint32_t recordCount;         ///< number of records in the ring
+
+   uint64_t startRealtime;       ///< CLOCK_REALTIME in ns when the file was created
+   uint64_t startMonotonic;      ///< CLOCK_MONOTONIC in ns at the same time
+
+   volatile uint64_t next;       ///< position of the next record, the record slot is next % recordCount
+
+   int32_t pid;                  ///< the traced process
+   int32_t reserved;
+
+   dsi_tracefile_interface_t interfaces[DSI_TRACEFILE_MAX_INTERFACES];
+
+} dsi_tracefile_header_t;
+
+
+/**
+ * One traced DSI frame.
+ */
+typedef struct dsi_tracefile_record
+{
+   volatile uint64_t position;   ///< position + 1 of the record, 0 while the record is written
+
+   uint64_t timestamp;           ///< CLOCK_MONOTONIC in ns
+
+   uint64_t serverID;
+   uint64_t clientID;
+
+   uint32_t cmd;
+   uint32_t flags;
+   uint32_t packetLength;        ///< length of the frame as sent on the wire
+
+   uint32_t requestID;           ///< only valid if hasInfo is set
+   int32_t sequenceNumber;       ///< only valid if hasInfo is set
+   uint32_t type;                ///< request or response type, only valid if hasInfo is set
+
+   uint16_t iface;               ///< index into the interface table of the header
+   uint8_t direction;            ///< DSI::Trace::Direction
+   uint8_t hasInfo;
+
+   uint32_t payloadLength;       ///< number of payload bytes following the record, may be truncated
+
+} dsi_tracefile_record_t;
+
+
+/// offset of the first record in the file
+#define DSI_TRACEFILE_RECORDS_OFFSET \
+   ((sizeof(dsi_tracefile_header_t) + DSI_TRACEFILE_ALIGNMENT - 1) & ~(DSI_TRACEFILE_ALIGNMENT - 1))
+
+
+#endif   // DSI_BASE_TRACEFILE_H
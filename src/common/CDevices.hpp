@@ -167,6 +167,17 @@ namespace DSI
          return ::send(fd, buf, len, MSG_NOSIGNAL|MSG_DONTWAIT);
       }
 
+      static inline
+      ssize_t write(fd_type fd, const iovec* vec, size_t veclen)
+      {
+         struct msghdr hdr;
+         ::memset(&hdr, 0, sizeof(hdr));
+         hdr.msg_iov = const_cast<iovec*>(vec);
+         hdr.msg_iovlen = veclen;
+
+         return ::sendmsg(fd, &hdr, MSG_NOSIGNAL|MSG_DONTWAIT);
+      }
+
       static inline
       ssize_t blocking_read(fd_type fd, void* buf, size_t len)
       {
@@ -401,20 +412,25 @@ namespace DSI
       }
 
 
-      void read_all(void* buf, size_t len, io::error_code& ec)
+      /// @return the number of read syscalls
+      unsigned int read_all(void* buf, size_t len, io::error_code& ec)
       {
          size_t total = 0;
          ssize_t rc;
+         unsigned int calls = 0;
 
          do
          {
             rc = iofuncs_type::blocking_read_all(fd_, (char*)buf + total, len - total);
+            ++calls;
+
             if (rc > 0)
                total += rc;
          }
          while ((rc < 0 && io::getLastError() == EINTR) || (rc > 0 && total < len));
 
          ec = io::detail::get_read_all_error_code(rc, total, len);
+         return calls;
       }
 
 
@@ -428,6 +444,16 @@ namespace DSI
       }
 
 
+      inline
+      ssize_t write_some(const iovec* iov, size_t iovlen, io::error_code& ec)
+      {
+         ssize_t rc = iofuncs_type::write(fd_, iov, iovlen);
+
+         ec = io::detail::get_write_some_error_code(rc);
+         return rc;
+      }
+
+
       void write_all(const void* buf, size_t len, io::error_code& ec)
       {
          size_t total = 0;
@@ -590,6 +616,17 @@ namespace DSI
          return ::setsockopt(fd_, option.eLevel, option.eOption, option.value(), option.eSize) == 0 ?
             io::ok : io::to_error_code(io::getLastError());
       }
+
+
+      /**
+       * Shut down both directions of the connection. The file descriptor stays open, pending
+       * asynchronous reads will see an end-of-file condition.
+       */
+      inline
+      io::error_code shutdown()
+      {
+         return ::shutdown(fd_, SHUT_RDWR) == 0 ? io::ok : io::to_error_code(io::getLastError());
+      }
    };
 
 
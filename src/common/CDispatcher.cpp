@@ -6,10 +6,11 @@
 * All rights reserved
 ****************************************************************/
 #include "CDispatcher.hpp"
+#include "TimerWheel.hpp"
 
 
 
-DSI::Dispatcher::Dispatcher(size_t capa )
+DSI::PollDispatcher::PollDispatcher(size_t capa )
    : max_(0)
    , capa_(capa)
    , fds_table_(new pollfd[capa_])
@@ -22,7 +23,7 @@ DSI::Dispatcher::Dispatcher(size_t capa )
 }
 
 
-DSI::Dispatcher::~Dispatcher()
+DSI::PollDispatcher::~PollDispatcher()
 {
    delete[] fds_table_;
 
@@ -33,9 +34,10 @@ DSI::Dispatcher::~Dispatcher()
 }
 
 
-int DSI::Dispatcher::poll(int timeout_ms)
+int DSI::PollDispatcher::poll(int timeout_ms)
 {
    int ret = ::poll(fds_table_, max_, timeout_ms);
+   woken();
 
    if (ret > 0)
    {
@@ -66,7 +68,7 @@ int DSI::Dispatcher::poll(int timeout_ms)
 }
 
 
-void DSI::Dispatcher::doEnqueueEvent(int fd, EventBase* evt, short pollmask)
+void DSI::PollDispatcher::doEnqueueEvent(int fd, EventBase* evt, short pollmask)
 {
    int pos = -1;
 
@@ -81,7 +83,9 @@ void DSI::Dispatcher::doEnqueueEvent(int fd, EventBase* evt, short pollmask)
 
    if (pos == -1)
    {
-      assert(capa_ >= max_);
+      if (max_ == capa_)
+         grow();
+
       pos = max_;
       ++max_;
    }
@@ -93,7 +97,7 @@ void DSI::Dispatcher::doEnqueueEvent(int fd, EventBase* evt, short pollmask)
 }
 
 
-void DSI::Dispatcher::doRemoveAll(int fd)
+void DSI::PollDispatcher::doRemoveAll(int fd)
 {
    for (unsigned int i=0; i<max_; ++i)
    {
@@ -106,7 +110,7 @@ void DSI::Dispatcher::doRemoveAll(int fd)
 }
 
 
-void DSI::Dispatcher::clearSlot(int idx)
+void DSI::PollDispatcher::clearSlot(int idx)
 {
    fds_table_[idx].fd = -1;
    delete events_table_[idx];
@@ -114,4 +118,43 @@ void DSI::Dispatcher::clearSlot(int idx)
 }
 
 
+void DSI::PollDispatcher::grow()
+{
+   size_t capa = capa_ > 0 ? 2 * capa_ : 16;
+
+   pollfd* fds = new pollfd[capa];
+   EventBase** events = new EventBase*[capa];
+
+   memcpy(fds, fds_table_, max_ * sizeof(pollfd));
+   memcpy(events, events_table_, max_ * sizeof(EventBase*));
+
+   for (unsigned int i=max_; i<capa; ++i)
+   {
+      fds[i].fd = -1;
+   }
+
+   delete[] fds_table_;
+   delete[] events_table_;
+
+   fds_table_ = fds;
+   events_table_ = events;
+   capa_ = capa;
+}
+
+
+// ---------------------------------------------------------------------------------------
+
+
+DSI::Dispatcher::~Dispatcher()
+{
+   delete timers_;
+}
+
+
+DSI::TimerWheel& DSI::Dispatcher::timers()
+{
+   if (!timers_)
+      timers_ = new TimerWheel(*this);
 
+   return *timers_;
+}
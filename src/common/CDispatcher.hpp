@@ -9,6 +9,11 @@
 #define DSI_DISPATCHER_HPP
 
 
+#include <stdint.h>
+#include <time.h>
+#include <cstring>
+#include <tr1/functional>
+
 #include "dsi/private/CNonCopyable.hpp"
 
 /*
@@ -37,6 +42,11 @@
 #include <sys/poll.h>
 #include <sys/time.h>
 #include <sys/timerfd.h>
+#include <sys/epoll.h>
+
+#include <stdint.h>
+
+#include <vector>
 
 // unix sockets
 #include <sys/un.h>
@@ -49,6 +59,17 @@
 
 namespace DSI
 {
+   /**
+    * Counters of the event loop of a dispatcher, only updated from within @c run().
+    */
+   struct DispatcherStatistics
+   {
+      uint64_t rounds;      ///< iterations of the event loop
+      uint64_t busyNs;      ///< time spent handling the ready events and the round handler, without waiting
+      uint64_t maxBusyNs;   ///< longest single round
+   };
+
+
    template<typename InheriterT>
    class DispatcherBase :  public DSI::Private::CNonCopyable
    {
@@ -57,8 +78,9 @@ namespace DSI
       DispatcherBase()
          : finished_(false)
          , rc_(0)
+         , woken_ns_(0)
       {
-         // NOOP
+         ::memset(&stats_, 0, sizeof(stats_));
       }
 
       template<typename DeviceT>
@@ -110,6 +132,25 @@ namespace DSI
       }
 
 
+      /**
+       * Set a handler called by @c run() after each round of ready events, right before the
+       * dispatcher waits for new events. An empty function removes the handler.
+       */
+      inline
+      void setRoundHandler(const std::tr1::function<void()>& func)
+      {
+         roundHandler_ = func;
+      }
+
+
+      /// @return the event loop counters, only valid within the dispatcher's thread
+      inline
+      const DispatcherStatistics& statistics() const
+      {
+         return stats_;
+      }
+
+
    protected:
 
       ~DispatcherBase()
@@ -119,21 +160,43 @@ namespace DSI
 
       volatile bool finished_;
       int rc_;
+
+      std::tr1::function<void()> roundHandler_;
+
+      /// to be called by @c poll() once the wait for events returned
+      inline
+      void woken()
+      {
+         woken_ns_ = monotonic_ns();
+      }
+
+      static inline
+      uint64_t monotonic_ns()
+      {
+         struct timespec ts;
+         ::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+         return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+      }
+
+      uint64_t woken_ns_;
+      DispatcherStatistics stats_;
    };
 
    /**
-    * The device event dispatcher (poll)
+    * The device event dispatcher (poll). The capacity of the pollfd table
+    * is doubled whenever it runs full.
     */
-   class Dispatcher : public DispatcherBase<Dispatcher>
+   class PollDispatcher : public DispatcherBase<PollDispatcher>
    {
 
-      friend class DispatcherBase<Dispatcher>;
+      friend class DispatcherBase<PollDispatcher>;
 
    public:
-      Dispatcher(size_t capa = 128);
+      PollDispatcher(size_t capa = 128);
 
 
-      ~Dispatcher();
+      ~PollDispatcher();
 
 
       int poll(int timeout_ms);
@@ -165,12 +228,146 @@ namespace DSI
       void clearSlot(int idx);
 
 
+      void grow();
+
+
       size_t max_;
       size_t capa_;
 
       pollfd* fds_table_;
       EventBase** events_table_;
    };
+
+
+   /**
+    * The device event dispatcher (epoll, level-triggered). Each file descriptor is registered
+    * only once within the kernel, with at most one pending input and one pending output event.
+    * The event table is indexed by the file descriptor itself, so registration and removal
+    * do not need to search and the table grows on demand.
+    */
+   class EpollDispatcher : public DispatcherBase<EpollDispatcher>
+   {
+
+      friend class DispatcherBase<EpollDispatcher>;
+
+   public:
+      EpollDispatcher(size_t capa = 128);
+
+
+      ~EpollDispatcher();
+
+
+      int poll(int timeout_ms);
+
+
+      // remove event in concern of read/write status
+      template<typename EventTraitsT>
+      void removeEvent(int fd)
+      {
+         clearSlot(fd, slotIndex(EventTraitsT::poll_mask));
+      }
+
+   private:
+
+      enum { InSlot = 0, OutSlot, SlotCount };
+
+      struct Slot
+      {
+         EventBase* evt_;
+         short mask_;
+      };
+
+      struct Entry
+      {
+         Slot slots_[SlotCount];
+
+         /// the currently registered epoll interest set, 0 if not registered
+         uint32_t events_;
+
+         /// incremented on each new kernel registration to detect stale epoll_wait results
+         uint32_t generation_;
+      };
+
+      static inline
+      int slotIndex(short pollmask)
+      {
+         return (pollmask & POLLIN) ? InSlot : OutSlot;
+      }
+
+      void doEnqueueEvent(int fd, EventBase* evt, short pollmask);
+
+
+      // remove all events to the given file descriptor
+      void doRemoveAll(int fd);
+
+
+      void clearSlot(int fd, int slot);
+
+
+      /// adapt the kernel registration of the given fd to the current slot contents
+      void update(int fd);
+
+
+      /// evaluate a single slot with the given revents
+      void evalSlot(int fd, int slot, short revents);
+
+
+      void grow(int fd);
+
+
+      int epfd_;
+
+      size_t capa_;
+      Entry* table_;
+
+      /// epoll_wait result buffer
+      std::vector<epoll_event> ready_;
+
+      /// fds which could not be registered within the kernel, will be signalled POLLNVAL
+      std::vector<int> invalid_;
+
+      /// the event currently under evaluation
+      int current_fd_;
+      int current_slot_;
+      bool current_cancelled_;
+   };
+
+
+#ifdef DSI_USE_EPOLL
+   typedef EpollDispatcher DispatcherImpl;
+#else
+   typedef PollDispatcher DispatcherImpl;
+#endif
+
+   // forward decl
+   class TimerWheel;
+
+   /**
+    * The device event dispatcher as chosen at build time (see cmake option DSI_USE_EPOLL).
+    */
+   class Dispatcher : public DispatcherImpl
+   {
+   public:
+      Dispatcher(size_t capa = 128)
+         : DispatcherImpl(capa)
+         , timers_(0)
+      {
+         // NOOP
+      }
+
+
+      ~Dispatcher();
+
+
+      /**
+       * @return the timer wheel all timers of this dispatcher share, created on first use.
+       */
+      TimerWheel& timers();
+
+   private:
+
+      TimerWheel* timers_;
+   };
 }//namespace DSI
 
 #include "CDispatcherT.hpp"
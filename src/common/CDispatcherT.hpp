@@ -23,6 +23,17 @@ namespace DSI
       while(!finished_ && ret >= 0)
       {
          ret = ((InheriterT*)this)->poll(1000);
+
+         if (roundHandler_)
+            roundHandler_();
+
+         const uint64_t busy = monotonic_ns() - woken_ns_;
+
+         ++stats_.rounds;
+         stats_.busyNs += busy;
+
+         if (busy > stats_.maxBusyNs)
+            stats_.maxBusyNs = busy;
       }
 
       if (!finished_ && ret < 0)
@@ -0,0 +1,281 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "CDispatcher.hpp"
+
+#include <algorithm>
+
+
+namespace /*anonymous*/
+{
+
+// poll error conditions are always reported, even if not part of the interest set
+const short POLL_ERROR_MASK = POLLERR | POLLHUP | POLLRDHUP | POLLNVAL;
+
+
+inline
+uint64_t makeCookie(int fd, uint32_t generation)
+{
+   return (uint64_t(generation) << 32) | uint32_t(fd);
+}
+
+}   // namespace
+
+
+DSI::EpollDispatcher::EpollDispatcher(size_t capa)
+   : epfd_(::epoll_create1(EPOLL_CLOEXEC))
+   , capa_(capa)
+   , table_(new Entry[capa_])
+   , ready_(capa_ > 0 ? capa_ : 1)
+   , current_fd_(-1)
+   , current_slot_(-1)
+   , current_cancelled_(false)
+{
+   assert(epfd_ >= 0);
+   memset(table_, 0, capa_ * sizeof(Entry));
+}
+
+
+DSI::EpollDispatcher::~EpollDispatcher()
+{
+   for (unsigned int i=0; i<capa_; ++i)
+   {
+      for (int j=0; j<SlotCount; ++j)
+         delete table_[i].slots_[j].evt_;
+   }
+
+   delete[] table_;
+
+   while(::close(epfd_) && errno == EINTR);
+}
+
+
+int DSI::EpollDispatcher::poll(int timeout_ms)
+{
+   // pending registration errors must be signalled immediately
+   int ret = ::epoll_wait(epfd_, &ready_[0], ready_.size(), invalid_.empty() ? timeout_ms : 0);
+   woken();
+
+   if (ret > 0)
+   {
+      for (int i=0; i<ret && !finished_; ++i)
+      {
+         int fd = int(ready_[i].data.u64 & 0xFFFFFFFFu);
+         uint32_t generation = uint32_t(ready_[i].data.u64 >> 32);
+
+         // skip the fd if it was removed or re-registered by a former callback of this round
+         if (size_t(fd) < capa_ && table_[fd].events_ != 0 && table_[fd].generation_ == generation)
+         {
+            short revents = short(ready_[i].events);
+
+            evalSlot(fd, InSlot, revents);
+            evalSlot(fd, OutSlot, revents);
+         }
+      }
+
+      // all slots used, so make room for more events within the next round
+      if (size_t(ret) == ready_.size())
+         ready_.resize(2 * ready_.size());
+   }
+   else if (ret < 0)
+   {
+      if (io::getLastError() == EINTR)
+      {
+         ret = 0;
+      }
+   }
+
+   if (ret >= 0 && !invalid_.empty())
+   {
+      std::vector<int> invalid;
+      invalid.swap(invalid_);
+
+      for (unsigned int i=0; i<invalid.size() && !finished_; ++i)
+      {
+         evalSlot(invalid[i], InSlot, POLLNVAL);
+         evalSlot(invalid[i], OutSlot, POLLNVAL);
+      }
+
+      ret += invalid.size();
+   }
+
+   return ret;
+}
+
+
+void DSI::EpollDispatcher::evalSlot(int fd, int slot, short revents)
+{
+   if (size_t(fd) >= capa_)
+      return;
+
+   Slot& s = table_[fd].slots_[slot];
+
+   if (s.evt_ == 0 || (revents & (s.mask_ | POLL_ERROR_MASK)) == 0)
+      return;
+
+   // detach the event during evaluation, so the user may rearm the same fd from
+   // within the callback without destroying the currently running event.
+   EventBase* evt = s.evt_;
+   s.evt_ = 0;
+
+   current_fd_ = fd;
+   current_slot_ = slot;
+   current_cancelled_ = false;
+
+   bool rearm = evt->eval(fd, revents & (s.mask_ | POLL_ERROR_MASK));
+   bool cancelled = current_cancelled_;
+
+   current_fd_ = -1;
+   current_slot_ = -1;
+
+   // the table may have been reallocated during evaluation
+   Slot& after = table_[fd].slots_[slot];
+
+   if (rearm && !cancelled && after.evt_ == 0)
+   {
+      after.evt_ = evt;
+
+      // retry a failed kernel registration, just as poll would report POLLNVAL again
+      if (table_[fd].events_ == 0)
+         update(fd);
+   }
+   else
+   {
+      delete evt;
+
+      if (after.evt_ == 0)
+      {
+         after.mask_ = 0;
+         update(fd);
+      }
+   }
+}
+
+
+void DSI::EpollDispatcher::doEnqueueEvent(int fd, EventBase* evt, short pollmask)
+{
+   if (fd < 0)
+   {
+      // not pollable at all, the event will never be fired
+      delete evt;
+      return;
+   }
+
+   if (size_t(fd) >= capa_)
+      grow(fd);
+
+   Slot& s = table_[fd].slots_[slotIndex(pollmask)];
+
+   // the last registration wins
+   delete s.evt_;
+
+   s.evt_ = evt;
+   s.mask_ = pollmask;
+
+   update(fd);
+}
+
+
+void DSI::EpollDispatcher::doRemoveAll(int fd)
+{
+   for (int j=0; j<SlotCount; ++j)
+      clearSlot(fd, j);
+}
+
+
+void DSI::EpollDispatcher::clearSlot(int fd, int slot)
+{
+   if (fd < 0 || size_t(fd) >= capa_)
+      return;
+
+   Slot& s = table_[fd].slots_[slot];
+
+   if (fd == current_fd_ && slot == current_slot_)
+      current_cancelled_ = true;
+
+   delete s.evt_;
+   s.evt_ = 0;
+   s.mask_ = 0;
+
+   update(fd);
+}
+
+
+void DSI::EpollDispatcher::update(int fd)
+{
+   Entry& entry = table_[fd];
+
+   uint32_t events = 0;
+   for (int j=0; j<SlotCount; ++j)
+   {
+      // keep the interest of an event currently under evaluation
+      if (entry.slots_[j].evt_ || (fd == current_fd_ && j == current_slot_ && !current_cancelled_))
+         events |= uint32_t(entry.slots_[j].mask_);
+   }
+
+   if (events == entry.events_)
+      return;
+
+   epoll_event ev;
+   memset(&ev, 0, sizeof(ev));
+
+   ev.events = events;
+
+   int rc;
+   if (events == 0)
+   {
+      rc = ::epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, &ev);
+   }
+   else if (entry.events_ == 0)
+   {
+      ++entry.generation_;
+      ev.data.u64 = makeCookie(fd, entry.generation_);
+
+      rc = ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+
+      // the fd was closed and reopened without being removed from the dispatcher
+      if (rc < 0 && errno == EEXIST)
+         rc = ::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+   }
+   else
+   {
+      ev.data.u64 = makeCookie(fd, entry.generation_);
+      rc = ::epoll_ctl(epfd_, EPOLL_CTL_MOD, fd, &ev);
+
+      // the fd was closed (and reopened) without being removed from the dispatcher
+      if (rc < 0 && errno == ENOENT)
+         rc = ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+   }
+
+   if (rc < 0 && events != 0)
+   {
+      // same behaviour as poll: signal an invalid file descriptor on the next round
+      if (std::find(invalid_.begin(), invalid_.end(), fd) == invalid_.end())
+         invalid_.push_back(fd);
+      events = 0;
+   }
+
+   entry.events_ = events;
+}
+
+
+void DSI::EpollDispatcher::grow(int fd)
+{
+   size_t capa = capa_ > 0 ? 2 * capa_ : 16;
+   while (capa <= size_t(fd))
+      capa *= 2;
+
+   Entry* table = new Entry[capa];
+
+   memcpy(table, table_, capa_ * sizeof(Entry));
+   memset(table + capa_, 0, (capa - capa_) * sizeof(Entry));
+
+   delete[] table_;
+
+   table_ = table;
+   capa_ = capa;
+}
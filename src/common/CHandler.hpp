@@ -36,7 +36,6 @@
 #include <sys/types.h>
 #include <sys/poll.h>
 #include <sys/time.h>
-#include <sys/timerfd.h>
 
 // unix sockets
 #include <sys/un.h>
@@ -81,11 +80,6 @@ namespace DSI
       enum { poll_mask = POLLOUT };
    };
 
-   struct TimerEventTraits
-   {
-      enum { poll_mask = POLLIN };
-   };
-
 
 
    class EventBase
@@ -424,60 +418,6 @@ namespace DSI
       AcceptCompletionRoutineT func_;
    };
 
-   template<typename TimerTimeoutRoutineT>
-   class NativeTimerEvent : public EventBase
-   {
-   public:
-      typedef TimerEventTraits traits_type;
-      typedef NormalDescriptorTraits::fd_type fd_type;    // need fd_type here only so we can use the base class
-
-      inline
-      NativeTimerEvent(unsigned int timeout_ms, TimerTimeoutRoutineT func)
-         : timeout_ms_(timeout_ms)
-         , func_(func)
-      {
-         // NOOP
-      }
-
-
-      bool arm(int fd)
-      {
-         struct itimerspec spec;
-         ::memset(&spec, 0, sizeof(spec));
-         spec.it_value.tv_sec = timeout_ms_ / 1000;
-         spec.it_value.tv_nsec = (timeout_ms_ % 1000) * 1000000;
-
-         return ::timerfd_settime(fd, 0, &spec, 0) == 0;
-      }
-
-
-      bool eval(int fd, short revents)
-      {
-         bool rc = false;
-
-         if (revents & (POLLERR|POLLHUP|POLLRDHUP))
-         {
-            rc = func_(io::unspecified);
-         }
-         else if (revents & POLLNVAL)
-         {
-            rc = func_(io::bad_filedescriptor);
-         }
-         else
-         {
-            char buf[8];
-            rc = func_(::read(fd, buf, sizeof(buf)) == sizeof(buf) ? io::ok : io::to_error_code(errno));
-         }
-
-         if (rc)
-            rc = arm(fd);
-
-         return rc;
-      }
-
-      unsigned int timeout_ms_;
-      TimerTimeoutRoutineT func_;
-   };
 }//namespace DSI
 
 #include "CHandlerT.hpp"
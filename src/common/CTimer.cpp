@@ -10,21 +10,13 @@
 
 
 DSI::NativeTimer::NativeTimer(Dispatcher& dispatcher)
- : Device<NormalDescriptorTraits>(dispatcher)
+ : wheel_(dispatcher.timers())
 {
-   assert(&dispatcher);
-   fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC);
+   // NOOP
 }
 
 
 DSI::NativeTimer::~NativeTimer()
 {
-   if (is_open())
-   {
-      this->dispatcher_->removeAll(*this);
-      while(::close(fd_) && errno == EINTR);
-   }
+   // NOOP, the timer cancels itself
 }
-
-
-
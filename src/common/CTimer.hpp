@@ -46,15 +46,17 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include "CDevices.hpp"
+#include "TimerWheel.hpp"
 
 
 
 namespace DSI
 {
    /**
-    * A native multiplexer dispatchable timer.
+    * A dispatchable timer. All timers of a dispatcher share its timer wheel and therefore
+    * a single timerfd, starting a timer does usually not need a syscall.
     */
-   struct NativeTimer : public Device<NormalDescriptorTraits>, public DSI::Private::CNonCopyable
+   struct NativeTimer : public DSI::Private::CNonCopyable
    {
    public:
 
@@ -63,22 +65,42 @@ namespace DSI
 
       ~NativeTimer();
 
+      /**
+       * (Re)start the timer. The routine is called with the error code and returns true if the timer
+       * should be restarted with the same timeout.
+       */
       template<typename TimerTimeoutRoutineT>
       io::error_code start(unsigned int timeout_ms, TimerTimeoutRoutineT func)
       {
-         io::error_code rc = io::unspecified;
-         NativeTimerEvent<TimerTimeoutRoutineT>* e = new NativeTimerEvent<TimerTimeoutRoutineT>(timeout_ms, func);
-
-         if (e->arm(fd_))
-         {
-            this->dispatcher_->enqueueEvent(fd_, e);
-            rc = io::ok;
-         }
-         else
-            delete e;
-
-         return rc;
+         wheel_.start(timer_, timeout_ms, func);
+         return io::ok;
       }
+
+      /**
+       * Restart the timer with its last timeout.
+       */
+      inline
+      void restart()
+      {
+         wheel_.restart(timer_);
+      }
+
+      inline
+      void cancel()
+      {
+         wheel_.cancel(timer_);
+      }
+
+      inline
+      bool isActive() const
+      {
+         return timer_.isActive();
+      }
+
+   private:
+
+      TimerWheel& wheel_;
+      TimerWheel::Timer timer_;
    };
 }//namespace DSI
 
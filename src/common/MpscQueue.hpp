@@ -0,0 +1,129 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_COMMON_MPSCQUEUE_HPP
+#define DSI_COMMON_MPSCQUEUE_HPP
+
+
+#include "dsi/private/CNonCopyable.hpp"
+
+
+namespace DSI
+{
+
+   /**
+    * Unbounded lock-free queue for many producer threads and exactly one consumer thread.
+    * Producers only exchange the head pointer atomically, the consumer never competes with
+    * them. A node pushed may become visible to the consumer a little bit later than the
+    * push() returned on multi-processor machines, so the consumer must be woken up separately
+    * if it should not miss the element.
+    *
+    * @c T must be default constructible and copyable.
+    */
+   template<typename T>
+   class MpscQueue : public Private::CNonCopyable
+   {
+      struct Node
+      {
+         inline
+         Node()
+          : next(0)
+          , value()
+         {
+            // NOOP
+         }
+
+         explicit inline
+         Node(const T& t)
+          : next(0)
+          , value(t)
+         {
+            // NOOP
+         }
+
+         Node* volatile next;
+         T value;
+      };
+
+   public:
+
+      inline
+      MpscQueue()
+       : mHead(new Node)
+       , mTail(mHead)
+      {
+         // NOOP
+      }
+
+
+      inline
+      ~MpscQueue()
+      {
+         while(mTail)
+         {
+            Node* next = mTail->next;
+            delete mTail;
+            mTail = next;
+         }
+      }
+
+
+      /// may be called from any thread
+      inline
+      void push(const T& t)
+      {
+         Node* node = new Node(t);
+
+         // make the node content visible before the node is linked
+         __sync_synchronize();
+
+         Node* prev = __sync_lock_test_and_set(&mHead, node);
+         prev->next = node;
+      }
+
+
+      /// must only be called from the consumer thread
+      inline
+      bool pop(T& t)
+      {
+         Node* next = mTail->next;
+
+         if (next)
+         {
+            __sync_synchronize();
+
+            t = next->value;
+            next->value = T();
+
+            delete mTail;
+            mTail = next;
+
+            return true;
+         }
+
+         return false;
+      }
+
+
+      /// must only be called from the consumer thread
+      inline
+      bool empty() const
+      {
+         return mTail->next == 0;
+      }
+
+
+   private:
+
+      Node* volatile mHead;   ///< last pushed node, shared by all producers
+      Node* mTail;            ///< already consumed dummy node, owned by the consumer
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_COMMON_MPSCQUEUE_HPP
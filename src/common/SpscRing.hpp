@@ -0,0 +1,106 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_COMMON_SPSCRING_HPP
+#define DSI_COMMON_SPSCRING_HPP
+
+
+#include "dsi/private/CNonCopyable.hpp"
+#include "dsi/private/static_assert.hpp"
+
+
+namespace DSI
+{
+
+   /**
+    * Bounded lock-free ring for exactly one producer thread and exactly one consumer thread.
+    * Each side only writes its own index, the other one is read to detect a full respectively
+    * an empty ring.
+    *
+    * @c T must be default constructible and copyable, @c N must be a power of two.
+    */
+   template<typename T, unsigned int N>
+   class SpscRing : public Private::CNonCopyable
+   {
+   public:
+
+      inline
+      SpscRing()
+       : mHead(0)
+       , mTail(0)
+      {
+         DSI_STATIC_ASSERT(N > 0 && (N & (N - 1)) == 0);
+      }
+
+
+      /// must only be called from the producer thread, @return false if the ring is full
+      inline
+      bool push(const T& t)
+      {
+         const unsigned int head = mHead;
+
+         if (head - mTail == N)
+            return false;
+
+         mData[head & (N - 1)] = t;
+
+         // make the element visible before the index is published
+         __sync_synchronize();
+         mHead = head + 1;
+
+         return true;
+      }
+
+
+      /// must only be called from the consumer thread, @return false if the ring is empty
+      inline
+      bool pop(T& t)
+      {
+         const unsigned int tail = mTail;
+
+         if (tail == mHead)
+            return false;
+
+         __sync_synchronize();
+         t = mData[tail & (N - 1)];
+         mData[tail & (N - 1)] = T();
+
+         // the slot must be read before the producer may overwrite it
+         __sync_synchronize();
+         mTail = tail + 1;
+
+         return true;
+      }
+
+
+      /// number of elements, only a snapshot if called concurrently
+      inline
+      unsigned int size() const
+      {
+         return mHead - mTail;
+      }
+
+
+      static inline
+      unsigned int capacity()
+      {
+         return N;
+      }
+
+
+   private:
+
+      T mData[N];
+
+      volatile unsigned int mHead;   ///< next slot to write, owned by the producer
+      volatile unsigned int mTail;   ///< next slot to read, owned by the consumer
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_COMMON_SPSCRING_HPP
@@ -0,0 +1,433 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "TimerWheel.hpp"
+
+#include <time.h>
+#include <sys/timerfd.h>
+#include <algorithm>
+
+#include "CDispatcher.hpp"
+
+
+namespace /*anonymous*/
+{
+
+   const uint64_t Disarmed = ~(uint64_t)0;
+
+   uint64_t monotonic_ms()
+   {
+      struct timespec ts;
+      ::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+      return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+   }
+
+}   // namespace anonymous
+
+
+DSI::TimerWheel::Timer::Timer()
+ : wheel_(0)
+ , expires_(0)
+ , level_(0)
+ , timeout_ms_(0)
+{
+   next_ = 0;
+   prev_ = 0;
+}
+
+
+DSI::TimerWheel::Timer::~Timer()
+{
+   if (wheel_)
+      wheel_->cancel(*this);
+}
+
+
+// --------------------------------------------------------------------------------
+
+
+DSI::TimerWheel::TimerWheel(Dispatcher& dispatcher, unsigned int resolution_ms)
+ : dispatcher_(dispatcher)
+ , fd_(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC))
+ , resolution_ms_(resolution_ms > 0 ? resolution_ms : 1)
+ , origin_ms_(monotonic_ms())
+ , current_(0)
+ , armed_(Disarmed)
+ , size_(0)
+ , running_(0)
+ , dispatching_(false)
+{
+   for (unsigned int level=0; level<Levels; ++level)
+   {
+      count_[level] = 0;
+
+      for (unsigned int slot=0; slot<Slots; ++slot)
+         init(wheel_[level][slot]);
+   }
+
+   if (fd_ >= 0)
+      dispatcher_.enqueueEvent(fd_, new GenericEvent<std::tr1::function<bool(GenericEventBase::Result)> >(
+                                  std::tr1::bind(&TimerWheel::handleTimeout, this, std::tr1::placeholders::_1)), POLLIN);
+}
+
+
+DSI::TimerWheel::~TimerWheel()
+{
+   for (unsigned int level=0; level<Levels; ++level)
+   {
+      for (unsigned int slot=0; slot<Slots; ++slot)
+      {
+         List& list = wheel_[level][slot];
+
+         while(list.next_ != &list)
+         {
+            Timer& timer = static_cast<Timer&>(*list.next_);
+
+            unlink(timer);
+            timer.wheel_ = 0;
+         }
+      }
+   }
+
+   if (fd_ >= 0)
+   {
+      dispatcher_.removeAll(fd_);
+      while(::close(fd_) && errno == EINTR);
+   }
+}
+
+
+void DSI::TimerWheel::init(List& list)
+{
+   list.next_ = &list;
+   list.prev_ = &list;
+}
+
+
+void DSI::TimerWheel::link(List& list, Link& node)
+{
+   node.next_ = &list;
+   node.prev_ = list.prev_;
+
+   list.prev_->next_ = &node;
+   list.prev_ = &node;
+}
+
+
+void DSI::TimerWheel::unlink(Link& node)
+{
+   node.prev_->next_ = node.next_;
+   node.next_->prev_ = node.prev_;
+
+   node.next_ = 0;
+   node.prev_ = 0;
+}
+
+
+uint64_t DSI::TimerWheel::now() const
+{
+   return (monotonic_ms() - origin_ms_) / resolution_ms_;
+}
+
+
+void DSI::TimerWheel::start(Timer& timer, unsigned int timeout_ms, const callback_type& func)
+{
+   if (timer.wheel_ && timer.wheel_ != this)
+      timer.wheel_->cancel(timer);
+
+   timer.func_ = func;
+   timer.timeout_ms_ = timeout_ms;
+
+   restart(timer);
+}
+
+
+void DSI::TimerWheel::restart(Timer& timer)
+{
+   cancel(timer);
+
+   const uint64_t elapsed_ms = monotonic_ms() - origin_ms_;
+   const uint64_t tick = elapsed_ms / resolution_ms_;
+
+   // nothing to evaluate in between
+   if (size_ == 0 && current_ < tick)
+      current_ = tick;
+
+   // round up, the timer must not expire early
+   const uint64_t expires = (elapsed_ms + timer.timeout_ms_ + resolution_ms_ - 1) / resolution_ms_;
+
+   timer.wheel_ = this;
+   timer.expires_ = expires > tick ? expires : tick + 1;
+
+   insert(timer);
+
+   // the timerfd is armed again after the evaluation of the expired timers
+   if (!dispatching_)
+   {
+      const uint64_t next = due(timer.level_, slotIndex(timer));
+
+      if (next < armed_)
+         schedule(next);
+   }
+}
+
+
+void DSI::TimerWheel::cancel(Timer& timer)
+{
+   if (&timer == running_)
+      running_ = 0;
+
+   if (timer.isActive())
+   {
+      unlink(timer);
+
+      --count_[timer.level_];
+      --size_;
+   }
+
+   // a detached timer must not refer to the wheel, which may be gone at its destruction
+   if (timer.wheel_ == this)
+      timer.wheel_ = 0;
+}
+
+
+uint64_t DSI::TimerWheel::slotIndex(const Timer& timer) const
+{
+   const uint64_t max = ((uint64_t)1 << (Bits * Levels)) - 1;
+
+   // timers beyond the range of the wheel cascade from the highest level until they fit
+   uint64_t delta = timer.expires_ - current_;
+   if (delta > max)
+      delta = max;
+
+   return (current_ + delta) >> (Bits * timer.level_);
+}
+
+
+uint64_t DSI::TimerWheel::due(unsigned int level, uint64_t index)
+{
+   // level 0 expires at the tick itself, higher levels cascade at the start of their slot
+   return index << (Bits * level);
+}
+
+
+void DSI::TimerWheel::insert(Timer& timer)
+{
+   const uint64_t max = ((uint64_t)1 << (Bits * Levels)) - 1;
+
+   uint64_t delta = timer.expires_ - current_;
+   if (delta > max)
+      delta = max;
+
+   unsigned int level = 0;
+   while(level < Levels - 1 && delta >= ((uint64_t)1 << (Bits * (level + 1))))
+      ++level;
+
+   timer.level_ = level;
+
+   link(wheel_[level][slotIndex(timer) & Mask], timer);
+
+   ++count_[level];
+   ++size_;
+}
+
+
+unsigned int DSI::TimerWheel::cascade(unsigned int level)
+{
+   const unsigned int slot = (current_ >> (Bits * level)) & Mask;
+
+   List& list = wheel_[level][slot];
+
+   List pending;
+   init(pending);
+
+   // all these timers expire within the range of the lower levels now
+   while(list.next_ != &list)
+   {
+      Link& node = *list.next_;
+
+      unlink(node);
+      link(pending, node);
+   }
+
+   while(pending.next_ != &pending)
+   {
+      Timer& timer = static_cast<Timer&>(*pending.next_);
+
+      unlink(timer);
+      --count_[level];
+      --size_;
+
+      insert(timer);
+   }
+
+   return slot;
+}
+
+
+void DSI::TimerWheel::advance()
+{
+   const uint64_t tick = now();
+
+   while(current_ <= tick)
+   {
+      if (size_ == 0)
+      {
+         current_ = tick + 1;
+         break;
+      }
+
+      const unsigned int slot = current_ & Mask;
+
+      // nothing expires before the next cascade
+      if (count_[0] == 0 && slot != 0)
+      {
+         current_ = std::min((current_ + Mask) & ~(uint64_t)Mask, tick + 1);
+         continue;
+      }
+
+      if (slot == 0)
+      {
+         for (unsigned int level=1; level<Levels && cascade(level) == 0; ++level);
+      }
+
+      List expired;
+      init(expired);
+
+      List& list = wheel_[0][slot];
+
+      while(list.next_ != &list)
+      {
+         Link& node = *list.next_;
+
+         unlink(node);
+         link(expired, node);
+      }
+
+      // timers restarted from within the callbacks are inserted behind this tick
+      ++current_;
+
+      expire(expired);
+   }
+}
+
+
+void DSI::TimerWheel::expire(List& list)
+{
+   while(list.next_ != &list)
+   {
+      Timer& timer = static_cast<Timer&>(*list.next_);
+
+      unlink(timer);
+      --count_[0];
+      --size_;
+
+      // the callback may destroy the timer
+      callback_type func(timer.func_);
+
+      // the timer stays attached during the callback, so its destruction resets running_
+      running_ = &timer;
+      const bool rc = func(io::ok);
+
+      if (running_ == &timer)
+      {
+         running_ = 0;
+
+         if (rc && !timer.isActive())
+            restart(timer);
+         else if (!timer.isActive())
+            timer.wheel_ = 0;
+      }
+   }
+}
+
+
+void DSI::TimerWheel::arm()
+{
+   uint64_t next = Disarmed;
+
+   if (count_[0] > 0)
+   {
+      for (unsigned int i=0; i<Slots; ++i)
+      {
+         const List& list = wheel_[0][(current_ + i) & Mask];
+
+         if (list.next_ != &list)
+         {
+            next = current_ + i;
+            break;
+         }
+      }
+   }
+
+   for (unsigned int level=1; level<Levels; ++level)
+   {
+      if (count_[level] > 0)
+      {
+         // the slot of the current index is cascaded right now if the lower levels are at their start
+         const uint64_t index = current_ >> (Bits * level);
+         const bool aligned = (current_ & (((uint64_t)1 << (Bits * level)) - 1)) == 0;
+
+         for (unsigned int i=aligned ? 0 : 1; i<=Slots; ++i)
+         {
+            const List& list = wheel_[level][(index + i) & Mask];
+
+            if (list.next_ != &list)
+            {
+               next = std::min(next, due(level, index + i));
+               break;
+            }
+         }
+      }
+   }
+
+   if (next != armed_)
+      schedule(next);
+}
+
+
+void DSI::TimerWheel::schedule(uint64_t tick)
+{
+   struct itimerspec spec;
+   ::memset(&spec, 0, sizeof(spec));
+
+   if (tick != Disarmed)
+   {
+      const uint64_t ms = origin_ms_ + tick * resolution_ms_;
+
+      spec.it_value.tv_sec = ms / 1000;
+      spec.it_value.tv_nsec = (ms % 1000) * 1000000;
+   }
+
+   (void)::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, 0);
+   armed_ = tick;
+}
+
+
+bool DSI::TimerWheel::handleTimeout(GenericEventBase::Result result)
+{
+   if (result == GenericEventBase::DataAvailable)
+   {
+      uint64_t expirations;
+      (void)::read(fd_, &expirations, sizeof(expirations));
+
+      // the one-shot timerfd is disarmed now
+      armed_ = Disarmed;
+
+      dispatching_ = true;
+      advance();
+      dispatching_ = false;
+
+      arm();
+
+      return true;
+   }
+
+   // the timers will not expire any more
+   return false;
+}
@@ -0,0 +1,175 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_COMMON_TIMERWHEEL_HPP
+#define DSI_COMMON_TIMERWHEEL_HPP
+
+
+#include <stdint.h>
+#include <tr1/functional>
+
+#include "dsi/private/CNonCopyable.hpp"
+
+#include "iobase.hpp"
+#include "CHandler.hpp"
+
+
+namespace DSI
+{
+   // forward decl
+   class Dispatcher;
+
+
+   /**
+    * Hierarchical timer wheel multiplexing any number of timers on a single timerfd of a dispatcher.
+    * Starting, restarting and cancelling a timer is O(1) and does not need a syscall unless the timer
+    * expires before all other ones. The timerfd is armed for the next occupied slot of the lowest
+    * level respectively the next cascade of the higher levels only.
+    *
+    * Timers expire at the earliest after their timeout, at the latest one resolution later.
+    * The wheel must only be used from within the dispatcher's thread. A timer refers to its wheel
+    * only while it is active or its callback is running, so it may outlive the wheel otherwise.
+    */
+   class TimerWheel : public Private::CNonCopyable
+   {
+      /// intrusive doubly linked list node, a list is a circular ring around a sentinel
+      struct Link
+      {
+         Link* next_;
+         Link* prev_;
+      };
+
+   public:
+
+      /// @return true if the timer should be restarted with its last timeout
+      typedef std::tr1::function<bool(io::error_code)> callback_type;
+
+      /**
+       * A timer slot, cancelled on destruction. The callback may destroy the timer.
+       */
+      class Timer : private Link, public Private::CNonCopyable
+      {
+         friend class TimerWheel;
+
+      public:
+
+         Timer();
+
+         ~Timer();
+
+         inline
+         bool isActive() const
+         {
+            return next_ != 0;
+         }
+
+      private:
+
+         TimerWheel* wheel_;
+
+         uint64_t expires_;        ///< in ticks
+         unsigned int level_;
+         unsigned int timeout_ms_;
+
+         callback_type func_;
+      };
+
+
+      /**
+       * @param resolution_ms Granularity of the timeouts.
+       */
+      explicit
+      TimerWheel(Dispatcher& dispatcher, unsigned int resolution_ms = 10);
+
+      /**
+       * Cancels all timers, their callbacks are not called.
+       */
+      ~TimerWheel();
+
+      /**
+       * (Re)start the timer with a new timeout and callback.
+       */
+      void start(Timer& timer, unsigned int timeout_ms, const callback_type& func);
+
+      /**
+       * Restart the timer with its last timeout and callback.
+       */
+      void restart(Timer& timer);
+
+      void cancel(Timer& timer);
+
+      /// @return the number of active timers
+      inline
+      size_t size() const
+      {
+         return size_;
+      }
+
+   private:
+
+      enum { Bits = 6, Slots = 1 << Bits, Mask = Slots - 1, Levels = 4 };
+
+      typedef Link List;
+
+      static void init(List& list);
+      static void link(List& list, Link& node);
+      static void unlink(Link& node);
+
+      void insert(Timer& timer);
+
+      /// @return the absolute slot index of the timer within its level
+      uint64_t slotIndex(const Timer& timer) const;
+
+      /// @return the tick at which the given absolute slot index of the level needs evaluation
+      static uint64_t due(unsigned int level, uint64_t index);
+
+      /// move all timers of the given higher level slot down the wheel, @return the slot index
+      unsigned int cascade(unsigned int level);
+
+      /// evaluate all ticks up to the current time
+      void advance();
+
+      void expire(List& list);
+
+      /// (re)arm the timerfd for the next tick which needs evaluation, disarm if empty
+      void arm();
+
+      /// set the timerfd to the given tick
+      void schedule(uint64_t tick);
+
+      uint64_t now() const;
+
+      bool handleTimeout(GenericEventBase::Result result);
+
+      Dispatcher& dispatcher_;
+      int fd_;
+
+      unsigned int resolution_ms_;
+      uint64_t origin_ms_;
+
+      /// the next tick to evaluate
+      uint64_t current_;
+
+      /// the tick the timerfd is armed for
+      uint64_t armed_;
+
+      size_t size_;
+      size_t count_[Levels];
+
+      List wheel_[Levels][Slots];
+
+      /// the timer whose callback is currently called
+      Timer* running_;
+
+      /// expired timers are evaluated, the timerfd is armed afterwards
+      bool dispatching_;
+   };
+
+}//namespace DSI
+
+
+#endif   // DSI_COMMON_TIMERWHEEL_HPP
@@ -265,6 +265,85 @@ public class DataType extends BaseObject
 
    /* ************************************************************ */
 
+   /**
+    * @return the size of an integer or floating point value on the stream, 0 for all other types
+    */
+   public int getStreamSize()
+   {
+      if( isSimpleTypedef() )
+      {
+         return getBaseType().getStreamSize();
+      }
+
+      if( isInteger() )
+      {
+         return Integer.parseInt( mFuncName ) / 8 ;
+      }
+      else if( isFloat() )
+      {
+         return mName.equals("Double") ? 8 : 4 ;
+      }
+      return 0 ;
+   }
+
+   /* ************************************************************ */
+
+   /**
+    * @return the size of the largest field of a trivially streamable structure
+    */
+   public int getStreamAlignment()
+   {
+      int alignment = 1 ;
+      for( Value field : mFields )
+      {
+         alignment = Math.max( alignment, field.getDataType().getStreamSize() );
+      }
+      return alignment ;
+   }
+
+   /* ************************************************************ */
+
+   /**
+    * @return the sum of all field sizes of a trivially streamable structure
+    */
+   public int getStreamLength()
+   {
+      int length = 0 ;
+      for( Value field : mFields )
+      {
+         length += field.getDataType().getStreamSize();
+      }
+      return length ;
+   }
+
+   /* ************************************************************ */
+
+   /**
+    * @return true if the structure only consists of integer and floating point fields which
+    *         need no padding on the stream, so its memory layout equals the stream layout
+    */
+   public boolean isTriviallyStreamable()
+   {
+      if( !isStructure() || mFields.isEmpty() )
+      {
+         return false ;
+      }
+
+      int offset = 0 ;
+      for( Value field : mFields )
+      {
+         int size = field.getDataType().getStreamSize();
+         if( 0 == size || 0 != offset % size )
+         {
+            return false ;
+         }
+         offset += size ;
+      }
+      return 0 == offset % getStreamAlignment() ;
+   }
+
+   /* ************************************************************ */
+
    /**
     * @ return true if the DataType is a complex type
     */
@@ -27,6 +27,8 @@ ClientSpecificData::~ClientSpecificData()
 
 void ClientSpecificData::clear(bool isSlave)
 {   
+   std::vector<std::string> removedInterfaces ;
+
    for(PartyIDList::const_iterator iter = mServerList.begin(); iter != mServerList.end(); ++iter)
    {
       SPartyID serverID = *iter;
@@ -35,6 +37,8 @@ void ClientSpecificData::clear(bool isSlave)
       ServerListEntry *entry = Servicebroker::getInstance().mConnectedServers.find( serverID );
       if( entry )
       {
+         removedInterfaces.push_back( entry->ifDescription.name );
+
          Servicebroker::getInstance().unregisterInterfaceMaster( *entry );
          Servicebroker::getInstance().mConnectedServers.remove( serverID );
          Servicebroker::getInstance().mAttachedClients.removeServer(serverID);
@@ -60,7 +64,6 @@ void ClientSpecificData::clear(bool isSlave)
       }
    }
 
-   bool bServerListChanged = ( 0 != mServerList.size() ) ;
 
    /* Server IDs owned by this connection are invalid now. Send notifications. */
    Servicebroker::getInstance().mServerDisconnectNotifications.trigger( mServerList );
@@ -87,9 +90,9 @@ void ClientSpecificData::clear(bool isSlave)
    Servicebroker::getInstance().mServerConnectNotifications.remove( mNotificationList );
    Servicebroker::getInstance().mServerListChangeNotifications.remove( mNotificationList );
 
-   if( bServerListChanged )
+   if( !removedInterfaces.empty() )
    {
       /* triger serverlist change notifications */
-      Servicebroker::getInstance().mServerListChangeNotifications.triggerAll();
+      Servicebroker::getInstance().mServerListChangeNotifications.triggerAll( removedInterfaces );
    }
 }
@@ -0,0 +1,122 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "GroupCache.hpp"
+
+#include <time.h>
+#include <pwd.h>
+#include <grp.h>
+
+#include "config.h"
+#include "Log.hpp"
+
+
+namespace /*anonymous*/
+{
+
+inline
+unsigned long long getMonotonicTimeMs()
+{
+   struct timespec ts;
+   (void)::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return 1000ULL * ts.tv_sec + ts.tv_nsec / 1000000;
+}
+
+}   // namespace anonymous
+
+
+GroupCache::GroupCache()
+ : mTimeout(SB_GROUPCACHE_TIMEOUT)
+ , mReadCounter(0)
+{
+   // NOOP
+}
+
+
+GroupCache& GroupCache::getInstance()
+{
+   static GroupCache cache;
+   return cache;
+}
+
+
+const GroupCache::Group& GroupCache::group(gid_t gid)
+{
+   const unsigned long long now = getMonotonicTimeMs();
+
+   Group& entry = mGroups[gid];
+   if (entry.expires <= now)
+   {
+      entry.expires = now + mTimeout;
+      ++mReadCounter;
+      entry.name.clear();
+      entry.members.clear();
+
+      ::group* gr = ::getgrgid(gid);
+      if (gr)
+      {
+         entry.name = gr->gr_name;
+
+         for (char** p = gr->gr_mem; *p; p++)
+         {
+            passwd* pw = ::getpwnam(*p);
+            if (pw)
+            {
+               (void)entry.members.insert(pw->pw_uid);
+            }
+         }
+      }
+
+      Log::message(3, " Group %d read, %u members", (int)gid, (unsigned int)entry.members.size());
+   }
+
+   return entry;
+}
+
+
+bool GroupCache::isMember(gid_t gid, uid_t uid)
+{
+   const Group& entry = group(gid);
+   return entry.members.find(uid) != entry.members.end();
+}
+
+
+const char* GroupCache::getGroupName(gid_t gid)
+{
+   const Group& entry = group(gid);
+   return entry.name.empty() ? "<unknown>" : entry.name.c_str();
+}
+
+
+const char* GroupCache::getUserName(uid_t uid)
+{
+   const unsigned long long now = getMonotonicTimeMs();
+
+   User& entry = mUsers[uid];
+   if (entry.expires <= now)
+   {
+      entry.expires = now + mTimeout;
+      ++mReadCounter;
+      entry.name.clear();
+
+      passwd* pw = ::getpwuid(uid);
+      if (pw)
+      {
+         entry.name = pw->pw_name;
+      }
+   }
+
+   return entry.name.empty() ? "<unknown>" : entry.name.c_str();
+}
+
+
+void GroupCache::clear()
+{
+   mGroups.clear();
+   mUsers.clear();
+}
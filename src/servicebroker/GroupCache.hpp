@@ -0,0 +1,114 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_SERVICEBROKER_GROUPCACHE_HPP
+#define DSI_SERVICEBROKER_GROUPCACHE_HPP
+
+
+#include <sys/types.h>
+
+#include <string>
+#include <tr1/unordered_map>
+#include <tr1/unordered_set>
+
+
+/**
+ * Caches the group memberships and user names needed for the access checks of the servicebroker.
+ * The user and group databases may be backed by slow name services, so they are only queried
+ * the first time a group or user is needed and again after the entry expired, see
+ * @c SB_GROUPCACHE_TIMEOUT.
+ *
+ * Must only be used from the main thread of the servicebroker.
+ */
+class GroupCache
+{
+public:
+
+   /**
+    * Singleton.
+    */
+   static GroupCache& getInstance();
+
+   /**
+    * @return true if the user is listed as member of the group.
+    */
+   bool isMember(gid_t gid, uid_t uid);
+
+   /**
+    * @return the name of the user or "<unknown>". The pointer is valid until the next call.
+    */
+   const char* getUserName(uid_t uid);
+
+   /**
+    * @return the name of the group or "<unknown>". The pointer is valid until the next call.
+    */
+   const char* getGroupName(gid_t gid);
+
+   /**
+    * Drop all cached entries, they are read again on their next use.
+    */
+   void clear();
+
+   /**
+    * Set the lifetime of newly read entries in milliseconds, @c SB_GROUPCACHE_TIMEOUT by default.
+    */
+   void setTimeout(unsigned int timeout);
+
+   /**
+    * @return the number of group and user database reads since startup.
+    */
+   unsigned int getReadCounter() const;
+
+private:
+
+   struct Group
+   {
+      Group() : expires(0) {}
+
+      unsigned long long expires;
+      std::string name;                           ///< empty if the group does not exist
+      std::tr1::unordered_set<uid_t> members;
+   };
+
+   struct User
+   {
+      User() : expires(0) {}
+
+      unsigned long long expires;
+      std::string name;                           ///< empty if the user does not exist
+   };
+
+   GroupCache();
+
+   GroupCache(const GroupCache&);
+   GroupCache& operator=(const GroupCache&);
+
+   const Group& group(gid_t gid);
+
+   std::tr1::unordered_map<gid_t, Group> mGroups;
+   std::tr1::unordered_map<uid_t, User> mUsers;
+
+   unsigned int mTimeout;
+   unsigned int mReadCounter;
+};
+
+
+inline
+void GroupCache::setTimeout(unsigned int timeout)
+{
+   mTimeout = timeout;
+}
+
+
+inline
+unsigned int GroupCache::getReadCounter() const
+{
+   return mReadCounter;
+}
+
+
+#endif   // DSI_SERVICEBROKER_GROUPCACHE_HPP
@@ -7,6 +7,8 @@
 ****************************************************************/
 #include "JobQueue.hpp"
 
+#include <new>
+
 #include "LockGuard.hpp"
 
 #include "MessageContext.hpp"
@@ -16,6 +18,36 @@
 
 using namespace DSI;
 
+
+namespace /*anonymous*/
+{
+
+   /*
+    * Payload size classes of pooled jobs, larger jobs are allocated and freed directly.
+    * Jobs are only created and freed by the servicebroker thread, so the free lists need no lock.
+    */
+   const size_t sizeClasses[] = { 64, 256, 1024, 4096 };
+   const int sizeClassCount = sizeof(sizeClasses) / sizeof(sizeClasses[0]);
+
+   // maximum number of free jobs kept per size class
+   const unsigned int maxFreeJobs = 64;
+
+   /// link of a pooled job's memory in its free list, placed where the destructed job lived
+   struct FreeJob
+   {
+      FreeJob* next;
+   };
+
+   FreeJob* freeList[sizeClassCount] = { 0 };
+   unsigned int freeCount[sizeClassCount] = { 0 };
+
+   unsigned int currentCounter = 0;
+   unsigned int totalCounter = 0;
+   unsigned int reusedCounter = 0;
+
+}   // namespace anonymous
+
+
 Job::Job(int theCookie, SocketMessageContext* theCtx, dcmd_t theDcmd, size_t theSbytes, size_t theRbytes)
  : cookie(theCookie)
  , ctx()
@@ -26,6 +58,7 @@ Job::Job(int theCookie, SocketMessageContext* theCtx, dcmd_t theDcmd, size_t the
  , rbytes(theRbytes)
  , next(0)
  , arg(0)
+ , sizeClass(-1)
 {
    if( rbytes > 0 || sbytes > 0 )
       arg = this+1 ;
@@ -35,13 +68,55 @@ Job::Job(int theCookie, SocketMessageContext* theCtx, dcmd_t theDcmd, size_t the
 }
 
 
+/*static*/
+void* Job::allocate(size_t payload, int& theSizeClass)
+{
+   void* mem = 0;
+   theSizeClass = -1;
+
+   for (int idx=0; idx<sizeClassCount; ++idx)
+   {
+      if (payload <= sizeClasses[idx])
+      {
+         theSizeClass = idx;
+
+         if (freeList[idx])
+         {
+            FreeJob* node = freeList[idx];
+            freeList[idx] = node->next;
+            mem = node;
+            --freeCount[idx];
+            ++reusedCounter;
+         }
+         else
+            mem = ::malloc( sizeof(Job) + sizeClasses[idx] );
+
+         break;
+      }
+   }
+
+   if (theSizeClass < 0)
+      mem = ::malloc( sizeof(Job) + payload );
+
+   if (mem)
+   {
+      ++currentCounter;
+      ++totalCounter;
+   }
+
+   return mem;
+}
+
+
 /*static*/
 Job* Job::create( SocketMessageContext& msg, int theCookie, dcmd_t theDcmd, void* parg, size_t theSbytes, size_t theRbytes)
 {
-   Job* job = (Job*) ::malloc( sizeof(Job) + static_cast<size_t>(__max(theSbytes, theRbytes)) );
+   int theSizeClass;
+   Job* job = (Job*) allocate( static_cast<size_t>(__max(theSbytes, theRbytes)), theSizeClass );
    if( job )
    {
       new(job) Job(theCookie, &msg, theDcmd, theSbytes, theRbytes);
+      job->sizeClass = theSizeClass;
       memset( job+1, 0, __max(theSbytes, theRbytes) );
 
       if( theSbytes > 0 )
@@ -55,10 +130,12 @@ Job* Job::create( SocketMessageContext& msg, int theCookie, dcmd_t theDcmd, void
 /*static*/
 Job* Job::create( int theCookie, dcmd_t theDcmd, void* parg, size_t theSbytes, size_t theRbytes)
 {
-   Job* job = (Job*) ::malloc( sizeof(Job) + static_cast<size_t>(__max(theSbytes, theRbytes)) );
+   int theSizeClass;
+   Job* job = (Job*) allocate( static_cast<size_t>(__max(theSbytes, theRbytes)), theSizeClass );
    if( job )
    {
       new(job) Job(theCookie, 0, theDcmd, theSbytes, theRbytes);
+      job->sizeClass = theSizeClass;
       memset( job+1, 0, __max(theSbytes, theRbytes) );
 
       if( theSbytes > 0 )
@@ -71,8 +148,41 @@ Job* Job::create( int theCookie, dcmd_t theDcmd, void* parg, size_t theSbytes, s
 
 void Job::free()
 {
+   const int theSizeClass = sizeClass;
+
    this->~Job();
-   ::free( this );
+   --currentCounter;
+
+   if (theSizeClass >= 0 && freeCount[theSizeClass] < maxFreeJobs)
+   {
+      FreeJob* node = new(this) FreeJob;
+      node->next = freeList[theSizeClass];
+      freeList[theSizeClass] = node;
+      ++freeCount[theSizeClass];
+   }
+   else
+      ::free( this );
+}
+
+
+/*static*/
+unsigned int Job::getCurrentCounter()
+{
+   return currentCounter;
+}
+
+
+/*static*/
+unsigned int Job::getTotalCounter()
+{
+   return totalCounter;
+}
+
+
+/*static*/
+unsigned int Job::getReusedCounter()
+{
+   return reusedCounter;
 }
 
 
@@ -101,10 +211,13 @@ const SocketConnectionContext& Job::getConnectionContext()
 
 
 JobQueue::JobQueue()
- : mFront(0)
+ : mRing()
+ , mFront(0)
  , mBack(0)
- , mSize(0)
+ , mOverflowSize(0)
  , mTotalCounter(0)
+ , mPopCounter(0)
+ , mHighWaterMark(0)
 {
    // NOOP
 }
@@ -118,23 +231,30 @@ JobQueue::~JobQueue()
 
 void JobQueue::push(Job* job)
 {
-   LockGuard<RecursiveMutex> lock( mQueueLock );
-
    assert(job);
    assert(!job->next);
 
-   // queue empty?
-   if (mBack == 0)
+   // once the ring overflowed, all jobs take the overflow list until it is empty again, this keeps the order
+   if (mOverflowSize > 0 || !mRing.push(job))
    {
-      mFront = job;
+      LockGuard<RecursiveMutex> lock( mOverflowLock );
+
+      // queue empty?
+      if (mBack == 0)
+      {
+         mFront = job;
+      }
+      else
+         mBack->next = job;
+
+      mBack = job;
+      ++mOverflowSize;
    }
-   else
-      mBack->next = job;
 
-   mBack = job;
-
-   ++mSize;
    ++mTotalCounter;
+
+   if (getSize() > mHighWaterMark)
+      mHighWaterMark = getSize();
 }
 
 
@@ -142,21 +262,26 @@ Job* JobQueue::pop()
 {
    Job* job = 0;
 
-   LockGuard<RecursiveMutex> lock( mQueueLock );
-
-   if (mFront)
+   if (!mRing.pop(job) && mOverflowSize > 0)
    {
-      job = mFront;
-      mFront = job->next;
-      job->next = 0;
+      LockGuard<RecursiveMutex> lock( mOverflowLock );
 
-      // queue now empty?
-      if (!mFront)
-         mBack = 0;
+      if (mFront)
+      {
+         job = mFront;
+         mFront = job->next;
+         job->next = 0;
 
-      --mSize;
+         // queue now empty?
+         if (!mFront)
+            mBack = 0;
+
+         --mOverflowSize;
+      }
    }
 
+   if (job)
+      ++mPopCounter;
+
    return job;
 }
-
@@ -15,8 +15,9 @@
 #include "dsi/private/CNonCopyable.hpp"
 
 #include "RecursiveMutex.hpp"
-#include "RegExp.hpp"
+#include "RegExpCache.hpp"
 #include "SocketMessageContext.hpp"
+#include "SpscRing.hpp"
 
 
 // forward decl
@@ -41,10 +42,19 @@ public:
    static Job* create( int cookie, dcmd_t dcmd, void* parg, size_t sbytes, size_t rbytes = 0 );
 
    /*
-    * free the Job
+    * free the Job, small jobs are kept for reuse
     */
    void free();
 
+   /// @return the number of jobs currently allocated
+   static unsigned int getCurrentCounter();
+
+   /// @return the number of jobs ever created
+   static unsigned int getTotalCounter();
+
+   /// @return the number of jobs created from the free lists
+   static unsigned int getReusedCounter();
+
    void finalize();
 
    ClientSpecificData& getClientSpecificData();
@@ -71,8 +81,8 @@ public:
    // how many bytes to receive
    size_t rbytes;
 
-   // regular expression needed for some calls
-   RegExp regex;
+   // regular expression needed for some calls, shared with the RegExpCache
+   RegExpCache::tRegExpPtr regex;
 
    // this is an intrusive container
    Job* next;
@@ -83,11 +93,19 @@ public:
 private:
 
    Job(int cookie, SocketMessageContext* ctx, dcmd_t dcmd, size_t sbytes, size_t rbytes);
+
+   /// get uninitialized memory for a job with the given payload size
+   static void* allocate(size_t payload, int& sizeClass);
+
+   // index of the free list this job returns to, -1 if it is not pooled
+   int sizeClass;
 };
 
 
 /*
- * the Job Queue
+ * the Job Queue. Jobs are pushed by the servicebroker thread and popped by the worker thread
+ * only. They pass a lock-free ring, only if the ring is full further jobs are appended to a
+ * locked overflow list until the worker thread caught up.
  */
 class JobQueue : public DSI::Private::CNonCopyable
 {
@@ -112,16 +130,27 @@ public:
    ///@return size of the queue
    unsigned int getSize() const;
 
+   ///@return the maximum size the queue ever had
+   unsigned int getHighWaterMark() const;
+
 private:
+
+   enum { Capacity = 1024 };
+
+   DSI::SpscRing<Job*, Capacity> mRing;
+
+   // jobs not fitting into the ring
    Job* mFront;
    Job* mBack;
-   unsigned int mSize;
+   volatile unsigned int mOverflowSize;
 
-   // the critical section that protects the job queue
-   DSI::RecursiveMutex mQueueLock ;
+   // the critical section that protects the overflow list
+   DSI::RecursiveMutex mOverflowLock ;
 
-   //statistical counter
+   //statistical counters, the pop counter is owned by the worker thread
    unsigned int mTotalCounter;
+   volatile unsigned int mPopCounter;
+   unsigned int mHighWaterMark;
 };
 
 
@@ -135,7 +164,14 @@ unsigned int JobQueue::getTotalCounter() const
 inline
 unsigned int JobQueue::getSize() const
 {
-   return mSize;
+   return mTotalCounter - mPopCounter;
+}
+
+
+inline
+unsigned int JobQueue::getHighWaterMark() const
+{
+   return mHighWaterMark;
 }
 
 
@@ -22,7 +22,7 @@
 #include "config.h"
 #include "ServicebrokerServer.hpp"
 
-ServicebrokerServer* pServer;
+extern ServicebrokerServer* pServer;
 
 
 namespace /* anonymous */
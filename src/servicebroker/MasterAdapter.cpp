@@ -27,10 +27,20 @@ using namespace DSI;
 #undef SB_NO_CRITICAL_SECTION
 
 
+namespace /*anonymous*/
+{
+
+   /// request id of the initial ping, a master echoing it evaluates pipelined requests
+   const int32_t PIPELINING_PROBE_ID = 1;
+
+}   // namespace anonymous
+
+
 struct MasterConnectorSocket : public Private::CNonCopyable
 {
    MasterConnectorSocket(const char* address)
       : mConnected(false)
+      , mPipelining(false)
       , mEndpoint(address)
    {
       assert(mEndpoint.getIP() && mEndpoint.getPort());
@@ -75,11 +85,19 @@ struct MasterConnectorSocket : public Private::CNonCopyable
       return mConnected;
    }
 
+   /// @return true if the master evaluates pipelined requests, only valid after sendIdPing
+   inline
+   bool isPipelining() const
+   {
+      return mPipelining;
+   }
+
    inline
    void disconnect()
    {
       (void)mSock.close();
       mConnected = false;
+      mPipelining = false;
    }
 
    inline
@@ -94,7 +112,6 @@ struct MasterConnectorSocket : public Private::CNonCopyable
       return sendAndReceive(mSock.fd(), DCMD_FND_MASTER_PING, NULL, 0, 0, 0) == 0;
    }
 
-   inline
    bool sendIdPing()
    {
       union SFNDMasterPingIdArg data;
@@ -103,14 +120,49 @@ struct MasterConnectorSocket : public Private::CNonCopyable
       data.i.id = Servicebroker::getInstance().id();
       data.i.reserved = 0;
 
-      return sendAndReceive(mSock.fd(), DCMD_FND_MASTER_PING_ID, &data, sizeof(data), 0, 0) == 0;
+      sb_response_frame_t f;
+
+      bool rc = send(DCMD_FND_MASTER_PING_ID, &data, sizeof(data), PIPELINING_PROBE_ID)
+         && receive(f)
+         && receiveBody(0, 0, f.fr_envelope.fr_size);
+
+      // older masters do not echo the request id
+      mPipelining = rc && f.fr_id == PIPELINING_PROBE_ID;
+      Log::message(3, "Master %s pipelined requests", mPipelining ? "accepts" : "does not accept");
+
+      return rc;
    }
 
+   /// send the job's request frame tagged with the given id, the response is not awaited
    inline
-   bool execute(Job& job)
+   bool send(Job& job, int32_t id)
    {
-      job.status = sendAndReceive(mSock.fd(), job.dcmd, job.arg, job.sbytes, job.rbytes, &job.ret_val);
-      bool rc = job.status == 0;
+      return send(job.dcmd, job.arg, job.sbytes, id);
+   }
+
+   /// receive the next response frame header
+   bool receive(sb_response_frame_t& f)
+   {
+      bool rc = recvAll(mSock.fd(), &f, sizeof(f)) == 0
+         && f.fr_envelope.fr_magic == SB_FRAME_MAGIC
+         && f.fr_envelope.fr_size >= 0;
+
+      if (!rc)
+      {
+         int error = errno;
+         Log::error("Master TCP communication failed: errno=%d", error);
+      }
+
+      return rc;
+   }
+
+   /// receive the body of the response frame f into the job and complete the job's status
+   bool complete(Job& job, const sb_response_frame_t& f)
+   {
+      bool rc = receiveBody(job.arg, job.rbytes, f.fr_envelope.fr_size);
+
+      job.status = rc ? 0 : -1;
+      job.ret_val = f.fr_returncode;
 
       // correction for GetInterfaceList and MatchInterfaceList
       if (job.status == 0)
@@ -122,7 +174,27 @@ struct MasterConnectorSocket : public Private::CNonCopyable
          else if (job.ret_val == FNDBadArgument)
             job.status = EINVAL;
       }
-      else
+
+      return rc;
+   }
+
+private:
+
+   bool send(dcmd_t cmd, void* data, size_t len, int32_t id)
+   {
+      sb_request_frame_t f;
+      INIT_REQUEST_FRAME(&f, len, cmd);
+      f.fr_id = id;
+
+      struct iovec iov[2];
+      iov[0].iov_base = &f;
+      iov[0].iov_len = sizeof(f);
+      iov[1].iov_base = data;
+      iov[1].iov_len = len;
+
+      bool rc = sendiov(mSock.fd(), iov, len > 0 ? 2 : 1, sizeof(f) + len) == 0;
+
+      if (!rc)
       {
          int error = errno;
          Log::error("Master TCP communication failed: errno=%d", error);
@@ -131,10 +203,25 @@ struct MasterConnectorSocket : public Private::CNonCopyable
       return rc;
    }
 
-private:
+   /// read the response body into buf, any data not fitting into buf is discarded
+   bool receiveBody(void* buf, size_t capacity, size_t len)
+   {
+      size_t cur = len < capacity ? len : capacity;
+      bool rc = cur == 0 || recvAll(mSock.fd(), buf, cur) == 0;
+
+      char dummy[256];
+      for (len -= cur; rc && len > 0; len -= cur)
+      {
+         cur = len < sizeof(dummy) ? len : sizeof(dummy);
+         rc = recvAll(mSock.fd(), dummy, cur) == 0;
+      }
+
+      return rc;
+   }
 
    IPv4::StreamSocket mSock;
    bool mConnected;
+   bool mPipelining;
 
    IPv4::Endpoint mEndpoint;
 };
@@ -147,6 +234,7 @@ MasterAdapter::MasterAdapter(const char* address)
    : mConnector(new MasterConnectorSocket(address))
    , mAddress(address)
    , mTrigger(0)
+   , mNextId(0)
 {
    // NOOP
 }
@@ -194,10 +282,31 @@ bool MasterAdapter::sendIdPing()
 }
 
 
-bool MasterAdapter::execute(Job& job, Notifier& notifier)
+bool MasterAdapter::receive(Notifier& notifier)
 {
-   bool rc = mConnector->execute(job);
-   notifier.jobFinished(job);
+   sb_response_frame_t f;
+   bool rc = mConnector->receive(f);
+
+   if (rc)
+   {
+      // older masters answer one request at a time without echoing its id
+      std::map<int32_t, Job*>::iterator iter = f.fr_id != 0 ? mInFlight.find(f.fr_id) : mInFlight.begin();
+
+      if (iter != mInFlight.end())
+      {
+         Job* job = iter->second;
+         mInFlight.erase(iter);
+
+         rc = mConnector->complete(*job, f);
+         notifier.jobFinished(*job);
+      }
+      else
+      {
+         Log::error("Master response for unknown request %d", f.fr_id);
+         rc = false;
+      }
+   }
+
    return rc;
 }
 
@@ -208,6 +317,14 @@ void MasterAdapter::removePending(Notifier& notifier)
     * removing all jobs from the queue and returning an error.
     * error handling is don in the servicebroker thread
     */
+   for (std::map<int32_t, Job*>::iterator iter = mInFlight.begin(); iter != mInFlight.end(); ++iter)
+   {
+      iter->second->status = EIO;
+      notifier.jobFinished(*iter->second);
+   }
+
+   mInFlight.clear();
+
    Job* job = mQueue.pop();
    while( job )
    {
@@ -221,21 +338,36 @@ void MasterAdapter::removePending(Notifier& notifier)
 bool MasterAdapter::executePending(Notifier& notifier)
 {
    bool rc = true;
+   const size_t window = mConnector->isPipelining() ? SB_MASTERADAPTER_PIPELINE : 1;
 
    /*
-    * executing all jobs in the queue and sending them back to the
-    * servicebroker
+    * sending all jobs in the queue without waiting for the previous responses and
+    * sending them back to the servicebroker as the responses arrive
     */
-   Job* job = mQueue.pop();
-   while(job)
+   while(rc)
    {
-      rc = execute(*job, notifier);
-      if (!rc)
+      Job* job = 0;
+
+      while(rc && mInFlight.size() < window && (job = mQueue.pop()) != 0)
+      {
+         // never use id 0, it is reserved for responses of older masters
+         if (++mNextId == 0)
+            ++mNextId;
+
+         const int32_t id = (int32_t)mNextId;
+
+         mInFlight[id] = job;
+         rc = mConnector->send(*job, id);
+      }
+
+      // nothing sent and nothing left to receive
+      if (!rc || mInFlight.empty())
          break;
 
-      job = mQueue.pop();
+      rc = receive(notifier);
    }
 
+   // the remaining jobs are failed by removePending after the disconnect
    return rc;
 }
 
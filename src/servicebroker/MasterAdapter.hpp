@@ -9,6 +9,8 @@
 #define DSI_SERVICEBROKER_MASTERADAPTER_HPP
 
 
+#include <map>
+
 #include "config.h"
 
 #include "dsi/private/CNonCopyable.hpp"
@@ -76,7 +78,8 @@ public:
    /// remove all pending jobs and send an appropriate notification for each
    void removePending(Notifier& notifier);
 
-   /// execute all pending jobs and send an appropriate notification for each
+   /// execute all pending jobs and send an appropriate notification for each. Several jobs may
+   /// be on the wire at the same time, they are completed in the order the master answers them.
    bool executePending(Notifier& notifier);
 
    /// IPv4 address in network byte order. This call is only valid on IP connections,
@@ -89,16 +92,23 @@ public:
    //@return the total statistical counter of the queue
    unsigned int getJobQueueTotalCounter() const;
 
+   //@return the maximum number of jobs ever waiting in the queue
+   unsigned int getJobQueueHighWaterMark() const;
+
 private:
 
-   /// execute a single job and send an appropriate notification
-   bool execute(Job& job, Notifier& notifier);
+   /// receive the next response, complete the job it belongs to and send an appropriate notification
+   bool receive(Notifier& notifier);
 
    std::auto_ptr<MasterConnectorSocket> mConnector;
    const char* mAddress;
 
    JobQueue mQueue;
    Triggerable* mTrigger;
+
+   /// jobs sent to the master, waiting for the response, by request id
+   std::map<int32_t, Job*> mInFlight;
+   uint32_t mNextId;   ///< wraps around, reinterpreted as signed frame id
 };
 
 
@@ -115,4 +125,11 @@ unsigned int MasterAdapter::getJobQueueTotalCounter() const
    return mQueue.getTotalCounter();
 }
 
+
+inline
+unsigned int MasterAdapter::getJobQueueHighWaterMark() const
+{
+   return mQueue.getHighWaterMark();
+}
+
 #endif   // DSI_SERVICEBROKER_MASTERADAPTER_HPP
@@ -39,7 +39,7 @@ Notification::Notification()
  , local(false)
  , uid(SB_UNKNOWN_USER_ID)
  , active(true)
- , regExpr(0)
+ , regExpr()
  , coid(-1)
  , prio(0)
  , nid(0)
@@ -54,9 +54,6 @@ Notification::Notification()
 
 Notification::~Notification()
 {
-   if (regExpr)
-      delete regExpr;
-
    if (coid != -1)
       PulseChannelManager::getInstance().detach(coid);
 
@@ -107,7 +104,7 @@ Notification::Notification( const Notification& rhs )
    // implement move semantics
    Notification* that = const_cast<Notification*>( &rhs ) ;
    that->host = 0 ;
-   that->regExpr = 0 ;
+   that->regExpr.reset() ;
    that->coid = -1 ;
    
    // make sure there is no master interaction on the moved object!
@@ -210,28 +207,8 @@ void Notification::send()
 
 bool Notification::setRegExp( const char* regexp )
 {
-   bool retval = false ;
-
-   if (regExpr)
-      delete regExpr;
-
-   regExpr = new RegExp();
-
-   if( regExpr )
-   {
-      int err = regExpr->compile( regexp, REG_EXTENDED | REG_NOSUB );
-      if( 0 != err )
-      {
-         char buffer[128];
-         (void)regExpr->error( err, buffer, sizeof(buffer)-1);
-         Log::error( "RegExp Error: %s /%s/", buffer, regexp );
-      }
-      else
-      {
-         retval = true ;
-      }
-   }
-   return retval ;
+   regExpr = RegExpCache::getInstance().get( regexp );
+   return 0 != regExpr.get() ;
 }
 
 
@@ -341,6 +318,6 @@ void Notification::dumpStats( std::ostringstream& ostream ) const
 
 bool Notification::matchRegExp( const std::string& string )
 {
-   return regExpr && (0 == regExpr->execute( string, 0 ));
+   return regExpr.get() && (0 == regExpr->execute( string, 0 ));
 }
 
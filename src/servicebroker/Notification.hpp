@@ -16,7 +16,7 @@
 #include "config.h"
 #include "Log.hpp"
 #include "IDList.hpp"
-#include "RegExp.hpp"
+#include "RegExpCache.hpp"
 #include "InterfaceDescription.hpp"
 #include "ConnectionContext.hpp"
 
@@ -52,7 +52,7 @@ public:
    void send();
 
    /*
-    * sets and compiles a regular expression
+    * sets a regular expression, compiled ones are shared via the RegExpCache
     */
    bool setRegExp( const char* regexp );
 
@@ -66,6 +66,11 @@ public:
     */
    bool hasRegExp();
 
+   /*
+    * The regular expression, shared by all notifications with the same pattern.
+    */
+   const RegExp* getRegExp() const;
+
    /*
     * Dumps debugging information to the provided buffer.
     */
@@ -101,7 +106,7 @@ private:
    void writeMessage(Log::eSBLogType type, const char* message) const;
 
    /** regular expression for a interface change match notification */
-   RegExp* regExpr ;
+   RegExpCache::tRegExpPtr regExpr ;
    /** The pulse data */
    SFNDPulseInfo pulse ;
 
@@ -132,7 +137,14 @@ private:
 inline 
 bool Notification::hasRegExp()
 {
-   return 0 != regExpr ;
+   return 0 != regExpr.get() ;
+}
+
+
+inline 
+const RegExp* Notification::getRegExp() const
+{
+   return regExpr.get() ;
 }
 
 
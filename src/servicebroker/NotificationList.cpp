@@ -5,19 +5,14 @@
 * Copyright (c) 2012 Harman International Industries, Inc.
 * All rights reserved
 ****************************************************************/
-#include <algorithm>
- 
 #include "NotificationList.hpp"
+#include "GroupCache.hpp"
 #include "IDList.hpp"
 #include "Log.hpp"
 
 #define QNX_REPLACE_RESMGR_CALLS
 #include "dsi/clientlib.h"
 
-#include <sys/types.h>
-#include <pwd.h>
-#include <grp.h>
-
 
 NotificationList::NotificationList()
  : mTotalCounter(0u)
@@ -32,21 +27,43 @@ NotificationList::~NotificationList()
 }
 
 
+void NotificationList::addToIndex( iterator iter )
+{
+   mById[iter->notificationID] = iter;
+   mByName[std::make_pair(iter->ifDescription.name, iter->notificationID)] = iter;
+   mByParty[std::make_pair(iter->partyID.globalID, iter->notificationID)] = iter;
+}
+
+
+void NotificationList::removeFromIndex( iterator iter )
+{
+   (void)mById.erase(iter->notificationID);
+   (void)mByName.erase(std::make_pair(iter->ifDescription.name, iter->notificationID));
+   (void)mByParty.erase(std::make_pair(iter->partyID.globalID, iter->notificationID));
+}
+
+
+NotificationList::iterator NotificationList::erase( iterator iter )
+{
+   removeFromIndex(iter);
+   return mList.erase(iter);
+}
+
+
 void NotificationList::trigger( const SPartyID &id )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
+   tPartyIndex::iterator pos = mByParty.lower_bound(std::make_pair(id.globalID, (notificationid_t)0));
+   while( pos != mByParty.end() && pos->first.first == id.globalID )
    {
-      if( iter->active && iter->partyID.globalID == id.globalID )
+      CNotificationList::iterator iter = pos->second;
+      ++pos;
+
+      if( iter->active )
       {
          /* send notification pulse */
          iter->send();
 
-         iter = mList.erase( iter );
-      }
-      else
-      {
-         ++iter ;
+         (void)erase( iter );
       }
    }
 }
@@ -54,80 +71,59 @@ void NotificationList::trigger( const SPartyID &id )
 
 void NotificationList::trigger( const InterfaceDescription &ifDescription, gid_t grpid )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
+   tNameIndex::iterator pos = mByName.lower_bound(std::make_pair(ifDescription.name, (notificationid_t)0));
+   while( pos != mByName.end() && pos->first.first == ifDescription.name )
    {
-      if( iter->ifDescription.name == ifDescription.name )
+      CNotificationList::iterator iter = pos->second;
+      ++pos;
+
+      if( iter->active
+       && iter->ifDescription.majorVersion == ifDescription.majorVersion
+       && iter->ifDescription.minorVersion <= ifDescription.minorVersion )
       {
-         if( iter->active
-          && iter->ifDescription.majorVersion == ifDescription.majorVersion
-          && iter->ifDescription.minorVersion <= ifDescription.minorVersion )
-         {
-            bool doSend = true ;
+         bool doSend = true ;
 
-            if( (gid_t)SB_UNKNOWN_GROUP_ID != grpid )
-            {
-               Log::message( 3, " trigger notification grpid:%d, uid:%d", grpid, iter->uid );
+         if( (gid_t)SB_UNKNOWN_GROUP_ID != grpid )
+         {
+            Log::message( 3, " trigger notification grpid:%d, uid:%d", grpid, iter->uid );
 
-               doSend = (0 == iter->uid) ;
-               if( !doSend )
-               {
-                  group* gr = getgrgid( grpid );
-                  if( gr )
-                  {
-                     for( char** p = gr->gr_mem; *p; p++ )
-                     {
-                        passwd* pw = getpwnam( *p );
-                        if( pw && static_cast<uid_t>(pw->pw_uid) == iter->uid )
-                        {
-                           doSend = true ;
-                           break;
-                        }
-                     }
-                  }
-               }
-            }
+            doSend = (0 == iter->uid) || GroupCache::getInstance().isMember( grpid, iter->uid ) ;
+         }
 
-            if( doSend )
-            {
-               /* send notification pulse */
-               iter->send();
+         if( doSend )
+         {
+            /* send notification pulse */
+            iter->send();
 
-               iter = mList.erase( iter );
-               continue ;
-            }
-            else
-            {
-               Log::warning( 1, " Notification on interface %s retained because of access restrictions", ifDescription.name.c_str() );
-               iter->active = false ;
-            }
+            (void)erase( iter );
          }
          else
          {
-            Log::message( 0, "Interface %s %d.%d available, notification set on version %d.%d", ifDescription.name.c_str()
-               , iter->ifDescription.majorVersion, iter->ifDescription.minorVersion
-               , ifDescription.majorVersion, ifDescription.minorVersion );
+            Log::warning( 1, " Notification on interface %s retained because of access restrictions", ifDescription.name.c_str() );
+            iter->active = false ;
          }
       }
-      ++iter ;
+      else
+      {
+         Log::message( 0, "Interface %s %d.%d available, notification set on version %d.%d", ifDescription.name.c_str()
+            , iter->ifDescription.majorVersion, iter->ifDescription.minorVersion
+            , ifDescription.majorVersion, ifDescription.minorVersion );
+      }
    }
 }
 
 
 void NotificationList::trigger( notificationid_t notificationID, bool removeIt )
 {
-   for( CNotificationList::iterator iter = mList.begin(); iter != mList.end(); ++iter )
+   tIdIndex::iterator pos = mById.find( notificationID );
+   if( pos != mById.end() && pos->second->active )
    {
-      if( iter->active && iter->notificationID == notificationID )
-      {
-         /* send notification pulse */
-         iter->send();
+      /* send notification pulse */
+      pos->second->send();
 
-         if( removeIt )
-         {
-            (void)mList.erase( iter );
-         }
-         break;
+      if( removeIt )
+      {
+         (void)erase( pos->second );
       }
    }
 }
@@ -142,7 +138,7 @@ void NotificationList::triggerPool( uint32_t poolID )
       {
          /* send notification pulse */
          iter->send();
-         iter = mList.erase( iter );
+         iter = erase( iter );
       }
       else
       {
@@ -154,20 +150,9 @@ void NotificationList::triggerPool( uint32_t poolID )
 
 void NotificationList::trigger( const PartyIDList &idList )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
+   for( PartyIDList::const_iterator id = idList.begin(); id != idList.end(); ++id )
    {
-      if( iter->active && idList.exists( iter->partyID ))
-      {
-         /* send notification pulse */
-         iter->send();
-
-         iter = mList.erase( iter );
-      }
-      else
-      {
-         ++iter ;
-      }
+      trigger( *id );
    }
 }
 
@@ -189,13 +174,44 @@ void NotificationList::triggerAll()
 
 void NotificationList::triggerAll( const InterfaceDescription &ifDescription )
 {
+   triggerAll( std::vector<std::string>( 1, ifDescription.name ) );
+}
+
+
+void NotificationList::triggerAll( const std::vector<std::string> &names )
+{
+   // notifications with the same pattern share the compiled expression
+   std::map<const RegExp*, bool> matches ;
+
    CNotificationList::iterator iter = mList.begin();
    while( iter != mList.end() )
    {
-      if( iter->active && (!iter->hasRegExp() || iter->matchRegExp( ifDescription.name )))
+      if( iter->active )
       {
-         /* send notification pulse */
-         iter->send();
+         bool match = true ;
+
+         if( iter->hasRegExp() )
+         {
+            std::map<const RegExp*, bool>::iterator cached = matches.find( iter->getRegExp() );
+            if( cached == matches.end() )
+            {
+               match = false ;
+               for( std::vector<std::string>::const_iterator name = names.begin(); !match && name != names.end(); ++name )
+               {
+                  match = iter->matchRegExp( *name );
+               }
+
+               matches[iter->getRegExp()] = match ;
+            }
+            else
+               match = cached->second ;
+         }
+
+         if( match )
+         {
+            /* send notification pulse */
+            iter->send();
+         }
       }
       ++iter ;
    }
@@ -212,7 +228,7 @@ void NotificationList::triggerNotLocal( uint32_t extendedID )
          /* send notification pulse */
          iter->send();
 
-         iter = mList.erase( iter );
+         iter = erase( iter );
       }
       else
       {
@@ -232,7 +248,7 @@ void NotificationList::triggerLocal(uint32_t extendedID)
          /* send notification pulse */
          iter->send();
 
-         iter = mList.erase( iter );
+         iter = erase( iter );
       }
       else
       {
@@ -249,6 +265,7 @@ notificationid_t NotificationList::add( const SocketConnectionContext& ctx, SFND
    if( entry.connect( ctx, pulse ) )
    {
       mList.push_front( entry );
+      addToIndex( mList.begin() );
       mTotalCounter++;
 
       return entry.notificationID ;
@@ -264,6 +281,7 @@ notificationid_t NotificationList::add( const char* regExpr, const SocketConnect
    if( entry.setRegExp( regExpr ) && entry.connect( ctx, pulse ) )
    {
       mList.push_front( entry );
+      addToIndex( mList.begin() );
       mTotalCounter++;
 
       return entry.notificationID ;
@@ -286,6 +304,7 @@ notificationid_t NotificationList::add( ClientSpecificData *host, const SPartyID
       entry.host = host ;
 
       mList.push_front( entry );
+      addToIndex( mList.begin() );
       mTotalCounter++;
 
       return entry.notificationID ;
@@ -305,6 +324,7 @@ notificationid_t NotificationList::add( ClientSpecificData *host, const Interfac
       entry.local = local ;
       entry.uid = uid ;
       mList.push_front( entry );
+      addToIndex( mList.begin() );
       mTotalCounter++;
 
       return entry.notificationID ;
@@ -318,52 +338,36 @@ void NotificationList::add( Notification& aNotification )
 {
    mList.push_front( aNotification );
    mList.front().poolID = aNotification.poolID;
+   addToIndex( mList.begin() );
    mTotalCounter++;
 }
 
 
 Notification* NotificationList::find( notificationid_t notificationID )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
-   {
-      if( iter->notificationID == notificationID )
-      {
-         return &(*iter) ;
-      }
-      ++iter ;
-   }
-   return 0 ;
+   tIdIndex::iterator pos = mById.find( notificationID );
+   return pos != mById.end() ? &(*pos->second) : 0 ;
 }
 
 
 void NotificationList::remove( notificationid_t notificationID )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
+   tIdIndex::iterator pos = mById.find( notificationID );
+   if( pos != mById.end() )
    {
-      if( iter->notificationID == notificationID )
-      {
-         (void)mList.erase( iter );
-         break;
-      }
-      
-      ++iter ;
+      (void)erase( pos->second );
    }
 }
 
 
 void NotificationList::remove( const NotificationIDList &idList )
 {
-   CNotificationList::iterator iter = mList.begin();
-   while( iter != mList.end() )
-   {     
-      if (std::find(idList.begin(), idList.end(), iter->notificationID) != idList.end())
-      {
-         iter = mList.erase( iter );
-      }
-      else      
-         ++iter ;      
+   // the destructor of a notification removes its id from the hosting list, so work on a copy
+   const NotificationIDList ids( idList );
+
+   for( NotificationIDList::const_iterator id = ids.begin(); id != ids.end(); ++id )
+   {
+      remove( *id );
    }
 }
 
@@ -400,7 +404,7 @@ bool NotificationList::move(NotificationList &source, uint32_t poolID)
       if (poolID == iter->poolID)
       {
          add(*iter);
-         iter = source.mList.erase(iter);
+         iter = source.erase(iter);
          result = true;
          source.mTotalCounter--;
       }
@@ -438,7 +442,11 @@ size_t NotificationList::setType(uint32_t poolID, const SPartyID &partyID)
       if (poolID == iter->poolID)
       {
          changes++;
+
+         // the party id is part of the index key
+         (void)mByParty.erase(std::make_pair(iter->partyID.globalID, iter->notificationID));
          iter->setType(partyID);
+         mByParty[std::make_pair(iter->partyID.globalID, iter->notificationID)] = iter;
       }
    }
 
@@ -12,7 +12,10 @@
 #include "Notification.hpp"
 
 #include <list>
+#include <map>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "IDList.hpp"
 
@@ -27,6 +30,11 @@ static const int32_t PULSE_MASTER_ATTACH_EXTENDED   = _PULSE_CODE_MINAVAIL + 24
  * @internal
  *
  * @brief Describes a notification list.
+ *
+ * The notifications are kept in a list for stable iterators. Additionally they are indexed by
+ * notification id, by interface name and by party id so triggering and removing only touches
+ * the matching notifications. All modifications must go through this class to keep the indexes
+ * consistent; the indexed members of a notification must not be changed from outside.
  */
 class NotificationList
 {
@@ -71,7 +79,16 @@ public:
     * @brief Triggers all notifications in the list without removing them afterwards.
     */
    void triggerAll();
+
+   /**
+    * @internal
+    *
+    * @brief Triggers all notifications in the list without removing them afterwards, match
+    * notifications only if their expression matches the registered respectively unregistered
+    * interface(s). Each distinct expression is evaluated once per interface only.
+    */
    void triggerAll( const InterfaceDescription &ifDescription );
+   void triggerAll( const std::vector<std::string> &names );
 
    /**
     * @internal
@@ -194,8 +211,19 @@ public:
 
 private:
    typedef std::list<Notification> CNotificationList ;
+   typedef std::map<notificationid_t, iterator> tIdIndex ;
+   typedef std::map<std::pair<std::string, notificationid_t>, iterator> tNameIndex ;
+   typedef std::map<std::pair<uint64_t, notificationid_t>, iterator> tPartyIndex ;
+
+   void addToIndex( iterator iter );
+   void removeFromIndex( iterator iter );
+
    CNotificationList mList ;
 
+   tIdIndex mById ;
+   tNameIndex mByName ;       ///< key is the interface name
+   tPartyIndex mByParty ;     ///< key is the global id of the client respectively the server
+
    NotificationList( const NotificationList& );
    NotificationList& operator=( const NotificationList& );
 
@@ -225,13 +253,6 @@ NotificationList::iterator NotificationList::end()
 }
 
 
-inline
-NotificationList::iterator NotificationList::erase(NotificationList::iterator iter)
-{
-   return mList.erase(iter);
-}
-
-
 inline 
 unsigned int NotificationList::getTotalCounter() const
 {
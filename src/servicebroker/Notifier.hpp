@@ -9,6 +9,9 @@
 #define DSI_SERVICEBROKER_NOTIFIER_HPP
 
 
+#include <stdint.h>
+
+
 class Job;
 
 
@@ -18,7 +21,7 @@ class Job;
 struct InternalNotification
 {
    uint32_t code;
-   uint32_t value;
+   intptr_t value;   ///< large enough to carry a job pointer
 };   
 
 
@@ -0,0 +1,66 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include "RegExpCache.hpp"
+
+#include "config.h"
+#include "Log.hpp"
+
+
+RegExpCache::RegExpCache()
+{
+   // NOOP
+}
+
+
+RegExpCache& RegExpCache::getInstance()
+{
+   static RegExpCache cache;
+   return cache;
+}
+
+
+RegExpCache::tRegExpPtr RegExpCache::get(const std::string& pattern)
+{
+   tIndex::iterator iter = mIndex.find(pattern);
+   if (iter != mIndex.end())
+   {
+      // move to the front
+      mLru.splice(mLru.begin(), mLru, iter->second);
+      return mLru.front().second;
+   }
+
+   tRegExpPtr re(new RegExp);
+
+   int err = re->compile(pattern, REG_EXTENDED | REG_NOSUB);
+   if (0 != err)
+   {
+      char buffer[128];
+      (void)re->error(err, buffer, sizeof(buffer)-1);
+      Log::error("RegExp Error: %s /%s/", buffer, pattern.c_str());
+
+      return tRegExpPtr();
+   }
+
+   if (mIndex.size() >= SB_REGEXPCACHE_SIZE)
+   {
+      mIndex.erase(mLru.back().first);
+      mLru.pop_back();
+   }
+
+   mLru.push_front(std::make_pair(pattern, re));
+   mIndex[pattern] = mLru.begin();
+
+   return re;
+}
+
+
+void RegExpCache::clear()
+{
+   mIndex.clear();
+   mLru.clear();
+}
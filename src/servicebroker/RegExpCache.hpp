@@ -0,0 +1,77 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#ifndef DSI_SERVICEBROKER_REGEXPCACHE_HPP
+#define DSI_SERVICEBROKER_REGEXPCACHE_HPP
+
+
+#include <list>
+#include <map>
+#include <string>
+#include <tr1/memory>
+
+#include "RegExp.hpp"
+
+
+/**
+ * Caches the compiled regular expressions of the interface list matches, keyed by the pattern
+ * text. Clients usually match the same few patterns again and again, so they are just compiled
+ * once. The expressions are shared by the one-shot matches and the match notifications, so an
+ * expression survives its eviction from the cache as long as it is still in use.
+ *
+ * Must only be used from the main thread of the servicebroker.
+ */
+class RegExpCache
+{
+public:
+
+   typedef std::tr1::shared_ptr<RegExp> tRegExpPtr;
+
+   /**
+    * Singleton.
+    */
+   static RegExpCache& getInstance();
+
+   /**
+    * @return the compiled extended regular expression for the pattern or an empty pointer if
+    *         the pattern is invalid. Errors are logged, invalid patterns are not cached.
+    */
+   tRegExpPtr get(const std::string& pattern);
+
+   /**
+    * Drop all cached entries.
+    */
+   void clear();
+
+   /**
+    * @return the number of cached expressions
+    */
+   size_t size() const;
+
+private:
+
+   typedef std::list<std::pair<std::string, tRegExpPtr> > tLruList;   ///< most recently used first
+   typedef std::map<std::string, tLruList::iterator> tIndex;
+
+   RegExpCache();
+
+   RegExpCache(const RegExpCache&);
+   RegExpCache& operator=(const RegExpCache&);
+
+   tLruList mLru;
+   tIndex mIndex;
+};
+
+
+inline
+size_t RegExpCache::size() const
+{
+   return mIndex.size();
+}
+
+
+#endif   // DSI_SERVICEBROKER_REGEXPCACHE_HPP
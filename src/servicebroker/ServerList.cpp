@@ -12,6 +12,7 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
+#include <cassert>
 #include <errno.h>
 
 #include "config.h"
@@ -24,13 +25,6 @@ namespace /*anonymous*/
 }
 
 
-static inline
-bool compare( const char* lhs, const char* rhs )
-{
-   return 0 < strcmp( lhs, rhs );  
-}
-
-
 ServerListEntry::ServerListEntry()
  : id(++sNextID)  
  , nid(0)
@@ -48,7 +42,8 @@ ServerListEntry::ServerListEntry()
 
 
 ServerList::ServerList()
- : mTotalCounter(0u)
+ : mOrder(SlotCompare(mEntries))
+ , mTotalCounter(0u)
 {
    // NOOP
 }
@@ -62,7 +57,28 @@ ServerList::~ServerList()
 
 void ServerList::add( const ServerListEntry& entry )
 {
-   (void)mEntries.insert(std::lower_bound(mEntries.begin(), mEntries.end(), entry, compare), entry);
+   uint32_t slot;
+
+   if (mFreeSlots.empty())
+   {
+      slot = mEntries.size();
+      mEntries.push_back(entry);
+   }
+   else
+   {
+      slot = mFreeSlots.back();
+      mFreeSlots.pop_back();
+      mEntries[slot] = entry;
+   }
+
+   (void)mOrder.insert(slot);
+
+   // interface names are unique, the servicebroker checks this before adding an entry
+   mByName[entry.ifDescription.name] = slot;
+   mByPartyID[entry.partyID.globalID] = slot;
+   (void)mByLocalID.insert(std::make_pair(entry.partyID.s.localID, slot));
+   mByID[entry.id] = slot;
+
    mTotalCounter++;
 }
 
@@ -83,75 +99,97 @@ ServerListEntry* ServerList::find( const SFNDInterfaceDescription &ifDescription
 
 ServerListEntry* ServerList::find(const char* ifName)
 {   
-   tContainerType::iterator iter = std::lower_bound(mEntries.begin(), mEntries.end(), ifName, compare);
-   return (iter != mEntries.end() && !compare(ifName, *iter)) ? &*iter : 0;   
+   tNameIndexType::const_iterator iter = mByName.find(ifName);
+   return iter != mByName.end() ? &mEntries[iter->second] : 0;
 }
 
 
 ServerListEntry* ServerList::find( const SPartyID& serverID )
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
-   {
-      if( serverID.globalID == iter->partyID.globalID )
-         return &(*iter) ;
-   }
-
-   return 0 ;
+   tPartyIDIndexType::const_iterator iter = mByPartyID.find(serverID.globalID);
+   return iter != mByPartyID.end() ? &mEntries[iter->second] : 0;
 }
 
 
 ServerListEntry* ServerList::findByLocalID( uint32_t localID )
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
-   {
-      if( localID == iter->partyID.s.localID )
-         return &(*iter) ;
-   }
-
-   return 0 ;
+   return findFirstByLocalID(localID, false);
 }
 
+
 ServerListEntry* ServerList::findByLocalIDandInvalidMasterID( uint32_t localID )
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
+   return findFirstByLocalID(localID, true);
+}
+
+
+ServerListEntry* ServerList::findFirstByLocalID( uint32_t localID, bool invalidMasterID )
+{
+   std::pair<tLocalIDIndexType::const_iterator, tLocalIDIndexType::const_iterator> range = mByLocalID.equal_range(localID);
+   const SlotCompare before(mEntries);
+   tLocalIDIndexType::const_iterator result = mByLocalID.end();
+
+   // the hash index has no defined order, so pick the same entry as a scan of the table would
+   for( tLocalIDIndexType::const_iterator iter = range.first; iter != range.second; ++iter )
    {
-      if( (localID == iter->partyID.s.localID ) && (iter->masterID.s.localID == (uint32_t)-1))
-         return &(*iter) ;
+      if( (!invalidMasterID || mEntries[iter->second].masterID.s.localID == (uint32_t)-1)
+         && (result == mByLocalID.end() || before(iter->second, result->second)) )
+      {
+         result = iter ;
+      }
    }
 
-   return 0 ;
+   return result != mByLocalID.end() ? &mEntries[result->second] : 0;
 }
 
 
-
 ServerListEntry* ServerList::find( int32_t id )
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
-   {
-      if( id == iter->id )
-         return &(*iter) ;
-   }
-
-   return 0 ;
+   tIDIndexType::const_iterator iter = mByID.find(id);
+   return iter != mByID.end() ? &mEntries[iter->second] : 0;
 }
 
 
 void ServerList::remove( const SPartyID& serverID )
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
+   tPartyIDIndexType::iterator iter = mByPartyID.find(serverID.globalID);
+
+   if( iter != mByPartyID.end() )
    {
-      if( iter->partyID.globalID == serverID.globalID )
+      uint32_t slot = iter->second;
+      ServerListEntry& entry = mEntries[slot];
+
+      mByPartyID.erase(iter);
+      (void)mByName.erase(entry.ifDescription.name);
+      (void)mByID.erase(entry.id);
+
+      std::pair<tLocalIDIndexType::iterator, tLocalIDIndexType::iterator> range = mByLocalID.equal_range(entry.partyID.s.localID);
+      for( tLocalIDIndexType::iterator liter = range.first; liter != range.second; ++liter )
       {
-         (void)mEntries.erase( iter );
-         break;
+         if( liter->second == slot )
+         {
+            mByLocalID.erase(liter);
+            break;
+         }
       }
+
+      std::pair<tOrderType::iterator, tOrderType::iterator> orange = mOrder.equal_range(slot);
+      while( orange.first != orange.second && *orange.first != slot )
+         ++orange.first;
+
+      assert(orange.first != orange.second);
+      mOrder.erase(orange.first);
+
+      // release the memory held by the name
+      std::string().swap(entry.ifDescription.name);
+      mFreeSlots.push_back(slot);
    }
 }
 
 
 void ServerList::clearMasterIDs()
 {
-   for( tContainerType::iterator iter = mEntries.begin(); iter != mEntries.end(); iter++ )
+   for( iterator iter = begin(); iter != end(); iter++ )
    {
       iter->masterID = 0 ;
    }
@@ -169,7 +207,7 @@ void ServerList::dumpStats( std::ostringstream& ostream ) const
    
    ostream << "          pid/ip:port  Process                  ServerId        Interface\n" ;               
    
-   for( tContainerType::const_iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter )
+   for( const_iterator iter = begin(); iter != end(); ++iter )
    {
       strcpy(processName, "<unknown>");
       if (SB_LOCAL_NODE_ADDRESS == iter->nid)
@@ -9,8 +9,15 @@
 #define DSI_SERVICEBROKER_SERVERLIST_HPP
 
 
+#include <cstddef>
 #include <sstream>
-#include <list>
+#include <deque>
+#include <set>
+#include <vector>
+#include <iterator>
+#include <cstring>
+#include <string>
+#include <tr1/unordered_map>
 
 #include "InterfaceDescription.hpp"
 
@@ -64,15 +71,145 @@ struct ServerListEntry
  * @internal
  *
  * @brief Describes a server table.
+ *
+ * The entries are kept in a slotted store which never moves them, so pointers returned by the find
+ * functions stay valid until the entry is removed. Removed entries leave a free slot which is reused by
+ * the next insertion. Lookups by interface name, server ID, local ID and internal id are done via hash
+ * indexes on the store. Iteration is done in descending order of the interface names, independent of
+ * the order of insertion.
  */
 class ServerList
 {
-   typedef std::list<ServerListEntry> tContainerType;
+   typedef std::deque<ServerListEntry> tContainerType;
+
+   /// Orders the slots of the store by descending interface names.
+   struct SlotCompare
+   {
+      explicit inline
+      SlotCompare(const tContainerType& entries)
+       : mEntries(&entries)
+      {
+         // NOOP
+      }
+
+      inline
+      bool operator()(uint32_t lhs, uint32_t rhs) const
+      {
+         return 0 < strcmp((*mEntries)[lhs], (*mEntries)[rhs]);
+      }
+
+      const tContainerType* mEntries;
+   };
+
+   typedef std::multiset<uint32_t, SlotCompare> tOrderType;
+
+   /**
+    * Iterates the entries in the store in the order given by the slot list.
+    */
+   template<typename EntryT>
+   class Iterator
+   {
+      friend class ServerList;
+
+   public:
+
+      typedef std::bidirectional_iterator_tag iterator_category;
+      typedef EntryT value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef EntryT* pointer;
+      typedef EntryT& reference;
+
+      inline
+      Iterator()
+       : mStore(0)
+      {
+         // NOOP
+      }
+
+      /// allow conversion from iterator to const_iterator
+      template<typename OtherT>
+      inline
+      Iterator(const Iterator<OtherT>& rhs)
+       : mStore(rhs.mStore)
+       , mPos(rhs.mPos)
+      {
+         // NOOP
+      }
+
+      inline
+      EntryT& operator*() const
+      {
+         return (*mStore)[*mPos];
+      }
+
+      inline
+      EntryT* operator->() const
+      {
+         return &(*mStore)[*mPos];
+      }
+
+      inline
+      Iterator& operator++()
+      {
+         ++mPos;
+         return *this;
+      }
+
+      inline
+      Iterator operator++(int)
+      {
+         Iterator rc(*this);
+         ++mPos;
+         return rc;
+      }
+
+      inline
+      Iterator& operator--()
+      {
+         --mPos;
+         return *this;
+      }
+
+      inline
+      Iterator operator--(int)
+      {
+         Iterator rc(*this);
+         --mPos;
+         return rc;
+      }
+
+      inline
+      bool operator==(const Iterator& rhs) const
+      {
+         return mPos == rhs.mPos;
+      }
+
+      inline
+      bool operator!=(const Iterator& rhs) const
+      {
+         return mPos != rhs.mPos;
+      }
+
+   private:
+
+      inline
+      Iterator(tContainerType* store, tOrderType::const_iterator pos)
+       : mStore(store)
+       , mPos(pos)
+      {
+         // NOOP
+      }
+
+      template<typename OtherT> friend class Iterator;
+
+      tContainerType* mStore;
+      tOrderType::const_iterator mPos;
+   };
 
 public:
 
-   typedef tContainerType::const_iterator const_iterator;
-   typedef tContainerType::iterator       iterator;
+   typedef Iterator<const ServerListEntry> const_iterator;
+   typedef Iterator<ServerListEntry>       iterator;
 
    ServerList();
    ~ServerList();
@@ -108,8 +245,25 @@ public:
     */
    ServerListEntry* find( const SPartyID& serverID );
 
+   /**
+    * @internal
+    *
+    * @brief Find an entry in the server table by the local part of its server ID.
+    *
+    * Local IDs are only unique per extended ID, if several entries match the first one in iteration
+    * order is returned.
+    *
+    * @param localID The local ID of the entry to find.
+    *
+    * @return Pointer to the wanted entry or NULL if the entry does not exist
+    */
    ServerListEntry* findByLocalID( uint32_t localID );
 
+   /**
+    * @internal
+    *
+    * @brief Like @c findByLocalID() but only considers entries without a valid master ID.
+    */
    ServerListEntry* findByLocalIDandInvalidMasterID( uint32_t localID );
    /**
     * @internal
@@ -159,38 +313,61 @@ public:
    inline
    const_iterator begin() const
    {
-      return mEntries.begin();
+      return const_iterator(const_cast<tContainerType*>(&mEntries), mOrder.begin());
    }
 
    inline
    const_iterator end() const
    {
-      return mEntries.end();
+      return const_iterator(const_cast<tContainerType*>(&mEntries), mOrder.end());
    }
 
    inline
    iterator begin()
    {
-      return mEntries.begin();
+      return iterator(&mEntries, mOrder.begin());
    }
 
    inline
    iterator end()
    {
-      return mEntries.end();
+      return iterator(&mEntries, mOrder.end());
    }
 
    inline
    size_t size() const
    {
-      return mEntries.size();
+      return mOrder.size();
    }
 
    unsigned int getTotalCounter() const;
 
 private:
 
+   // the slot order refers to the own store
+   ServerList(const ServerList&);
+   ServerList& operator=(const ServerList&);
+
+   typedef std::tr1::unordered_map<std::string, uint32_t> tNameIndexType;
+   typedef std::tr1::unordered_map<uint64_t, uint32_t> tPartyIDIndexType;
+   typedef std::tr1::unordered_multimap<uint32_t, uint32_t> tLocalIDIndexType;
+   typedef std::tr1::unordered_map<int32_t, uint32_t> tIDIndexType;
+
+   /// the first entry in iteration order with the given local ID, or with the given local ID and an
+   /// invalid master ID
+   ServerListEntry* findFirstByLocalID( uint32_t localID, bool invalidMasterID );
+
+   /// the entry store, free slots are listed in mFreeSlots
    tContainerType mEntries;
+   std::vector<uint32_t> mFreeSlots;
+
+   /// slots of all used entries in iteration order
+   tOrderType mOrder;
+
+   tNameIndexType mByName;
+   tPartyIDIndexType mByPartyID;
+   tLocalIDIndexType mByLocalID;   ///< local IDs are only unique per extended ID
+   tIDIndexType mByID;
 
    //statistical counters
    unsigned int mTotalCounter;
@@ -9,17 +9,16 @@
 #include "Log.hpp"
 #include "MessageContext.hpp"
 #include "ConnectionContext.hpp"
-#include "RegExp.hpp"
+#include "RegExpCache.hpp"
 #include "ClientSpecificData.hpp"
 #include "JobQueue.hpp"
 #include "SignallingAddress.hpp"
 #include "config.h"
+#include "GroupCache.hpp"
 
 #include "SocketConnectionContext.hpp"
 
 #include <sys/types.h>
-#include <pwd.h>
-#include <grp.h>
 
 #include <cctype>
 #include <cmath>
@@ -297,6 +296,14 @@ void Servicebroker::handleRegisterInterfaceEx( SocketMessageContext &msg, Client
    SFNDInterfaceDescription ifDescription ;
    bool isLocal ;
 
+   if( !msg.context().isLocal() )
+   {
+      Log::error( "%s not called from local node!", GetDCmdString(DCMD_FND_REGISTER_INTERFACE_EX) );
+
+      msg.prepareResponse(FNDBadArgument);
+      return;
+   }
+
    for( int32_t idx=0; idx<arg.i.ifCount; idx++ )
    {
       // reading the next interface description from the client
@@ -309,8 +316,9 @@ void Servicebroker::handleRegisterInterfaceEx( SocketMessageContext &msg, Client
       // is it a local one?
       isLocal = mConfig.isLocalService( ifDescription.name );
 
-      // add the interface
-      if( !addInterface( ocb, ifDescription, msg.context(), arg.i.pid, arg.i.chid, isLocal, -1, serverID ) )
+      // add the interface, a rejected one does not fail the others
+      if( !check( ifDescription )
+          || !addInterface( ocb, ifDescription, msg.context(), arg.i.pid, arg.i.chid, isLocal, -1, serverID ) )
       {
          serverID.globalID = (uint64_t)-1 ;
       }
@@ -418,6 +426,8 @@ void Servicebroker::handleUnregisterInterface( SocketMessageContext &msg, Client
          /* if there is a master involved we need to unregister the interface at the master */
          unregisterInterfaceMaster( *entry );
 
+         InterfaceDescription ifDescription = entry->ifDescription ;
+
          /* remove entry */
          mConnectedServers.remove( arg.i.serverID );
 
@@ -429,7 +439,7 @@ void Servicebroker::handleUnregisterInterface( SocketMessageContext &msg, Client
          msg.prepareResponse(FNDOK);   
 
          /* triger serverlist change notifications */
-         mServerListChangeNotifications.triggerAll();
+         mServerListChangeNotifications.triggerAll( ifDescription );
       }
    }
 
@@ -873,13 +883,7 @@ bool Servicebroker::checkAccessPrivileges( const SocketConnectionContext& contex
       {
          if( Log::getLevel() > 0 )
          {
-            const char* username = "<unknown>";
-            passwd* pw = getpwuid( uid );
-            if( pw )
-            {
-               username = pw->pw_name ;
-            }
-            Log::message( 3, " User %s wants to attach to interface %s", username, entry->ifDescription.name.c_str() );
+            Log::message( 3, " User %s wants to attach to interface %s", GroupCache::getInstance().getUserName( uid ), entry->ifDescription.name.c_str() );
          }
 
          if( 0 == uid )
@@ -889,37 +893,13 @@ bool Servicebroker::checkAccessPrivileges( const SocketConnectionContext& contex
          }
          else
          {
-            group* gr = getgrgid( entry->grpid );
-            if( gr )
-            {
-               for( char** p = gr->gr_mem; *p; p++ )
-               {
-                  passwd* pw = getpwnam( *p );
-                  if( pw && (int)pw->pw_uid == (int)uid )
-                  {
-                     grantAccess = true ;
-                     break;
-                  }
-               }
-            }
+            grantAccess = GroupCache::getInstance().isMember( entry->grpid, uid );
          }
          if( !grantAccess )
          {
-            const char* name = "<unknown>";
-            passwd* pw = getpwuid( uid );
-            if( pw )
-            {
-               name = pw->pw_name ;
-            }
-            Log::error( " Attaching to interface %s denied for user %s", entry->ifDescription.name.c_str(), name );
+            Log::error( " Attaching to interface %s denied for user %s", entry->ifDescription.name.c_str(), GroupCache::getInstance().getUserName( uid ) );
 
-            name = "<unknown>";
-            group* gr = getgrgid( entry->grpid );
-            if( gr )
-            {
-               name = gr->gr_name ;
-            }
-            Log::error( " Only users of group %s are allowed to attach to the interface %s", name, entry->ifDescription.name.c_str() );
+            Log::error( " Only users of group %s are allowed to attach to the interface %s", GroupCache::getInstance().getGroupName( entry->grpid ), entry->ifDescription.name.c_str() );
          }
       }
    }
@@ -1400,13 +1380,9 @@ void Servicebroker::handleMatchInterfaceList( SocketMessageContext &msg, ClientS
 {
    Log::message( 2, "*[%d] %s /%s/", msg.context().getId(), GetDCmdString(DCMD_FND_MATCH_INTERFACELIST), arg.i.regExpr);
 
-   RegExp re ;
-   int32_t err = re.compile( arg.i.regExpr, REG_EXTENDED | REG_NOSUB );
-   if( 0 != err )
+   RegExpCache::tRegExpPtr re = RegExpCache::getInstance().get( arg.i.regExpr );
+   if( !re.get() )
    {
-      char buffer[128];
-      (void)re.error( err, buffer, sizeof(buffer)-1);
-      Log::error( "RegExp Error: %s /%s/", buffer, arg.i.regExpr );
       msg.prepareResponse(-(int32_t)FNDRegularExpression, 0, 0 );
    }
    else if( isMasterConnected() )
@@ -1425,7 +1401,7 @@ void Servicebroker::handleMatchInterfaceList( SocketMessageContext &msg, ClientS
 
       for( ServerList::const_iterator iter = mConnectedServers.begin(); iter != mConnectedServers.end(); iter++ )
       {
-         if( 0 == re.execute( iter->ifDescription.name, 0 ) )
+         if( 0 == re->execute( iter->ifDescription.name, 0 ) )
          {
             if( retCount >= inCount )
             {
@@ -1799,13 +1775,17 @@ void Servicebroker::dumpStatistics(std::ostringstream& ostream) const
            << mServerDisconnectNotifications.getTotalCounter();
    ostream << "\n      Client Detach: " << mClientDetachNotifications.size() << "|"
            << mClientDetachNotifications.getTotalCounter();
+   ostream << "\n   Group cache reads: " << GroupCache::getInstance().getReadCounter();
    if (isMaster())
    {
       ostream << "\n   Jobs: 0|0";
    }
    else
    {
-      ostream << "\n   Jobs: " << master().getJobQueueSize() << "|" << master().getJobQueueTotalCounter();
+      ostream << "\n   Jobs: " << master().getJobQueueSize() << "|" << master().getJobQueueTotalCounter()
+              << " , max: " << master().getJobQueueHighWaterMark()
+              << " , allocated: " << Job::getCurrentCounter() << "|" << Job::getTotalCounter()
+              << " , reused: " << Job::getReusedCounter();
    }
 }
 
@@ -2195,7 +2175,7 @@ void Servicebroker::handleJobFinished(Job& job)
                // append local interfaces
                for( ServerList::const_iterator iter = mConnectedServers.begin(); iter != mConnectedServers.end(); iter++ )
                {
-                  if( (iter->local || !mConfig.forwardService(iter->ifDescription.name)) && 0 == job.regex.execute( iter->ifDescription.name, 0 ))
+                  if( (iter->local || !mConfig.forwardService(iter->ifDescription.name)) && job.regex.get() && 0 == job.regex->execute( iter->ifDescription.name, 0 ))
                   {
                      if( job.ret_val >= job.cookie )
                      {
@@ -2556,7 +2536,7 @@ void Servicebroker::dropCache(const SPartyID &serverID)
 }
 
 
-void Servicebroker::dispatch(int code, int value)
+void Servicebroker::dispatch(int code, intptr_t value)
 {
    switch(code)
    {
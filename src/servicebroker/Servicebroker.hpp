@@ -72,7 +72,7 @@ public:
    /**
     * handle pulse like commands
     */
-   void dispatch(int code, int value);
+   void dispatch(int code, intptr_t value);
 
    /**
     * handle devctl like commands
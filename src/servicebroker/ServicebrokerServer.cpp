@@ -104,6 +104,7 @@ ServicebrokerClientBase::ServicebrokerClientBase(ServicebrokerServer& server, ui
    : mContext(mData, nodeAddress, localAddress, self())
    , mServer(server)
    , mState(State_READING_HEADER)
+   , mRequestId(0)
 {
    // NOOP
 }
@@ -126,6 +127,9 @@ void ServicebrokerClientBase::eval(sb_request_frame_t& f)
    SocketMessageContext msgctx(mContext, mReadBuffer, mWriteBuffer);
    int cmd = f.fr_cmd;
 
+   // the response carries the id of the request, this allows the client to complete pipelined requests
+   mRequestId = f.fr_id;
+
    bool found = Servicebroker::getInstance().dispatch(f.fr_cmd, msgctx, mData);
 
    // extra handling for this initial master ping -> throw away any old connection
@@ -149,6 +153,7 @@ void ServicebrokerClientBase::eval(sb_request_frame_t& f)
 
       mReadBuffer.reset();   // free data - if possible and necessary
       mWriteBuffer.set(0);   // seek buffer to beginning
+      mWriteBuffer.response().fr_id = mRequestId;
 
       evaluateWriteResult();
    }
@@ -185,8 +190,13 @@ bool ServicebrokerClientBase::handleRead(size_t amount, io::error_code err)
       }
 
       // request already complete?
-      if (mReadBuffer.pos() == mReadBuffer.request().fr_envelope.fr_size + sizeof(sb_request_frame_t))
+      const size_t total = mReadBuffer.request().fr_envelope.fr_size + sizeof(sb_request_frame_t);
+
+      if (mState == State_READING_BODY && mReadBuffer.pos() >= total)
       {
+         // the client may have sent further requests without waiting for the response
+         mPipelined.assign((const char*)mReadBuffer.begin() + total, mReadBuffer.pos() - total);
+
          eval(mReadBuffer.request());
       }
       else
@@ -209,6 +219,9 @@ bool ServicebrokerClientBase::handleWrite(size_t amount, io::error_code err)
       {
          mState = State_READING_HEADER;
          mWriteBuffer.reset();
+
+         if (evalPipelined())
+            return false;
       }
 
       arm();
@@ -220,6 +233,23 @@ bool ServicebrokerClientBase::handleWrite(size_t amount, io::error_code err)
 }
 
 
+bool ServicebrokerClientBase::evalPipelined()
+{
+   if (!mPipelined.empty())
+   {
+      std::string pipelined;
+      pipelined.swap(mPipelined);
+
+      (void)mReadBuffer.write(pipelined.data(), pipelined.size(), 0);
+      (void)handleRead(pipelined.size(), io::ok);
+
+      return true;
+   }
+
+   return false;
+}
+
+
 void ServicebrokerClientBase::sendDeferredResponse(int status, int retval, void* data, size_t len)
 {
    assert(mState == State_DEFERRED);
@@ -241,6 +271,8 @@ void ServicebrokerClientBase::sendDeferredResponse(int status, int retval, void*
       }
    }
 
+   mWriteBuffer.response().fr_id = mRequestId;
+
    mReadBuffer.reset();
    mWriteBuffer.set(0);
 
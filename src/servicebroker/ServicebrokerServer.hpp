@@ -9,6 +9,7 @@
 #define DSI_SERVICEBROKER_SERVICEBROKERSERVER_HPP
 
 #include <tr1/type_traits>
+#include <string>
 
 #include "dsi/private/CNonCopyable.hpp"
 
@@ -132,6 +133,13 @@ protected:
     */
    void sendDeferredResponse(int status, int retval, void* data, size_t len);
 
+   /**
+    * Evaluate the requests received together with the last one.
+    *
+    * @return false if there were none, the connection must be rearmed by the caller in this case.
+    */
+   bool evalPipelined();
+
    bool handleRead(size_t amount, DSI::io::error_code err);
    bool handleWrite(size_t amount, DSI::io::error_code err);
 
@@ -144,6 +152,12 @@ protected:
    tAutoBufferType mReadBuffer;
    tAutoBufferType mWriteBuffer;
    State mState;
+
+   /// pipelined requests received together with the current one, evaluated after its response was sent
+   std::string mPipelined;
+
+   /// id of the request currently evaluated
+   int32_t mRequestId;
 };
 
 
@@ -582,6 +596,9 @@ private:
          {
             mWriteBuffer.reset();
             mState = State_READING_HEADER;
+
+            if (evalPipelined())
+               return;
          }
 
          arm();
@@ -42,6 +42,18 @@
 #define SB_MASTERADAPTER_SENDTIMEO 2000
 #define SB_MASTERADAPTER_RECVTIMEO 5000
 
+/// maximum number of requests sent from the slave to the master without waiting for their responses. Only used
+/// if the master echoes the request ids, older masters get one request at a time.
+#define SB_MASTERADAPTER_PIPELINE 32
+
+/// lifetime in milliseconds of the cached group memberships and user names used for access checks. Changes in the
+/// user and group databases become visible after this time at the latest or after the "flushgroups" setup command.
+#define SB_GROUPCACHE_TIMEOUT 60000
+
+/// number of compiled regular expressions of interface list matches kept for reuse, the least recently used ones
+/// are dropped first. Expressions of active match notifications stay alive as long as the notifications do.
+#define SB_REGEXPCACHE_SIZE 32
+
 /// Have a look on the phone if you wonder what 3746 stands for. Since all slaves use the same port for their
 /// pulse socket only one slave can run on a node. The http server port can be modified by the environment variable
 /// SB_HTTP_PORT set to the appropriate (free) port.
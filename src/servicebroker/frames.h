@@ -23,7 +23,7 @@ typedef struct sb_request_frame
    sb_frame_t fr_envelope;   ///< request header frame
    
    int32_t fr_cmd;           ///< command to be executed by servicebroker
-   int32_t fr_padding;       ///< padding bytes for alignment
+   int32_t fr_id;            ///< request id echoed in the response frame, 0 if not used
    
 } sb_request_frame_t;
 
@@ -36,7 +36,7 @@ typedef struct sb_response_frame
    sb_frame_t fr_envelope;     ///< response header frame
    
    int32_t fr_returncode;      ///< return code from servicebroker
-   int32_t fr_padding;         ///< padding bytes for alignment
+   int32_t fr_id;              ///< id of the answered request, always 0 from older servicebrokers
    
 } sb_response_frame_t;
 
@@ -49,7 +49,7 @@ typedef struct sb_response_frame
    (pVar)->fr_envelope.fr_magic = SB_FRAME_MAGIC;  \
    (pVar)->fr_envelope.fr_size = size;             \
    (pVar)->fr_cmd = cmd;                           \
-   (pVar)->fr_padding = 0;                         \
+   (pVar)->fr_id = 0;                              \
 }
 
 /// initialize the response frame
@@ -57,7 +57,7 @@ typedef struct sb_response_frame
    (pVar)->fr_envelope.fr_magic = SB_FRAME_MAGIC;  \
    (pVar)->fr_envelope.fr_size = size;             \
    (pVar)->fr_returncode = retval;                 \
-   (pVar)->fr_padding = 0;                         \
+   (pVar)->fr_id = 0;                              \
 }
 
 
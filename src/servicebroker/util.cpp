@@ -7,11 +7,13 @@
 ****************************************************************/
 #include "util.hpp"
 #include "config.h"
+#include "GroupCache.hpp"
 #include "Log.hpp"
 #include "Notification.hpp"
 #include "ServicebrokerServer.hpp"
 
-extern ServicebrokerServer* pServer;
+// set up by main()
+ServicebrokerServer* pServer = 0;
 
 
 bool setup(const char* command)
@@ -39,6 +41,11 @@ bool setup(const char* command)
          Log::message( 1, "RECEIVED SHUTDOWN COMMAND" );
          shutdown();
       }
+      else if( 0 == strncmp( command, "flushgroups", 11 ))
+      {
+         Log::message( 1, "FLUSHING GROUP CACHE" );
+         GroupCache::getInstance().clear();
+      }
       else if( 1 == sscanf( command, "disconnect=%s", option ))
       {
          Log::message( 1, "DISCONNECTING %s", option );
@@ -12,10 +12,14 @@
 
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <unistd.h>
 #include <cstdio>
 #include <cstdarg>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include <time.h>
 
@@ -27,6 +31,12 @@
  */
 #define PING_COUNT 70000
 
+/*
+ * Number of attribute updates per notification scenario and number of subscribers receiving them.
+ */
+#define NOTIFICATION_COUNT 10000
+#define CLIENT_COUNT 4
+
 
 using namespace DSI;
 
@@ -36,16 +46,20 @@ TRC_SCOPE_DEF(imp_sys_dsi_test, client, debug);
 namespace /*anonymous*/
 {
    bool sLogging = true;
+   bool sCsv = false;
+
+   /// element counts of the published attribute
+   const unsigned int sAttributeSizes[] = { 1, 100, 10000 };
 }
 
 
 static
-unsigned int current_time_ms()
+uint64_t current_time_ns()
 {
    struct timespec current_time ;
    clock_gettime(CLOCK_MONOTONIC, &current_time);
 
-   return (current_time.tv_sec * 1000) + (current_time.tv_nsec / 1000000) ;
+   return (current_time.tv_sec * 1000000000ULL) + current_time.tv_nsec ;
 }
 
 
@@ -57,31 +71,253 @@ void log(const char* format, ...)
       va_start(args, format);
 
       ::vprintf(format, args);
+
+      va_end(args);
    }
 }
 
 
+/**
+ * @return the number of bytes @c t occupies in a message payload.
+ */
+template<typename T>
+size_t payload_size(const T& t)
+{
+   CRequestWriter writer;
+   COStream ostream(writer);
+   ostream << t;
+
+   return writer.size();
+}
+
+
+// ---------------------------------------------------------------------------------
+
+
+/**
+ * Latency samples and throughput of one benchmark scenario.
+ */
+class CStatistics
+{
+public:
+
+   CStatistics()
+    : mElements(0u)
+    , mClients(0u)
+    , mBytes(0u)
+    , mMessages(0u)
+    , mStartTime(0u)
+   {
+      // NOOP
+   }
+
+
+   /**
+    * Start a new scenario.
+    *
+    * @param bytes Payload size of a single message.
+    * @param messages Number of messages transported per sample.
+    */
+   void start(const char* name, unsigned int elements, unsigned int clients, size_t bytes, unsigned int messages)
+   {
+      mName = name;
+      mElements = elements;
+      mClients = clients;
+      mBytes = bytes;
+      mMessages = messages;
+      mSamples.clear();
+      mStartTime = current_time_ns();
+   }
+
+
+   inline
+   void add(uint64_t latency)
+   {
+      mSamples.push_back(latency);
+   }
+
+
+   void report()
+   {
+      const uint64_t elapsed = current_time_ns() - mStartTime;
+
+      if (mSamples.empty() || elapsed == 0)
+      {
+         log("%-20s %5u x struct(s): no samples\n", mName.c_str(), mElements);
+         return;
+      }
+
+      std::sort(mSamples.begin(), mSamples.end());
+
+      const double messages = (double)mSamples.size() * mMessages;
+      const double msgs_s = messages * 1e9 / elapsed;
+      const double bytes_s = messages * mBytes * 1e9 / elapsed;
+
+      if (sCsv)
+      {
+         ::printf("%s,%s,%u,%u,%u,%u,%llu,%llu,%llu,%llu,%.0f,%.0f\n",
+                  mName.c_str(), transport(), mClients, mElements, (unsigned int)mSamples.size(), (unsigned int)mBytes,
+                  (unsigned long long)percentile(500), (unsigned long long)percentile(990),
+                  (unsigned long long)percentile(999), (unsigned long long)mSamples.back(), msgs_s, bytes_s);
+      }
+      else
+      {
+         log("%-20s %5u x struct(s) %2u client(s): %7u samples, p50 %9.1f us, p99 %9.1f us, p99.9 %9.1f us, max %9.1f us, "
+             "%9.0f msgs/s, %11.0f bytes/s\n",
+             mName.c_str(), mElements, mClients, (unsigned int)mSamples.size(),
+             percentile(500) / 1000.0, percentile(990) / 1000.0, percentile(999) / 1000.0, mSamples.back() / 1000.0,
+             msgs_s, bytes_s);
+      }
+   }
+
+
+   static
+   void header()
+   {
+      if (sCsv)
+         ::printf("scenario,transport,clients,elements,samples,bytes,p50_ns,p99_ns,p999_ns,max_ns,msgs_per_s,bytes_per_s\n");
+   }
+
+
+private:
+
+   /// @return the sample at the given rank of the sorted samples in per mill
+   inline
+   uint64_t percentile(unsigned int permill) const
+   {
+      return mSamples[((mSamples.size() - 1) * permill) / 1000];
+   }
+
+
+   static
+   const char* transport()
+   {
+      return ::getenv("DSI_FORCE_TCP") ? "tcp" : "unix";
+   }
+
+
+   std::string mName;
+   unsigned int mElements;
+   unsigned int mClients;
+   size_t mBytes;
+   unsigned int mMessages;
+   uint64_t mStartTime;
+
+   /// latencies in nanoseconds
+   std::vector<uint64_t> mSamples;
+};
+
+
+// ---------------------------------------------------------------------------------
+
+
+/**
+ * Receiver of attribute notifications, the timestamp of the updated element gives the latency.
+ */
+class CSubscriber
+{
+public:
+
+   virtual ~CSubscriber()
+   {
+      // NOOP
+   }
+
+   /// the subscriber got the current attribute value and receives all updates from now on
+   virtual void subscribed() = 0;
+
+   virtual void delivered(uint64_t latency) = 0;
+
+
+   static
+   void update(CSubscriber& subscriber, bool& subscribed, const DSIBenchmark::PODStructVector& samples,
+               DSI::DataStateType state, DSI::UpdateType type, int16_t position)
+   {
+      if (state != DSI::DATA_OK || samples.empty())
+         return;
+
+      if (!subscribed)
+      {
+         subscribed = true;
+         subscriber.subscribed();
+      }
+      else
+      {
+         const size_t idx = (type == DSI::UPDATE_REPLACE) ? position : 0;
+         subscriber.delivered(current_time_ns() - (uint64_t)samples[idx].aDouble);
+      }
+   }
+};
+
+
+/**
+ * Additional client for the fan-out scenarios, reports to the benchmark driver.
+ */
+class CDSIBenchmarkSubscriberImpl : public CDSIBenchmarkDSIProxy
+{
+public:
+
+   CDSIBenchmarkSubscriberImpl(CSubscriber& driver)
+    : CDSIBenchmarkDSIProxy("GENIVI")
+    , mDriver(driver)
+    , mSubscribed(false)
+   {
+      // NOOP
+   }
+
+
+   void componentConnected()
+   {
+      notifyOnSamples();
+   }
+
+
+   void componentDisconnected()
+   {
+      // NOOP
+   }
+
+
+   void onSamplesUpdate(const DSIBenchmark::PODStructVector& samples, DSI::DataStateType state, DSI::UpdateType type,
+                        int16_t position, int16_t /*count*/)
+   {
+      CSubscriber::update(mDriver, mSubscribed, samples, state, type, position);
+   }
+
+
+private:
+
+   CSubscriber& mDriver;
+   bool mSubscribed;
+};
+
+
 // ---------------------------------------------------------------------------------
 
 
-class CDSIBenchmarkDSIProxyImpl : public CDSIBenchmarkDSIProxy
+class CDSIBenchmarkDSIProxyImpl : public CDSIBenchmarkDSIProxy, public CSubscriber
 {
 public:
-   CDSIBenchmarkDSIProxyImpl(CCommEngine& commEngine, int calls = 1)
+   CDSIBenchmarkDSIProxyImpl(CCommEngine& commEngine, int calls = 1, int notifications = 1, int clients = 1)
     : CDSIBenchmarkDSIProxy("GENIVI")
     , mCommEngine(commEngine)
     , mCalls(calls)
+    , mNotifications(notifications)
+    , mClients(clients)
     , mCounter(0u)
     , mFactor(0u)
     , mStartTime(0u)
-    , mCreationTime(0u)
-    , mCreationAndTransportTime(0u)
+    , mSubscribers(0u)
+    , mSubscribed(false)
+    , mWaiting(false)
+    , mPartial(false)
+    , mSize(0u)
+    , mDelivered(0u)
    {
       mPodStruct.anInt32 = 1;
       mPodStruct.aDouble = 2;
       mPodStruct.anotherDouble = 3;
       mPodStruct.aString = "01234567890123456789";
-      // NOOP
    }
 
 
@@ -91,9 +327,11 @@ public:
 
       log("Client connected to server, starting sending messages in clone mode\n");
 
-      mCreationTime = 0u;
-      mCreationAndTransportTime = 0u;
-      mStartTime = current_time_ms();
+      notifyOnSamples();
+
+      mCounter = 0u;
+      mStatistics.start("callNoArg", 0, 1, 0, 2);
+      mStartTime = current_time_ns();
       requestCallNoArg();
    }
 
@@ -107,23 +345,19 @@ public:
 
    void responseCallNoArg()
    {
-      const unsigned int currentTime = current_time_ms();
+      mStatistics.add(current_time_ns() - mStartTime);
 
-      mCreationAndTransportTime += currentTime - mStartTime;
-      if (mCounter++ < mCalls)
+      if (++mCounter < mCalls)
       {
-         //no creation time
-         mStartTime = currentTime;
+         mStartTime = current_time_ns();
          requestCallNoArg();
       }
       else
       {
-         snapshot();
+         mStatistics.report();
          mFactor = 1u;
          mCounter = 0u;
-         mCreationTime = 0u;
-         mCreationAndTransportTime = 0u;
-         mStartTime = current_time_ms();
+         mStatistics.start("callStruct", mFactor, 1, payload_size(mPodStruct), 2);
          //first time send the prepared struct
          createAndSend(mPodStruct);
       }
@@ -132,62 +366,108 @@ public:
 
    void responseCallStruct(const DSIBenchmark::PODStruct &param)
    {
-      const unsigned int currentTime = current_time_ms();
+      mStatistics.add(current_time_ns() - mStartTime);
 
-      mCreationAndTransportTime += currentTime - mStartTime;
-      if (mCounter++ < mCalls)
+      if (++mCounter < mCalls)
       {
-         mStartTime = currentTime;
          //use the data that we got from the server
          createAndSend(param);
       }
       else
       {
-         snapshot();
-         mFactor *= 10u;
+         mStatistics.report();
          mCounter = 0u;
-         mCreationTime = 0u;
-         mCreationAndTransportTime = 0u;
-         mStartTime = current_time_ms();
-         //first time send the prepared vector
-         createAndSend(mPodStructVector);
+         startStructVector(param);
       }
    }
 
 
    void responseCallStructVector(const DSIBenchmark::PODStructVector &param)
    {
-      const unsigned int currentTime = current_time_ms();
+      mStatistics.add(current_time_ns() - mStartTime);
 
-      mCreationAndTransportTime += currentTime - mStartTime;
-      if (mCounter++ < mCalls)
+      if (++mCounter < mCalls)
       {
-         mStartTime = currentTime;
          //use the data that we got from the server
          createAndSend(param);
       }
       else
       {
-         snapshot();
+         mStatistics.report();
          mCounter = 0u;
-         mCreationTime = 0u;
-         mCreationAndTransportTime = 0u;
+
          if (mFactor < 1000u)
          {
             mFactor *= 10u;
-            mStartTime = current_time_ms();
-            //use the data that we got from the server
-            createAndSend(param);
+            startStructVector(param[0]);
          }
          else
          {
-            //system("ps axv");
-            requestShutdown();
-            mCommEngine.remove(*this);
+            mSize = 0u;
+            mPartial = false;
+            startNotifications();
          }
       }
    }
 
+
+   void onSamplesUpdate(const DSIBenchmark::PODStructVector& samples, DSI::DataStateType state, DSI::UpdateType type,
+                        int16_t position, int16_t /*count*/)
+   {
+      CSubscriber::update(*this, mSubscribed, samples, state, type, position);
+   }
+
+
+   void subscribed()
+   {
+      if (++mSubscribers == mClients && mWaiting)
+      {
+         mWaiting = false;
+         startNotifications();
+      }
+   }
+
+
+   void delivered(uint64_t latency)
+   {
+      // the first round of each scenario is a warm-up, e.g. for partial updates the attribute needs the right size
+      if (mCounter > 0u)
+         mStatistics.add(latency);
+
+      if (++mDelivered == mClients)
+      {
+         mDelivered = 0u;
+
+         if (mCounter++ < mNotifications)
+         {
+            requestPublish(sAttributeSizes[mSize], mPartial);
+         }
+         else
+         {
+            mStatistics.report();
+            mCounter = 0u;
+
+            if (++mSize == sizeof(sAttributeSizes) / sizeof(sAttributeSizes[0]))
+            {
+               mSize = 0u;
+
+               if (mPartial)
+               {
+                  //system("ps axv");
+                  requestShutdown();
+                  mCommEngine.remove(*this);
+                  return;
+               }
+
+               mPartial = true;
+            }
+
+            startNotifications();
+         }
+      }
+   }
+
+
    void responseInvalid( DSIBenchmark::UpdateIdEnum id )
    {
       log("Invalid response for %d\n", id);
@@ -218,50 +498,60 @@ public:
    }
 
 
-   void snapshot()
+   void startStructVector(const DSIBenchmark::PODStruct &param)
+   {
+      DSIBenchmark::PODStructVector localParameter(mFactor, param);
+
+      mStatistics.start("callStructVector", mFactor, 1, payload_size(localParameter), 2);
+      createAndSend(localParameter);
+   }
+
+
+   void startNotifications()
    {
-      if (mCreationAndTransportTime)
+      // all subscribers must have registered before the first update is published
+      if (mSubscribers < mClients)
       {
-         const unsigned int avg_msg_s = (mCalls * 1000 * 2) / mCreationAndTransportTime; //a ping-pong loop has 2 messages
+         mWaiting = true;
+         return;
+      }
 
-         /*
-           Note: creation time can not be measured accurately with the benchmark.
+      const unsigned int elements = sAttributeSizes[mSize];
 
-           We measure the time to create messages on the client side only, therefore we consider the server time equal
-           and double it to get total creation time on both sides.
-         */
-         log("%4u x struct(s): %u calls, total time %u ms, creation time %u, transport time %u, %u msgs/s\n",
-             mFactor, mCalls, mCreationAndTransportTime, 2 * mCreationTime, mCreationAndTransportTime - 2 * mCreationTime, avg_msg_s);
+      if (mPartial)
+      {
+         mStatistics.start("partialNotification", elements, mClients,
+                           payload_size(DSIBenchmark::PODStructVector(1, mPodStruct)), 1);
       }
       else
       {
-         log("%4u x struct(s): Not enough time measurement resolution\n", mFactor);
+         mStatistics.start("notification", elements, mClients,
+                           payload_size(DSIBenchmark::PODStructVector(elements, mPodStruct)), 1);
       }
+
+      mCounter = 0u;
+      mDelivered = 0u;
+      requestPublish(elements, mPartial);
    }
 
 
    void createAndSend(const DSIBenchmark::PODStructVector &param)
    {
-      DSIBenchmark::PODStructVector localParameter(mFactor);
-
-      while (localParameter.size() < mFactor)
-      {
-         localParameter.push_back(param[0]);
-      }
-      mCreationTime += current_time_ms() - mStartTime;
+      mStartTime = current_time_ns();
 
+      DSIBenchmark::PODStructVector localParameter(mFactor, param[0]);
       CDSIBenchmarkDSIProxy::requestCallStructVector(localParameter);
    }
 
 
    void createAndSend(const DSIBenchmark::PODStruct &param)
    {
+      mStartTime = current_time_ns();
+
       /*
         Create a new message and fill it out, the copy constructor will do that for us.
       */
       DSIBenchmark::PODStruct localParameter(param);
-
-      mCreationTime += current_time_ms() - mStartTime;
       requestCallStruct(localParameter);
    }
 
@@ -273,26 +563,44 @@ private:
    /// Number of pings to send per cycle to the server
    unsigned int mCalls;
 
-   /// Number of pings sent in the current cycle to the server
+   /// Number of attribute updates per notification cycle
+   unsigned int mNotifications;
+
+   /// Number of subscribers including this one
+   unsigned int mClients;
+
+   /// Number of pings respectively updates sent in the current cycle to the server
    unsigned int mCounter;
 
    /// Defines how many structs must be sent in this cycle
    unsigned int mFactor;
 
-   /// Time to measure one ping-pong
-   unsigned int mStartTime;
+   /// Time the current ping was sent
+   uint64_t mStartTime;
+
+   /// Number of subscribers that got the initial attribute value
+   unsigned int mSubscribers;
 
-   /// Total time needed to create the messages to be sent to the server per cycle
-   unsigned int mCreationTime;
+   /// This proxy got the initial attribute value
+   bool mSubscribed;
 
-   /// Total time to create and transport the messages to server and back per cycle
-   unsigned int mCreationAndTransportTime;
+   /// The notification cycle waits for the subscribers to register
+   bool mWaiting;
+
+   /// Notification cycles with partial updates
+   bool mPartial;
+
+   /// Index of the attribute size of the current notification cycle
+   unsigned int mSize;
+
+   /// Number of subscribers that got the current update
+   unsigned int mDelivered;
 
    /// The 40 bytes struct to be sent
    DSIBenchmark::PODStruct mPodStruct;
 
-   /// A vector to be used when sending more structs in a call
-   DSIBenchmark::PODStructVector mPodStructVector;
+   /// Measurements of the current cycle
+   CStatistics mStatistics;
 };
 
 
@@ -302,32 +610,60 @@ private:
 int main(int argc, char** argv)
 {
    TRC_SCOPE(imp_sys_dsi_test, client, main);
-   log("Ping client application started\n");
 
    CCommEngine commEngine;
    Log::setDevice(Log::Console);
 
    int calls = PING_COUNT;    // take this as default count of calls
-   if (argc >= 2)
+   int notifications = NOTIFICATION_COUNT;
+   int clients = CLIENT_COUNT;
+
+   for (int i = 1; i < argc; i++)
    {
-      for (int i = 1; i < argc; i++)
+      if (!strncmp(argv[i], "--pings=", 8))
       {
-         if (!strncmp(argv[i], "--pings=", 8))
-         {
-            calls = atoi(argv[1] + 8);
-            assert(calls > 0);
-         }
-         else if (strncmp(argv[i], "--silent", 3))
-         {
-            sLogging = false;
-         }
+         calls = atoi(argv[i] + 8);
+         assert(calls > 0);
+      }
+      else if (!strncmp(argv[i], "--notifications=", 16))
+      {
+         notifications = atoi(argv[i] + 16);
+         assert(notifications > 0);
+      }
+      else if (!strncmp(argv[i], "--clients=", 10))
+      {
+         clients = atoi(argv[i] + 10);
+         assert(clients > 0);
+      }
+      else if (!strcmp(argv[i], "--csv"))
+      {
+         // machine readable output only
+         sCsv = true;
+         sLogging = false;
+      }
+      else if (!strcmp(argv[i], "--silent"))
+      {
+         sLogging = false;
       }
    }
 
-   CDSIBenchmarkDSIProxyImpl proxy(commEngine, calls);
+   log("Ping client application started\n");
+   CStatistics::header();
+
+   CDSIBenchmarkDSIProxyImpl proxy(commEngine, calls, notifications, clients);
    commEngine.add(proxy);
 
+   std::vector<CDSIBenchmarkSubscriberImpl*> subscribers;
+   for (int i = 1; i < clients; ++i)
+   {
+      subscribers.push_back(new CDSIBenchmarkSubscriberImpl(proxy));
+      commEngine.add(*subscribers.back());
+   }
+
    commEngine.run();
 
+   for (size_t i = 0; i < subscribers.size(); ++i)
+      delete subscribers[i];
+
    return 0;
 }
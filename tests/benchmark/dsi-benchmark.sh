@@ -1,10 +1,19 @@
 #!/bin/sh
+#
+# usage: dsi-benchmark.sh [build] [baseline.csv]
+#
+# Runs the benchmark over unix sockets and TCP and writes the results to benchmark-<build>.csv.
+# If a baseline from another build is given the median latency and the throughput are compared.
+#
 if [ -z $1 ]; then
    BUILD="release"
 else
    BUILD="$1"
 fi
 
+BASELINE="$2"
+RESULT="benchmark-${BUILD}.csv"
+
 if [ ! -d /var/run/servicebroker ]; then
   mkdir /var/run/servicebroker
 fi
@@ -12,6 +21,34 @@ killall servicebroker 2> /dev/null
 killall server 2> /dev/null
 killall client 2> /dev/null
 ../../build/${BUILD}/src/servicebroker/servicebroker &
+SB_PID=$!
 sleep 1
-../../build/${BUILD}/tests/benchmark/server &
-../../build/${BUILD}/tests/benchmark/client --pings=70000
+
+run()
+{
+   ../../build/${BUILD}/tests/benchmark/server &
+   sleep 1
+   ../../build/${BUILD}/tests/benchmark/client --pings=70000 --csv
+   wait $!
+}
+
+run > ${RESULT}
+(export DSI_FORCE_TCP=1; run) | tail -n +2 >> ${RESULT}
+
+kill ${SB_PID}
+
+if [ -z "${BASELINE}" ]; then
+   cat ${RESULT}
+else
+   # key is scenario,transport,clients,elements
+   awk -F, '
+      FNR == 1 { next }
+      NR == FNR { p50[$1","$2","$3","$4] = $7; msgs[$1","$2","$3","$4] = $11; next }
+      {
+         key = $1","$2","$3","$4
+         if (key in p50 && p50[key] > 0 && msgs[key] > 0)
+            printf "%-48s p50 %10d ns (%+6.1f%%)  %10d msgs/s (%+6.1f%%)\n", key, $7, 100 * ($7 - p50[key]) / p50[key], $11, 100 * ($11 - msgs[key]) / msgs[key]
+         else
+            printf "%-48s p50 %10d ns  %10d msgs/s (new)\n", key, $7, $11
+      }' ${BASELINE} ${RESULT}
+fi
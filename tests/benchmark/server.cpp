@@ -15,21 +15,40 @@
 #include <cstdlib>
 #include <iostream>
 
+#include <time.h>
+
 TRC_SCOPE_DEF(imp_sys_dsi_test, Server, main);
 
 
 using namespace DSI;
 
 
+static
+double current_time_ns()
+{
+   struct timespec current_time ;
+   clock_gettime(CLOCK_MONOTONIC, &current_time);
+
+   return (current_time.tv_sec * 1000000000.0) + current_time.tv_nsec ;
+}
+
+
 class CDSIBenchmarkDSIStubImpl : public CDSIBenchmarkDSIStub
 {
 public:
 
    CDSIBenchmarkDSIStubImpl(CCommEngine& commEngine)
-      : CDSIBenchmarkDSIStub("GENIVI", false/*enable tcpip*/)
+      : CDSIBenchmarkDSIStub("GENIVI", ::getenv("DSI_FORCE_TCP") ? true : false/*enable tcpip*/)
       , mCommEngine(commEngine)
+      , mRound(0)
    {
-      // NOOP
+      mPodStruct.anInt32 = 1;
+      mPodStruct.aDouble = 2;
+      mPodStruct.anotherDouble = 3;
+      mPodStruct.aString = "01234567890123456789";
+
+      // a valid attribute is sent right away to new subscribers
+      setSamples(DSIBenchmark::PODStructVector(1, mPodStruct));
    }
 
 
@@ -60,6 +79,26 @@ public:
    }
 
 
+   void requestPublish(int32_t elements, bool partial)
+   {
+      if (partial && getSamples().size() == (size_t)elements)
+      {
+         // the subscribers only get the replaced element
+         DSIBenchmark::PODStructVector update(1, mPodStruct);
+         update[0].aDouble = current_time_ns();
+
+         setSamples(update, DSI::UPDATE_REPLACE, mRound++ % elements, 1);
+      }
+      else
+      {
+         DSIBenchmark::PODStructVector update(elements, mPodStruct);
+         update[0].aDouble = current_time_ns();
+
+         setSamples(update);
+      }
+   }
+
+
    void requestShutdown()
    {
       mCommEngine.remove(*this);
@@ -70,6 +109,12 @@ public:
 private:
 
    CCommEngine& mCommEngine;
+
+   /// The struct the published attribute is made of
+   DSIBenchmark::PODStruct mPodStruct;
+
+   /// Number of partial updates so far, selects the element to replace
+   unsigned int mRound;
 };
 
 
@@ -0,0 +1,166 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include "dsi/CCommEngine.hpp"
+
+#include "CAttributesTestDSIProxy.hpp"
+#include "CAttributesTestDSIStub.hpp"
+
+
+/**
+ * Tests setting and clearing the notifications of several attributes with one request:
+ *
+ * 1) The client sets the notifications of both attributes at once, the server sends
+ *    the current values of both.
+ *
+ * 2) The client clears both at once, updates of the attributes do not reach the client
+ *    any more.
+ */
+class CNotifyListTest : public CppUnit::TestFixture
+{
+public:
+
+   CPPUNIT_TEST_SUITE(CNotifyListTest);
+      CPPUNIT_TEST(testNotifyList);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+
+   void testNotifyList();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CNotifyListTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+class CNotifyListTestClient : public CAttributesTestDSIProxy
+{
+public:
+
+   CNotifyListTestClient()
+    : CAttributesTestDSIProxy("attributes")
+    , mUpdateCount(0)
+    , mStopCount(0)
+   {
+      mIds.push_back(AttributesTest::UPD_ID_MyIntAttr);
+      mIds.push_back(AttributesTest::UPD_ID_AnotherIntAttr);
+   }
+
+
+   void componentConnected()
+   {
+      setNotifications(mIds);
+      requestStop();
+   }
+
+
+   void componentDisconnected()
+   {
+      // NOOP
+   }
+
+
+   void onMyIntAttrUpdate( int64_t value, DSI::DataStateType /*state*/)
+   {
+      ++mUpdateCount;
+      CPPUNIT_ASSERT(value == 42ll);
+   }
+
+
+   void onAnotherIntAttrUpdate( int32_t value, DSI::DataStateType /*state*/)
+   {
+      ++mUpdateCount;
+      CPPUNIT_ASSERT(value == 42);
+   }
+
+
+   void responseStopped()
+   {
+      // the initial values of both attributes arrived before the response
+      CPPUNIT_ASSERT(isMyIntAttrValid());
+      CPPUNIT_ASSERT(isAnotherIntAttrValid());
+      CPPUNIT_ASSERT_EQUAL(2, mUpdateCount);
+
+      if (++mStopCount == 1)
+      {
+         // 'AnotherIntAttr' is sent on each update, if still notified
+         clearNotifications(mIds);
+         requestInit();
+         requestStop();
+      }
+      else
+      {
+         CPPUNIT_ASSERT(engine());
+         engine()->stop();
+      }
+   }
+
+private:
+
+   std::vector<notificationid_t> mIds;
+   int mUpdateCount;
+   int mStopCount;
+};
+
+
+// -------------------------------------------------------------------------------------
+
+
+class CNotifyListTestServer : public CAttributesTestDSIStub
+{
+public:
+
+   CNotifyListTestServer()
+    : CAttributesTestDSIStub("attributes", false)
+   {
+      setAnotherIntAttr(42);
+      setMyIntAttr(42);
+   }
+
+
+   void requestInit()
+   {
+      setAnotherIntAttr(42);
+      setMyIntAttr(42);
+   }
+
+
+   void requestInvalidate()
+   {
+      // NOOP
+   }
+
+
+   void requestStop()
+   {
+      responseStopped();
+   }
+};
+
+
+// -------------------------------------------------------------------------------------
+
+
+void CNotifyListTest::testNotifyList()
+{
+   DSI::CCommEngine engine;
+
+   CNotifyListTestServer serv;
+   engine.add(serv);
+
+   CNotifyListTestClient clnt;
+   engine.add(clnt);
+
+   CPPUNIT_ASSERT(engine.run() == 0);
+}
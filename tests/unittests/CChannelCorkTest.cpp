@@ -0,0 +1,163 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sys/socket.h>
+#include <errno.h>
+#include <vector>
+
+#include "dsi/DSI.hpp"
+
+#include "CLocalChannel.hpp"
+#include "CDispatcher.hpp"
+#include "DSI.hpp"
+
+
+class CChannelCorkTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CChannelCorkTest);
+      CPPUNIT_TEST(testCork);
+      CPPUNIT_TEST(testCorkWatermark);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testCork();
+   void testCorkWatermark();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CChannelCorkTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CChannelCorkTest::testCork()
+{
+   int fds[2];
+   CPPUNIT_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+   DSI::Dispatcher dispatcher;
+   DSI::Unix::StreamSocket sock(dispatcher);
+   sock.fd_ = fds[0];
+
+   DSI::CLocalChannel channel(sock);
+
+   char a[] = "0123456789";
+   char b[] = "abcdefghij";
+
+   channel.cork();
+   CPPUNIT_ASSERT(channel.sendAll(a, 10));
+
+   channel.cork();    // nested
+   CPPUNIT_ASSERT(channel.sendAll(b, 10));
+   channel.uncork();
+
+   // nothing written so far
+   char buf[64];
+   CPPUNIT_ASSERT_EQUAL((ssize_t)-1, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+   CPPUNIT_ASSERT_EQUAL(EAGAIN, errno);
+
+   channel.uncork();
+
+   // both messages arrive at once in their order
+   CPPUNIT_ASSERT_EQUAL((ssize_t)20, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+   CPPUNIT_ASSERT(!memcmp(buf, "0123456789abcdefghij", 20));
+
+   // not corked any more
+   CPPUNIT_ASSERT(channel.sendAll(a, 10));
+   CPPUNIT_ASSERT_EQUAL((ssize_t)10, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   CPPUNIT_ASSERT_EQUAL((uint32_t)0, channel.getSendQueueStatistics().deferredMessages);
+
+   // large data is not held back but written along with the corked data
+   std::vector<char> large(70000, 'x');
+   const uint32_t writeCalls = channel.getTransportStatistics().writeCalls;
+
+   channel.cork();
+   CPPUNIT_ASSERT(channel.sendAll(a, 10));
+   CPPUNIT_ASSERT(channel.sendAll(&large[0], large.size()));
+
+   CPPUNIT_ASSERT_EQUAL(writeCalls + 1, channel.getTransportStatistics().writeCalls);
+
+   size_t received = 0;
+   for (ssize_t rc; (rc = ::recv(fds[1], &large[0], large.size(), MSG_DONTWAIT)) > 0; received += rc);
+   CPPUNIT_ASSERT_EQUAL(large.size() + 10, received);
+
+   channel.uncork();
+   CPPUNIT_ASSERT_EQUAL(writeCalls + 1, channel.getTransportStatistics().writeCalls);
+
+   // a write error of the corked data is reported
+   channel.cork();
+   CPPUNIT_ASSERT(channel.sendAll(a, 10));
+
+   ::close(fds[1]);
+   CPPUNIT_ASSERT(!channel.uncork());
+}
+
+
+void CChannelCorkTest::testCorkWatermark()
+{
+   int fds[2];
+   CPPUNIT_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+   DSI::Dispatcher dispatcher;
+   DSI::Unix::StreamSocket sock(dispatcher);
+   sock.fd_ = fds[0];
+
+   DSI::CLocalChannel channel(sock);
+
+   DSI::SendQueueConfig config = { 100, 50, DSI::SendQueueConfig::Drop };
+   channel.setSendQueueConfig(config);
+
+   char payload[60] = { 0 };
+   char buf[256];
+
+   // corked data counts against the high watermark, the third message is dropped
+   channel.cork();
+   for (int i=0; i<3; ++i)
+      CPPUNIT_ASSERT(channel.sendAll(payload, sizeof(payload)));
+
+   CPPUNIT_ASSERT_EQUAL((uint32_t)1, channel.getSendQueueStatistics().droppedMessages);
+
+   CPPUNIT_ASSERT(channel.uncork());
+   CPPUNIT_ASSERT_EQUAL((ssize_t)120, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   // written, so the congestion is gone
+   CPPUNIT_ASSERT(channel.sendAll(payload, sizeof(payload)));
+   CPPUNIT_ASSERT_EQUAL((ssize_t)60, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   // the block policy writes the corked data before the next message
+   config.policy = DSI::SendQueueConfig::Block;
+   channel.setSendQueueConfig(config);
+
+   channel.cork();
+   for (int i=0; i<3; ++i)
+      CPPUNIT_ASSERT(channel.sendAll(payload, sizeof(payload)));
+
+   CPPUNIT_ASSERT_EQUAL((ssize_t)120, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   CPPUNIT_ASSERT(channel.uncork());
+   CPPUNIT_ASSERT_EQUAL((ssize_t)60, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   // the disconnect policy applies to corked data, too
+   config.policy = DSI::SendQueueConfig::Disconnect;
+   channel.setSendQueueConfig(config);
+
+   channel.cork();
+   CPPUNIT_ASSERT(channel.sendAll(payload, sizeof(payload)));
+   CPPUNIT_ASSERT(channel.sendAll(payload, sizeof(payload)));
+   CPPUNIT_ASSERT(!channel.sendAll(payload, sizeof(payload)));
+   CPPUNIT_ASSERT(channel.uncork());
+
+   CPPUNIT_ASSERT_EQUAL((uint32_t)1, channel.getSendQueueStatistics().disconnects);
+   CPPUNIT_ASSERT_EQUAL((ssize_t)0, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+   ::close(fds[1]);
+}
@@ -0,0 +1,242 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <vector>
+
+#include "dsi/CChannel.hpp"
+#include "dsi/CClient.hpp"
+#include "dsi/CIStream.hpp"
+
+#include "DSI.hpp"
+
+
+namespace /*anonymous*/
+{
+
+/// records all data sent
+class CMemoryChannel : public DSI::CChannel
+{
+public:
+
+   bool isOpen() const
+   {
+      return true;
+   }
+
+   bool sendAll(const void* data, size_t len)
+   {
+      mData.append((const char*)data, len);
+      return true;
+   }
+
+   bool sendAll(const DSI::iov_t* iov, size_t iov_len)
+   {
+      for (size_t i=0; i<iov_len; ++i)
+         mData.append((const char*)iov[i].iov_base, iov[i].iov_len);
+
+      return true;
+   }
+
+   bool recvAll(void* /*buf*/, size_t /*len*/)
+   {
+      return false;
+   }
+
+   void asyncRead(DSI::CClientConnectSM* /*sm*/)
+   {
+      // NOOP
+   }
+
+   std::string mData;
+};
+
+
+/// a client connected to the given channel, talking the given protocol minor version
+class CTestClient : public DSI::CClient
+{
+public:
+
+   CTestClient(const std::tr1::shared_ptr<DSI::CChannel>& channel, uint16_t protoMinor)
+    : DSI::CClient("NotifyListTest", "test", 1, 0)
+   {
+      mChannel = channel;
+      mProtoMinor = protoMinor;
+
+      mClientID.s.extendedID = 1;
+      mClientID.s.localID = 2;
+      mServerID.s.extendedID = 3;
+      mServerID.s.localID = 4;
+   }
+
+   using DSI::CClient::setNotifications;
+   using DSI::CClient::clearNotifications;
+
+protected:
+
+   void doComponentConnected()
+   {
+      // NOOP
+   }
+
+   void doComponentDisconnected()
+   {
+      // NOOP
+   }
+
+   void processResponse(DSI::Private::CDataResponseHandle& /*handle*/)
+   {
+      // NOOP
+   }
+};
+
+
+/// a data request as found on the wire
+struct Request
+{
+   uint16_t protoMinor;
+   DSI::RequestType type;
+   uint32_t id;
+   std::vector<notificationid_t> ids;   ///< the payload of list requests
+};
+
+
+std::vector<Request> parse(const std::string& data)
+{
+   std::vector<Request> requests;
+
+   for (size_t pos = 0; pos + sizeof(DSI::MessageHeader) <= data.size(); )
+   {
+      DSI::MessageHeader hdr;
+      data.copy((char*)&hdr, sizeof(hdr), pos);
+      pos += sizeof(hdr);
+
+      CPPUNIT_ASSERT_EQUAL((uint32_t)DSI::DataRequest, hdr.cmd);
+      CPPUNIT_ASSERT(pos + hdr.packetLength <= data.size());
+
+      DSI::EventInfo info;
+      data.copy((char*)&info, sizeof(info), pos);
+
+      Request request;
+      request.protoMinor = hdr.protoMinor;
+      request.type = info.requestType;
+      request.id = info.requestID;
+
+      if (info.requestType == DSI::REQUEST_NOTIFY_LIST || info.requestType == DSI::REQUEST_STOP_NOTIFY_LIST)
+      {
+         DSI::CIStream istream(data.data() + pos + sizeof(info), hdr.packetLength - sizeof(info));
+         istream >> request.ids;
+         CPPUNIT_ASSERT_EQUAL(0, (int)istream.getError());
+      }
+
+      requests.push_back(request);
+      pos += hdr.packetLength;
+   }
+
+   return requests;
+}
+
+}   // namespace anonymous
+
+
+class CClientNotifyListTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CClientNotifyListTest);
+      CPPUNIT_TEST(testList);
+      CPPUNIT_TEST(testFallback);
+      CPPUNIT_TEST(testEmpty);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testList();
+   void testFallback();
+   void testEmpty();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CClientNotifyListTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CClientNotifyListTest::testList()
+{
+   std::tr1::shared_ptr<CMemoryChannel> channel(new CMemoryChannel);
+   CTestClient client(channel, DSI::NotifyListProtoMinor);
+
+   std::vector<notificationid_t> ids;
+   ids.push_back(7);
+   ids.push_back(3);
+   ids.push_back(42);
+
+   client.setNotifications(ids);
+   client.clearNotifications(ids);
+
+   // one request each, carrying all ids in their order
+   std::vector<Request> requests = parse(channel->mData);
+   CPPUNIT_ASSERT_EQUAL((size_t)2, requests.size());
+
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_NOTIFY_LIST, requests[0].type);
+   CPPUNIT_ASSERT_EQUAL((uint16_t)DSI::NotifyListProtoMinor, requests[0].protoMinor);
+   CPPUNIT_ASSERT(ids == requests[0].ids);
+
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_STOP_NOTIFY_LIST, requests[1].type);
+   CPPUNIT_ASSERT(ids == requests[1].ids);
+}
+
+
+void CClientNotifyListTest::testFallback()
+{
+   std::tr1::shared_ptr<CMemoryChannel> channel(new CMemoryChannel);
+   CTestClient client(channel, DSI::NotifyListProtoMinor - 1);
+
+   std::vector<notificationid_t> ids;
+   ids.push_back(7);
+   ids.push_back(3);
+
+   client.setNotifications(ids);
+   client.clearNotifications(ids);
+
+   client.clearAllNotifications();
+
+   // servers not knowing the list requests get one request per id
+   std::vector<Request> requests = parse(channel->mData);
+   CPPUNIT_ASSERT_EQUAL((size_t)5, requests.size());
+
+   // all tagged with the negotiated version, the server ignores requests of any other
+   for (size_t i=0; i<requests.size(); ++i)
+      CPPUNIT_ASSERT_EQUAL((uint16_t)(DSI::NotifyListProtoMinor - 1), requests[i].protoMinor);
+
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_NOTIFY, requests[0].type);
+   CPPUNIT_ASSERT_EQUAL(7u, requests[0].id);
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_NOTIFY, requests[1].type);
+   CPPUNIT_ASSERT_EQUAL(3u, requests[1].id);
+
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_STOP_NOTIFY, requests[2].type);
+   CPPUNIT_ASSERT_EQUAL(7u, requests[2].id);
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_STOP_NOTIFY, requests[3].type);
+   CPPUNIT_ASSERT_EQUAL(3u, requests[3].id);
+
+   CPPUNIT_ASSERT_EQUAL(DSI::REQUEST_STOP_ALL_NOTIFY, requests[4].type);
+}
+
+
+void CClientNotifyListTest::testEmpty()
+{
+   std::tr1::shared_ptr<CMemoryChannel> channel(new CMemoryChannel);
+   CTestClient client(channel, DSI::NotifyListProtoMinor);
+
+   // nothing to send
+   client.setNotifications(std::vector<notificationid_t>());
+   client.clearNotifications(std::vector<notificationid_t>());
+
+   CPPUNIT_ASSERT(channel->mData.empty());
+}
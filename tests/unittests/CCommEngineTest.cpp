@@ -0,0 +1,109 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <pthread.h>
+#include <tr1/functional>
+
+#include "dsi/CCommEngine.hpp"
+
+#include "Thread.hpp"
+#include "Trigger.hpp"
+
+
+namespace /*anonymous*/
+{
+
+void runEngine(DSI::CCommEngine* engine, int* rc)
+{
+   *rc = engine->run();
+}
+
+
+void record(pthread_t* thread, DSI::Trigger* done)
+{
+   *thread = ::pthread_self();
+   (void)done->signal();
+}
+
+}   // namespace anonymous
+
+
+class CCommEngineTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CCommEngineTest);
+      CPPUNIT_TEST(testPost);
+      CPPUNIT_TEST(testStop);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testPost();
+   void testStop();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CCommEngineTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CCommEngineTest::testPost()
+{
+   DSI::CCommEngine engine(2);
+   CPPUNIT_ASSERT_EQUAL(2u, engine.getShardCount());
+
+   pthread_t threads[3];
+   DSI::Trigger done[3];
+
+   // posted before the engine runs, called once it does
+   engine.post(std::tr1::bind(&record, &threads[0], &done[0]), 0);
+   CPPUNIT_ASSERT(!done[0].timed_wait(50));
+
+   int rc = -1;
+
+   {
+      DSI::Thread runner(std::tr1::bind(&runEngine, &engine, &rc));
+      CPPUNIT_ASSERT(done[0].timed_wait(5000));
+
+      // posted from a foreign thread, the loops are woken up
+      engine.post(std::tr1::bind(&record, &threads[1], &done[1]), 0);
+      engine.post(std::tr1::bind(&record, &threads[2], &done[2]), 1);
+
+      CPPUNIT_ASSERT(done[1].timed_wait(5000));
+      CPPUNIT_ASSERT(done[2].timed_wait(5000));
+
+      // each shard runs its own loop, neither in the posting thread
+      CPPUNIT_ASSERT(::pthread_equal(threads[0], threads[1]));
+      CPPUNIT_ASSERT(!::pthread_equal(threads[1], threads[2]));
+      CPPUNIT_ASSERT(!::pthread_equal(threads[1], ::pthread_self()));
+      CPPUNIT_ASSERT(!::pthread_equal(threads[2], ::pthread_self()));
+
+      engine.stop(3);
+   }
+
+   CPPUNIT_ASSERT_EQUAL(3, rc);
+}
+
+
+void CCommEngineTest::testStop()
+{
+   DSI::CCommEngine engine(2);
+
+   int rc = -1;
+
+   {
+      DSI::Thread runner(std::tr1::bind(&runEngine, &engine, &rc));
+
+      // stopping from within the second shard wakes up the first one and with it all others
+      engine.post(std::tr1::bind(&DSI::CCommEngine::stop, &engine, 7), 1);
+   }
+
+   CPPUNIT_ASSERT_EQUAL(7, rc);
+}
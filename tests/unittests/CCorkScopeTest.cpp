@@ -0,0 +1,117 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sys/socket.h>
+#include <errno.h>
+
+#include "dsi/DSI.hpp"
+#include "dsi/CRequestWriter.hpp"
+
+#include "CLocalChannel.hpp"
+#include "CCorkScope.hpp"
+#include "CDispatcher.hpp"
+#include "TimerWheel.hpp"
+#include "DSI.hpp"
+
+
+namespace /*anonymous*/
+{
+
+bool stopDispatcher(DSI::Dispatcher* dispatcher, DSI::io::error_code)
+{
+   dispatcher->stop(0);
+   return false;
+}
+
+}   // namespace anonymous
+
+
+class CCorkScopeTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CCorkScopeTest);
+      CPPUNIT_TEST(testCorkScope);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testCorkScope();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CCorkScopeTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CCorkScopeTest::testCorkScope()
+{
+   int fds[2];
+   CPPUNIT_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+   DSI::Dispatcher dispatcher;
+   DSI::Unix::StreamSocket sock(dispatcher);
+   sock.fd_ = fds[0];
+
+   DSI::CLocalChannel channel(sock);
+
+   char buf[256];
+
+   // no scope, written directly
+   {
+      DSI::CRequestWriter writer(channel, DSI::REQUEST, DSI::DataRequest, 42, SPartyID(), SPartyID());
+   }
+
+   const ssize_t length = ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT);
+   CPPUNIT_ASSERT(length > 0);
+
+   {
+      DSI::CCorkScope scope(dispatcher);
+
+      for (int i=0; i<2; ++i)
+         DSI::CRequestWriter writer(channel, DSI::REQUEST, DSI::DataRequest, 42, SPartyID(), SPartyID());
+
+      CPPUNIT_ASSERT_EQUAL((ssize_t)-1, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+      CPPUNIT_ASSERT_EQUAL(EAGAIN, errno);
+
+      // the end of a dispatcher round uncorks
+      DSI::TimerWheel::Timer timer;
+      dispatcher.timers().start(timer, 1, std::tr1::bind(&stopDispatcher, &dispatcher, std::tr1::placeholders::_1));
+      CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+      CPPUNIT_ASSERT_EQUAL(2 * length, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+
+      // the destruction of the scope, too
+      DSI::CRequestWriter(channel, DSI::REQUEST, DSI::DataRequest, 42, SPartyID(), SPartyID());
+      CPPUNIT_ASSERT_EQUAL((ssize_t)-1, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+   }
+
+   CPPUNIT_ASSERT_EQUAL(length, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+   CPPUNIT_ASSERT_EQUAL((uint32_t)0, channel.getSendQueueStatistics().deferredMessages);
+
+   // four messages with three writes
+   CPPUNIT_ASSERT_EQUAL(4u, channel.getTransportStatistics().messagesSent);
+   CPPUNIT_ASSERT_EQUAL(3u, channel.getTransportStatistics().writeCalls);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)(4 * length), channel.getTransportStatistics().bytesSent);
+
+   // messages with multiple fragments are not corked
+   {
+      DSI::CCorkScope scope(dispatcher);
+      DSI::CRequestWriter writer(channel, DSI::REQUEST, DSI::DataRequest, 42, SPartyID(), SPartyID());
+
+      writer.sbrk(2 * DSI_PACKET_SIZE);
+      ::memset(writer.pptr(), 0, 2 * DSI_PACKET_SIZE);
+      writer.pbump(2 * DSI_PACKET_SIZE);
+
+      CPPUNIT_ASSERT(writer.flush());
+      CPPUNIT_ASSERT(::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT) > 0);
+   }
+
+   ::close(fds[1]);
+}
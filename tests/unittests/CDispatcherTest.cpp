@@ -0,0 +1,204 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+#include <tr1/functional>
+
+#include "CDispatcher.hpp"
+
+
+namespace /*anonymous*/
+{
+
+struct CountingHandler
+{
+   CountingHandler(int fd, int& hits, bool rearm = false)
+    : fd_(fd)
+    , hits_(&hits)
+    , rearm_(rearm)
+   {
+      // NOOP
+   }
+
+   bool operator()(DSI::GenericEventBase::Result result)
+   {
+      ++*hits_;
+
+      if (result == DSI::GenericEventBase::DataAvailable)
+      {
+         char c;
+         (void)::read(fd_, &c, 1);
+      }
+
+      return rearm_;
+   }
+
+   int fd_;
+   int* hits_;
+   bool rearm_;
+};
+
+typedef DSI::GenericEvent<CountingHandler> tCountingEvent;
+
+
+void stopAfter(DSI::Dispatcher* disp, int* rounds, int max)
+{
+   if (++*rounds == max)
+      disp->stop(0);
+}
+
+
+template<typename DispatcherT>
+void runGrowth()
+{
+   DispatcherT disp(4);   // small capacity, must grow
+   std::vector<int> fds;
+
+   int hits = 0;
+   for (int i=0; i<100; ++i)
+   {
+      int p[2];
+      CPPUNIT_ASSERT(::pipe(p) == 0);
+      fds.push_back(p[0]);
+      fds.push_back(p[1]);
+
+      disp.enqueueEvent(p[0], new tCountingEvent(CountingHandler(p[0], hits)), POLLIN);
+      CPPUNIT_ASSERT(::write(p[1], "x", 1) == 1);
+   }
+
+   while(disp.poll(100) > 0);
+   CPPUNIT_ASSERT_EQUAL(100, hits);
+
+   // events are not rearmed
+   hits = 0;
+   CPPUNIT_ASSERT_EQUAL(0, disp.poll(10));
+   CPPUNIT_ASSERT_EQUAL(0, hits);
+
+   for (unsigned int i=0; i<fds.size(); ++i)
+      ::close(fds[i]);
+}
+
+
+template<typename DispatcherT>
+void runReadWrite()
+{
+   DispatcherT disp;
+
+   int sv[2];
+   CPPUNIT_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+   int reads = 0;
+   int writes = 0;
+   disp.enqueueEvent(sv[0], new tCountingEvent(CountingHandler(sv[0], reads, true)), POLLIN);
+   disp.enqueueEvent(sv[0], new tCountingEvent(CountingHandler(sv[0], writes)), POLLOUT);
+
+   (void)disp.poll(10);
+   CPPUNIT_ASSERT_EQUAL(0, reads);
+   CPPUNIT_ASSERT_EQUAL(1, writes);
+
+   CPPUNIT_ASSERT(::write(sv[1], "x", 1) == 1);
+   (void)disp.poll(10);
+   CPPUNIT_ASSERT_EQUAL(1, reads);
+   CPPUNIT_ASSERT_EQUAL(1, writes);
+
+   // the read event is rearmed, remove it explicitly
+   disp.template removeEvent<DSI::ReadEventTraits<void> >(sv[0]);
+   CPPUNIT_ASSERT(::write(sv[1], "x", 1) == 1);
+   CPPUNIT_ASSERT_EQUAL(0, disp.poll(10));
+   CPPUNIT_ASSERT_EQUAL(1, reads);
+
+   // invalid file descriptors are reported
+   int hits = 0;
+   disp.removeAll(sv[0]);
+   ::close(sv[0]);
+   disp.enqueueEvent(sv[0], new tCountingEvent(CountingHandler(sv[0], hits)), POLLIN);
+   (void)disp.poll(10);
+   CPPUNIT_ASSERT_EQUAL(1, hits);
+
+   ::close(sv[1]);
+}
+
+}   // namespace
+
+
+class CDispatcherTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CDispatcherTest);
+      CPPUNIT_TEST(testPollGrowth);
+      CPPUNIT_TEST(testPollReadWrite);
+      CPPUNIT_TEST(testEpollGrowth);
+      CPPUNIT_TEST(testEpollReadWrite);
+      CPPUNIT_TEST(testStatistics);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testPollGrowth();
+   void testPollReadWrite();
+   void testEpollGrowth();
+   void testEpollReadWrite();
+   void testStatistics();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CDispatcherTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CDispatcherTest::testPollGrowth()
+{
+   runGrowth<DSI::PollDispatcher>();
+}
+
+
+void CDispatcherTest::testPollReadWrite()
+{
+   runReadWrite<DSI::PollDispatcher>();
+}
+
+
+void CDispatcherTest::testEpollGrowth()
+{
+   runGrowth<DSI::EpollDispatcher>();
+}
+
+
+void CDispatcherTest::testEpollReadWrite()
+{
+   runReadWrite<DSI::EpollDispatcher>();
+}
+
+
+void CDispatcherTest::testStatistics()
+{
+   DSI::Dispatcher disp;
+   CPPUNIT_ASSERT_EQUAL((uint64_t)0, disp.statistics().rounds);
+
+   int sv[2];
+   CPPUNIT_ASSERT(::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+
+   // always writable, so no round waits
+   int writes = 0;
+   disp.enqueueEvent(sv[0], new tCountingEvent(CountingHandler(sv[0], writes, true)), POLLOUT);
+
+   int rounds = 0;
+   disp.setRoundHandler(std::tr1::bind(&stopAfter, &disp, &rounds, 3));
+   CPPUNIT_ASSERT_EQUAL(0, disp.run());
+
+   CPPUNIT_ASSERT_EQUAL(3, writes);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)3, disp.statistics().rounds);
+   CPPUNIT_ASSERT(disp.statistics().maxBusyNs <= disp.statistics().busyNs);
+   CPPUNIT_ASSERT(3 * disp.statistics().maxBusyNs >= disp.statistics().busyNs);
+
+   disp.removeAll(sv[0]);
+   ::close(sv[0]);
+   ::close(sv[1]);
+}
@@ -0,0 +1,189 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <unistd.h>
+
+#include "dsi/CMappedTracer.hpp"
+
+#include "tracefile.h"
+
+
+class CMappedTracerTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CMappedTracerTest);
+      CPPUNIT_TEST(testInterfaces);
+      CPPUNIT_TEST(testRecords);
+      CPPUNIT_TEST(testWrapAround);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void setUp();
+   void tearDown();
+
+   void testInterfaces();
+   void testRecords();
+   void testWrapAround();
+
+private:
+
+   /// read the trace file back into memory
+   void load();
+
+   const dsi_tracefile_header_t& header() const
+   {
+      return *reinterpret_cast<const dsi_tracefile_header_t*>(&mFile[0]);
+   }
+
+   const dsi_tracefile_record_t& record(unsigned int slot) const
+   {
+      return *reinterpret_cast<const dsi_tracefile_record_t*>(
+         &mFile[DSI_TRACEFILE_RECORDS_OFFSET + slot * header().recordSize]);
+   }
+
+   static SFNDInterfaceDescription makeInterface(const char* name, int major, int minor);
+
+   char mPath[64];
+   std::vector<char> mFile;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CMappedTracerTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CMappedTracerTest::setUp()
+{
+   (void)::snprintf(mPath, sizeof(mPath), "/tmp/dsi_tracertest_%d", (int)::getpid());
+}
+
+
+void CMappedTracerTest::tearDown()
+{
+   (void)::unlink(mPath);
+}
+
+
+void CMappedTracerTest::load()
+{
+   std::ifstream ifs(mPath, std::ios::in | std::ios::binary);
+   mFile.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+   CPPUNIT_ASSERT(mFile.size() >= DSI_TRACEFILE_RECORDS_OFFSET);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)DSI_TRACEFILE_MAGIC, header().magic);
+}
+
+
+SFNDInterfaceDescription CMappedTracerTest::makeInterface(const char* name, int major, int minor)
+{
+   SFNDInterfaceDescription iface;
+   ::memset(&iface, 0, sizeof(iface));
+
+   ::strcpy(iface.name, name);
+   iface.version.majorVersion = major;
+   iface.version.minorVersion = minor;
+
+   return iface;
+}
+
+
+void CMappedTracerTest::testInterfaces()
+{
+   DSI::Trace::CMappedTracer tracer(mPath, 4);
+
+   int h1 = tracer.open(makeInterface("Foo", 1, 0), DSI::Trace::In);
+   int h2 = tracer.open(makeInterface("Foo", 1, 0), DSI::Trace::Out);
+   int h3 = tracer.open(makeInterface("Foo", 1, 1), DSI::Trace::In);
+
+   CPPUNIT_ASSERT(h1 >= 0);
+   CPPUNIT_ASSERT(h2 >= 0);
+   CPPUNIT_ASSERT(h3 >= 0);
+
+   // same interface, different direction
+   CPPUNIT_ASSERT_EQUAL(h1 >> 1, h2 >> 1);
+   CPPUNIT_ASSERT(h1 != h2);
+
+   // other version, other interface
+   CPPUNIT_ASSERT(h1 >> 1 != h3 >> 1);
+
+   CPPUNIT_ASSERT(!tracer.isPayloadEnabled(h1));
+
+   load();
+   CPPUNIT_ASSERT_EQUAL(std::string("Foo"), std::string(header().interfaces[h3 >> 1].name));
+   CPPUNIT_ASSERT_EQUAL((uint16_t)1, header().interfaces[h3 >> 1].minorVersion);
+}
+
+
+void CMappedTracerTest::testRecords()
+{
+   DSI::Trace::CMappedTracer tracer(mPath, 4, 8);
+
+   int handle = tracer.open(makeInterface("Foo", 1, 0), DSI::Trace::Out);
+   CPPUNIT_ASSERT(tracer.isPayloadEnabled(handle));
+
+   DSI::MessageHeader hdr(SPartyID(), SPartyID(), DSI::DataRequest);
+   hdr.serverID.globalID = 42;
+   hdr.packetLength = 16;
+
+   DSI::EventInfo info;
+   info.requestID = 7;
+   info.requestType = DSI::REQUEST;
+   info.sequenceNumber = 3;
+
+   const char payload[] = "0123456789abcdef";
+   tracer.write(handle, &hdr, &info, payload, 16);
+
+   load();
+   CPPUNIT_ASSERT_EQUAL((uint64_t)1, header().next);
+
+   const dsi_tracefile_record_t& rec = record(0);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)1, rec.position);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)42, rec.serverID);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)DSI::DataRequest, rec.cmd);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)7, rec.requestID);
+   CPPUNIT_ASSERT_EQUAL(3, rec.sequenceNumber);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)16, rec.packetLength);
+   CPPUNIT_ASSERT_EQUAL((uint8_t)DSI::Trace::Out, rec.direction);
+
+   // payload truncated to the configured size
+   CPPUNIT_ASSERT_EQUAL((uint32_t)8, rec.payloadLength);
+   CPPUNIT_ASSERT(::memcmp(&rec + 1, payload, 8) == 0);
+}
+
+
+void CMappedTracerTest::testWrapAround()
+{
+   DSI::Trace::CMappedTracer tracer(mPath, 4);
+
+   int handle = tracer.open(makeInterface("Foo", 1, 0), DSI::Trace::In);
+   DSI::MessageHeader hdr(SPartyID(), SPartyID(), DSI::DisconnectRequest);
+
+   for (int i=0; i<6; ++i)
+   {
+      hdr.packetLength = i;
+      tracer.write(handle, &hdr, 0, 0, 0);
+   }
+
+   load();
+   CPPUNIT_ASSERT_EQUAL((uint64_t)6, header().next);
+
+   // the first two records are overwritten
+   CPPUNIT_ASSERT_EQUAL((uint64_t)5, record(0).position);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)4, record(0).packetLength);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)6, record(1).position);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)3, record(2).position);
+   CPPUNIT_ASSERT_EQUAL((uint8_t)0, record(2).hasInfo);
+}
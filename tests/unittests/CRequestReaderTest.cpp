@@ -0,0 +1,304 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <errno.h>
+#include <string>
+
+#include "dsi/CChannel.hpp"
+#include "dsi/CRequestWriter.hpp"
+
+#include "CRequestReader.hpp"
+#include "CReceiveBufferPool.hpp"
+#include "DSI.hpp"
+
+
+namespace /*anonymous*/
+{
+
+/// loopback channel in memory
+class CMemoryChannel : public DSI::CChannel
+{
+public:
+
+   CMemoryChannel()
+    : mPos(0)
+   {
+      // NOOP
+   }
+
+   bool isOpen() const
+   {
+      return true;
+   }
+
+   bool sendAll(const void* data, size_t len)
+   {
+      mData.append((const char*)data, len);
+      return true;
+   }
+
+   bool sendAll(const DSI::iov_t* iov, size_t iov_len)
+   {
+      for (size_t i=0; i<iov_len; ++i)
+         mData.append((const char*)iov[i].iov_base, iov[i].iov_len);
+
+      return true;
+   }
+
+   bool recvAll(void* buf, size_t len)
+   {
+      if (mPos + len > mData.size())
+         return false;
+
+      mData.copy((char*)buf, len, mPos);
+      mPos += len;
+
+      return true;
+   }
+
+   void asyncRead(DSI::CClientConnectSM* /*sm*/)
+   {
+      // NOOP
+   }
+
+   std::string mData;
+   size_t mPos;
+};
+
+
+/// header of a fragment of a message announcing the given total length, the payload is appended to the channel
+DSI::MessageHeader fragment(CMemoryChannel& channel, uint32_t length, bool more, uint32_t total = 0)
+{
+   DSI::MessageHeader hdr(SPartyID(), SPartyID(), DSI::DataRequest, DSI_PROTOCOL_VERSION_MINOR, length);
+   hdr.flags = more ? DSI_MORE_DATA_FLAG : 0;
+   hdr.reserved[0] = total;
+
+   channel.mData.append(std::string(length, 'x'));
+   return hdr;
+}
+
+}   // namespace
+
+
+class CRequestReaderTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CRequestReaderTest);
+      CPPUNIT_TEST(testPool);
+      CPPUNIT_TEST(testSingleFragment);
+      CPPUNIT_TEST(testMultiFragment);
+      CPPUNIT_TEST(testLargeFrame);
+      CPPUNIT_TEST(testNegotiateFrameSize);
+      CPPUNIT_TEST(testAnnouncedSize);
+      CPPUNIT_TEST(testFanOut);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testPool();
+   void testSingleFragment();
+   void testMultiFragment();
+   void testLargeFrame();
+   void testNegotiateFrameSize();
+   void testAnnouncedSize();
+   void testFanOut();
+
+private:
+   void roundtrip(size_t payloadLength, uint32_t maxFrameSize = DSI_PACKET_SIZE);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CRequestReaderTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CRequestReaderTest::testPool()
+{
+   DSI::CReceiveBufferPool pool;
+
+   size_t capacity = 10000;
+   char* buf = pool.acquire(capacity);
+   CPPUNIT_ASSERT(buf != 0);
+   CPPUNIT_ASSERT_EQUAL((size_t)16384, capacity);
+
+   pool.release(buf, capacity);
+
+   // same size class is recycled
+   capacity = 9000;
+   CPPUNIT_ASSERT(pool.acquire(capacity) == buf);
+   pool.release(buf, capacity);
+}
+
+
+void CRequestReaderTest::roundtrip(size_t payloadLength, uint32_t maxFrameSize)
+{
+   CMemoryChannel channel;
+   channel.setMaxFrameSize(maxFrameSize);
+
+   std::string payload;
+   for (size_t i=0; i<payloadLength; ++i)
+      payload += char('a' + i % 26);
+
+   {
+      DSI::CRequestWriter writer(channel, DSI::REQUEST, DSI::DataRequest, 42, SPartyID(), SPartyID());
+      writer.sbrk(payload.size());
+      memcpy(writer.pptr(), payload.data(), payload.size());
+      writer.pbump(payload.size());
+
+      CPPUNIT_ASSERT(writer.flush());
+   }
+
+   DSI::MessageHeader hdr;
+   CPPUNIT_ASSERT(channel.recvAll(&hdr, sizeof(hdr)));
+
+   if (payloadLength + sizeof(DSI::EventInfo) + sizeof(DSI::MessageHeader) > maxFrameSize)
+   {
+      CPPUNIT_ASSERT(hdr.flags & DSI_MORE_DATA_FLAG);
+      CPPUNIT_ASSERT_EQUAL(payloadLength + sizeof(DSI::EventInfo), (size_t)hdr.reserved[0]);
+   }
+   else
+   {
+      CPPUNIT_ASSERT(!(hdr.flags & DSI_MORE_DATA_FLAG));
+      CPPUNIT_ASSERT_EQUAL(payloadLength + sizeof(DSI::EventInfo), (size_t)hdr.packetLength);
+   }
+
+   DSI::CReceiveBufferPool pool;
+   DSI::CRequestReader reader(hdr, channel, pool);
+
+   CPPUNIT_ASSERT(reader.receiveAll());
+   CPPUNIT_ASSERT_EQUAL(payloadLength + sizeof(DSI::EventInfo), reader.size());
+   CPPUNIT_ASSERT_EQUAL(42u, ((const DSI::EventInfo*)reader.buffer())->requestID);
+   CPPUNIT_ASSERT(payload == std::string(reader.buffer() + sizeof(DSI::EventInfo), payloadLength));
+
+   // everything consumed
+   CPPUNIT_ASSERT_EQUAL(channel.mData.size(), channel.mPos);
+
+   const size_t frameLength = maxFrameSize - sizeof(DSI::MessageHeader);
+   const uint32_t fragments = (payloadLength + sizeof(DSI::EventInfo) + frameLength - 1) / frameLength - 1;
+
+   const DSI::TransportStatistics& stats = channel.getTransportStatistics();
+   CPPUNIT_ASSERT_EQUAL(1u, stats.messagesSent);
+   CPPUNIT_ASSERT_EQUAL(1u, stats.messagesReceived);
+   CPPUNIT_ASSERT_EQUAL(fragments, stats.fragmentsSent);
+   CPPUNIT_ASSERT_EQUAL(fragments, stats.fragmentsReassembled);
+}
+
+
+void CRequestReaderTest::testSingleFragment()
+{
+   roundtrip(100);
+}
+
+
+void CRequestReaderTest::testMultiFragment()
+{
+   roundtrip(3 * DSI_PACKET_SIZE + 17);
+}
+
+
+void CRequestReaderTest::testLargeFrame()
+{
+   // one frame if the frame size was negotiated
+   roundtrip(3 * DSI_PACKET_SIZE + 17, 64 * 1024);
+
+   // fragmented into large frames
+   roundtrip(3 * DSI_PACKET_SIZE + 17, 2 * DSI_PACKET_SIZE);
+}
+
+
+void CRequestReaderTest::testNegotiateFrameSize()
+{
+   // legacy peers
+   CPPUNIT_ASSERT_EQUAL((uint32_t)DSI_PACKET_SIZE, DSI::negotiateMaxFrameSize(0, 64 * 1024));
+   CPPUNIT_ASSERT_EQUAL((uint32_t)DSI_PACKET_SIZE, DSI::negotiateMaxFrameSize(DSI::LargeFramesProtoMinor, 0));
+
+   // the smaller size wins
+   CPPUNIT_ASSERT_EQUAL((uint32_t)(64 * 1024), DSI::negotiateMaxFrameSize(DSI::LargeFramesProtoMinor, 64 * 1024));
+   CPPUNIT_ASSERT_EQUAL(DSI::getMaxFrameSize(), DSI::negotiateMaxFrameSize(DSI::LargeFramesProtoMinor, 0x7FFFFFFF));
+}
+
+
+void CRequestReaderTest::testAnnouncedSize()
+{
+   DSI::CReceiveBufferPool pool;
+
+   {
+      // never allocated
+      CMemoryChannel channel;
+      DSI::MessageHeader hdr = fragment(channel, 100, true, 0xFFFFFFFFu);
+
+      DSI::CRequestReader reader(hdr, channel, pool);
+      CPPUNIT_ASSERT(!reader.receiveAll());
+      CPPUNIT_ASSERT_EQUAL(EMSGSIZE, errno);
+   }
+
+   {
+      // overshooting
+      CMemoryChannel channel;
+      DSI::MessageHeader hdr = fragment(channel, 100, true, 300);
+      DSI::MessageHeader last = fragment(channel, 250, false);
+      channel.mData.insert(100, (const char*)&last, sizeof(last));
+
+      DSI::CRequestReader reader(hdr, channel, pool);
+      CPPUNIT_ASSERT(!reader.receiveAll());
+      CPPUNIT_ASSERT_EQUAL(EMSGSIZE, errno);
+   }
+
+   {
+      // last fragment too short
+      CMemoryChannel channel;
+      DSI::MessageHeader hdr = fragment(channel, 100, true, 300);
+      DSI::MessageHeader last = fragment(channel, 100, false);
+      channel.mData.insert(100, (const char*)&last, sizeof(last));
+
+      DSI::CRequestReader reader(hdr, channel, pool);
+      CPPUNIT_ASSERT(!reader.receiveAll());
+      CPPUNIT_ASSERT_EQUAL(EPROTO, errno);
+   }
+
+   {
+      CMemoryChannel channel;
+      DSI::MessageHeader hdr = fragment(channel, 100, true, 300);
+      DSI::MessageHeader last = fragment(channel, 200, false);
+      channel.mData.insert(100, (const char*)&last, sizeof(last));
+
+      DSI::CRequestReader reader(hdr, channel, pool);
+      CPPUNIT_ASSERT(reader.receiveAll());
+      CPPUNIT_ASSERT_EQUAL((size_t)300, reader.size());
+   }
+}
+
+
+void CRequestReaderTest::testFanOut()
+{
+   DSI::CRequestWriter writer(DSI::RESULT_OK, DSI::DataResponse, 42);
+
+   const size_t payloadLength = 2 * DSI_PACKET_SIZE;
+   writer.sbrk(payloadLength);
+   memset(writer.pptr(), 'x', payloadLength);
+   writer.pbump(payloadLength);
+
+   CMemoryChannel fragmented;
+   CPPUNIT_ASSERT(writer.flush(fragmented, SPartyID(), SPartyID(), DSI_PROTOCOL_VERSION_MINOR, 1));
+
+   DSI::MessageHeader hdr;
+   CPPUNIT_ASSERT(fragmented.recvAll(&hdr, sizeof(hdr)));
+   CPPUNIT_ASSERT(hdr.flags & DSI_MORE_DATA_FLAG);
+   CPPUNIT_ASSERT_EQUAL(payloadLength + sizeof(DSI::EventInfo), (size_t)hdr.reserved[0]);
+
+   // the same writer sends a single frame without the former total
+   CMemoryChannel large;
+   large.setMaxFrameSize(64 * 1024);
+   CPPUNIT_ASSERT(writer.flush(large, SPartyID(), SPartyID(), DSI_PROTOCOL_VERSION_MINOR, 2));
+
+   CPPUNIT_ASSERT(large.recvAll(&hdr, sizeof(hdr)));
+   CPPUNIT_ASSERT(!(hdr.flags & DSI_MORE_DATA_FLAG));
+   CPPUNIT_ASSERT_EQUAL(0, (int)hdr.reserved[0]);
+}
@@ -0,0 +1,264 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <sys/socket.h>
+#include <vector>
+
+#include "dsi/DSI.hpp"
+
+#include "CSendQueue.hpp"
+#include "CLocalChannel.hpp"
+#include "CDispatcher.hpp"
+#include "TimerWheel.hpp"
+#include "Thread.hpp"
+#include "DSI.hpp"
+
+
+namespace /*anonymous*/
+{
+
+bool stopWhenDrained(DSI::Dispatcher* dispatcher, const DSI::CChannel* channel, DSI::io::error_code)
+{
+   if (channel->getSendQueueStatistics().queuedBytes > 0)
+      return true;
+
+   dispatcher->stop(0);
+   return false;
+}
+
+
+void receive(int fd, size_t* total)
+{
+   char buf[4096];
+
+   for (ssize_t rc; (rc = ::recv(fd, buf, sizeof(buf), 0)) > 0; *total += rc);
+}
+
+}   // namespace anonymous
+
+
+class CSendQueueTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CSendQueueTest);
+      CPPUNIT_TEST(testPushConsume);
+      CPPUNIT_TEST(testDrop);
+      CPPUNIT_TEST(testDisconnect);
+      CPPUNIT_TEST(testLargeMessage);
+      CPPUNIT_TEST(testSynchronous);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testPushConsume();
+   void testDrop();
+   void testDisconnect();
+   void testLargeMessage();
+   void testSynchronous();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CSendQueueTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void CSendQueueTest::testPushConsume()
+{
+   DSI::CSendQueue queue;
+
+   char a[] = "0123456789";
+   char b[] = "abcdefghij";
+   DSI::iov_t iov[2] = {
+      { a, 10 },
+      { b, 10 }
+   };
+
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Accept);
+   queue.push(iov, 2, 5);    // 5 bytes already written
+   CPPUNIT_ASSERT_EQUAL((size_t)15, queue.statistics().queuedBytes);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)1, queue.statistics().deferredMessages);
+
+   DSI::iov_t out[4];
+   CPPUNIT_ASSERT_EQUAL((size_t)1, queue.fill(out, 4));
+   CPPUNIT_ASSERT_EQUAL((size_t)15, out[0].iov_len);
+   CPPUNIT_ASSERT(!memcmp(out[0].iov_base, "56789abcdefghij", 15));
+
+   queue.consume(7);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, queue.fill(out, 4));
+   CPPUNIT_ASSERT(!memcmp(out[0].iov_base, "cdefghij", 8));
+
+   queue.consume(8);
+   CPPUNIT_ASSERT(queue.empty());
+   CPPUNIT_ASSERT_EQUAL((size_t)0, queue.statistics().queuedBytes);
+   CPPUNIT_ASSERT_EQUAL((size_t)15, queue.statistics().peakQueuedBytes);
+}
+
+
+void CSendQueueTest::testDrop()
+{
+   DSI::CSendQueue queue;
+
+   DSI::SendQueueConfig config = { 100, 50, DSI::SendQueueConfig::Drop };
+   queue.setConfig(config);
+
+   char payload[80] = { 0 };
+
+   DSI::MessageHeader first;
+   first.flags = DSI_MORE_DATA_FLAG;
+   DSI::MessageHeader last;
+   last.flags = 0;
+
+   DSI::iov_t iov[2] = {
+      { &first, sizeof(first) },
+      { payload, sizeof(payload) }
+   };
+
+   // first fragment exceeds the high watermark
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Accept);
+   queue.push(iov, 2, 0);
+
+   // the continuation of an accepted message is never dropped
+   iov[0].iov_base = &last;
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Accept);
+   queue.push(iov, 2, 0);
+
+   // the next message is dropped as a whole
+   iov[0].iov_base = &first;
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Drop);
+   iov[0].iov_base = &last;
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Drop);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)1, queue.statistics().droppedMessages);
+
+   // recovered once drained below the low watermark
+   queue.consume(queue.statistics().queuedBytes - 40);
+   CPPUNIT_ASSERT(queue.admit(iov, 2) == DSI::CSendQueue::Accept);
+}
+
+
+void CSendQueueTest::testDisconnect()
+{
+   DSI::CSendQueue queue;
+
+   DSI::SendQueueConfig config = { 100, 50, DSI::SendQueueConfig::Disconnect };
+   queue.setConfig(config);
+
+   char payload[60] = { 0 };
+   DSI::iov_t iov = { payload, sizeof(payload) };
+
+   CPPUNIT_ASSERT(queue.admit(&iov, 1) == DSI::CSendQueue::Accept);
+   queue.push(&iov, 1, 0);
+
+   // exceeding the high watermark is only evaluated for the next message
+   CPPUNIT_ASSERT(queue.admit(&iov, 1) == DSI::CSendQueue::Accept);
+   queue.push(&iov, 1, 0);
+
+   CPPUNIT_ASSERT(queue.admit(&iov, 1) == DSI::CSendQueue::Disconnect);
+}
+
+
+void CSendQueueTest::testLargeMessage()
+{
+   enum { Fragments = 32, FragmentSize = 64 * 1024 };
+
+   int fds[2];
+   CPPUNIT_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+   DSI::Dispatcher dispatcher;
+   DSI::Unix::StreamSocket sock(dispatcher);
+   sock.fd_ = fds[0];
+
+   DSI::CLocalChannel channel(sock);
+
+   DSI::SendQueueConfig config = { 100, 50, DSI::SendQueueConfig::Disconnect };
+   channel.setSendQueueConfig(config);
+
+   std::vector<char> payload(FragmentSize);
+
+   DSI::MessageHeader header;
+   ::memset(&header, 0, sizeof(header));
+
+   DSI::iov_t iov[2] = {
+      { &header, sizeof(header) },
+      { &payload[0], payload.size() }
+   };
+
+   // the peer does not read, still a message beyond the high watermark is not cut off
+   for (int i=0; i<Fragments; ++i)
+   {
+      header.flags = i < Fragments - 1 ? DSI_MORE_DATA_FLAG : 0;
+      CPPUNIT_ASSERT(channel.sendAll(iov, 2));
+   }
+
+   CPPUNIT_ASSERT_EQUAL((uint32_t)0, channel.getSendQueueStatistics().disconnects);
+   CPPUNIT_ASSERT(channel.getSendQueueStatistics().queuedBytes > 0);
+
+   size_t received = 0;
+
+   {
+      DSI::Thread reader(std::tr1::bind(&receive, fds[1], &received));
+
+      // the next message waits for the whole queue to be written
+      config.policy = DSI::SendQueueConfig::Block;
+      channel.setSendQueueConfig(config);
+
+      header.flags = 0;
+      CPPUNIT_ASSERT(channel.sendAll(iov, 2));
+      CPPUNIT_ASSERT(channel.getSendQueueStatistics().queuedBytes <= sizeof(header) + FragmentSize);
+
+      // the rest of the last one is written by the dispatcher
+      DSI::TimerWheel::Timer timer;
+      dispatcher.timers().start(timer, 1, std::tr1::bind(&stopWhenDrained, &dispatcher, &channel, std::tr1::placeholders::_1));
+      CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+      ::shutdown(fds[0], SHUT_WR);
+   }
+
+   CPPUNIT_ASSERT_EQUAL((size_t)(Fragments + 1) * (sizeof(header) + FragmentSize), received);
+   CPPUNIT_ASSERT_EQUAL((uint32_t)0, channel.getSendQueueStatistics().disconnects);
+
+   ::close(fds[1]);
+}
+
+
+void CSendQueueTest::testSynchronous()
+{
+   int fds[2];
+   CPPUNIT_ASSERT_EQUAL(0, ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+   // no dispatcher to drain a queue
+   DSI::Unix::StreamSocket sock;
+   sock.fd_ = fds[0];
+
+   DSI::CLocalChannel channel(sock);
+
+   char a[] = "0123456789";
+   DSI::iov_t iov[2] = {
+      { a, 5 },
+      { a + 5, 5 }
+   };
+
+   // neither queued nor corked
+   channel.cork();
+   CPPUNIT_ASSERT(channel.sendAll(iov, 2));
+
+   char buf[64];
+   CPPUNIT_ASSERT_EQUAL((ssize_t)10, ::recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT));
+   CPPUNIT_ASSERT(!memcmp(buf, a, 10));
+
+   // the caller's vector is left alone
+   CPPUNIT_ASSERT(iov[0].iov_base == a && iov[0].iov_len == 5);
+
+   channel.uncork();
+   CPPUNIT_ASSERT_EQUAL((uint64_t)10, channel.getTransportStatistics().bytesSent);
+
+   // a hard error is reported
+   ::close(fds[1]);
+   CPPUNIT_ASSERT(!channel.sendAll(a, 10));
+}
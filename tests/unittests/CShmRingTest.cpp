@@ -0,0 +1,171 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "CShmRing.hpp"
+
+
+class CShmRingTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(CShmRingTest);
+      CPPUNIT_TEST(testCreateOpen);
+      CPPUNIT_TEST(testWrapAround);
+      CPPUNIT_TEST(testSkip);
+      CPPUNIT_TEST(testCorruptControl);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testCreateOpen();
+   void testWrapAround();
+   void testSkip();
+   void testCorruptControl();
+
+private:
+   static bool write(DSI::CShmRing& ring, const std::string& data, uint32_t& position);
+   static std::string read(DSI::CShmRing& ring, uint32_t position, size_t len);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CShmRingTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+bool CShmRingTest::write(DSI::CShmRing& ring, const std::string& data, uint32_t& position)
+{
+   DSI::iov_t iov[2] = {
+      { const_cast<char*>(data.data()), data.size() / 2 },
+      { const_cast<char*>(data.data()) + data.size() / 2, data.size() - data.size() / 2 }
+   };
+
+   return ring.write(iov, 2, position);
+}
+
+
+std::string CShmRingTest::read(DSI::CShmRing& ring, uint32_t position, size_t len)
+{
+   std::string rc(len, '\0');
+   return ring.read(position, &rc[0], len) ? rc : std::string();
+}
+
+
+void CShmRingTest::testCreateOpen()
+{
+   DSI::CShmRing writer;
+   CPPUNIT_ASSERT(writer.create(5000));
+   CPPUNIT_ASSERT_EQUAL(8192u, writer.capacity());
+
+   DSI::CShmRing reader;
+   CPPUNIT_ASSERT(!reader.open(writer.name(), 4096));   // capacity mismatch
+   CPPUNIT_ASSERT(reader.open(writer.name(), writer.capacity()));
+
+   // the mapping survives the removal of the name
+   writer.unlink();
+
+   DSI::CShmRing other;
+   CPPUNIT_ASSERT(!other.open(writer.name(), writer.capacity()));
+
+   uint32_t position = 0;
+   CPPUNIT_ASSERT(write(writer, "Hello World", position));
+   CPPUNIT_ASSERT_EQUAL(std::string("Hello World"), read(reader, position, 11));
+
+   // already consumed
+   CPPUNIT_ASSERT(read(reader, position, 11).empty());
+}
+
+
+void CShmRingTest::testWrapAround()
+{
+   DSI::CShmRing writer;
+   CPPUNIT_ASSERT(writer.create(4096));
+
+   DSI::CShmRing reader;
+   CPPUNIT_ASSERT(reader.open(writer.name(), writer.capacity()));
+
+   std::string data;
+   for (size_t i=0; i<3000; ++i)
+      data += char('a' + i % 26);
+
+   for (int i=0; i<5; ++i)
+   {
+      uint32_t position = 0;
+      CPPUNIT_ASSERT(write(writer, data, position));
+
+      // the ring is full
+      uint32_t dummy;
+      CPPUNIT_ASSERT(!write(writer, data, dummy));
+
+      CPPUNIT_ASSERT(data == read(reader, position, data.size()));
+   }
+}
+
+
+void CShmRingTest::testSkip()
+{
+   DSI::CShmRing writer;
+   CPPUNIT_ASSERT(writer.create(4096));
+
+   DSI::CShmRing reader;
+   CPPUNIT_ASSERT(reader.open(writer.name(), writer.capacity()));
+
+   uint32_t orphan = 0;
+   uint32_t position = 0;
+   CPPUNIT_ASSERT(write(writer, "never announced", orphan));
+   CPPUNIT_ASSERT(write(writer, "payload", position));
+
+   // data beyond the head is not available
+   CPPUNIT_ASSERT(read(reader, position, 100).empty());
+
+   // the orphaned data is released together with the next payload
+   CPPUNIT_ASSERT_EQUAL(std::string("payload"), read(reader, position, 7));
+   CPPUNIT_ASSERT(read(reader, orphan, 15).empty());
+}
+
+
+void CShmRingTest::testCorruptControl()
+{
+   DSI::CShmRing writer;
+   CPPUNIT_ASSERT(writer.create(4096));
+
+   DSI::CShmRing reader;
+   CPPUNIT_ASSERT(reader.open(writer.name(), writer.capacity()));
+
+   uint32_t position = 0;
+   CPPUNIT_ASSERT(write(writer, "Hello", position));
+
+   // a misbehaving peer changes the control block: capacity at offset 4, head at 64, tail at 128
+   int fd = ::shm_open(writer.name(), O_RDWR, 0600);
+   CPPUNIT_ASSERT(fd >= 0);
+
+   void* addr = ::mmap(0, 4096, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+   (void)::close(fd);
+   CPPUNIT_ASSERT(addr != MAP_FAILED);
+
+   volatile uint32_t* capacity = (uint32_t*)((char*)addr + 4);
+   volatile uint32_t* head = (uint32_t*)((char*)addr + 64);
+
+   *capacity = 0x80000000u;
+   *head = position + 100000;
+
+   // the validated capacity is kept
+   CPPUNIT_ASSERT_EQUAL(4096u, writer.capacity());
+   CPPUNIT_ASSERT_EQUAL(4096u, reader.capacity());
+
+   CPPUNIT_ASSERT(read(reader, position, 100000).empty());
+   CPPUNIT_ASSERT(read(reader, position, 5).empty());
+   CPPUNIT_ASSERT(!write(writer, "World", position));
+
+   (void)::munmap(addr, 4096);
+}
@@ -15,17 +15,85 @@
 #include "CDummyChannel.hpp"
 
 
+struct SPoint
+{
+   int32_t x;
+   int32_t y;
+   int64_t z;
+};
+
+
+/// needs padding before c if the stream is not 8 byte aligned
+struct SSample
+{
+   int32_t a;
+   int32_t b;
+   double c;
+};
+
+
+bool operator==(const SPoint& lhs, const SPoint& rhs)
+{
+   return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+
+
+bool operator==(const SSample& lhs, const SSample& rhs)
+{
+   return lhs.a == rhs.a && lhs.b == rhs.b && lhs.c == rhs.c;
+}
+
+
+DSI::COStream& operator<<(DSI::COStream& os, const SPoint& p)
+{
+   return os << p.x << p.y << p.z;
+}
+
+
+DSI::CIStream& operator>>(DSI::CIStream& is, SPoint& p)
+{
+   return is >> p.x >> p.y >> p.z;
+}
+
+
+DSI::COStream& operator<<(DSI::COStream& os, const SSample& s)
+{
+   return os << s.a << s.b << s.c;
+}
+
+
+DSI::CIStream& operator>>(DSI::CIStream& is, SSample& s)
+{
+   return is >> s.a >> s.b >> s.c;
+}
+
+
+DSI_TRIVIALLY_STREAMABLE(SPoint, 16, 4, 8)
+DSI_TRIVIALLY_STREAMABLE(SSample, 16, 4, 8)
+
+
 class CVectorTest : public CppUnit::TestFixture
 {
 public:
    CPPUNIT_TEST_SUITE(CVectorTest);
       CPPUNIT_TEST(testEmpty);
       CPPUNIT_TEST(testFilled);      
+      CPPUNIT_TEST(testTrivial);
+      CPPUNIT_TEST(testTrivialStruct);
+      CPPUNIT_TEST(testTruncated);
    CPPUNIT_TEST_SUITE_END();
 
 public:
    void testEmpty();
    void testFilled();
+   void testTrivial();
+   void testTrivialStruct();
+   void testTruncated();
+
+private:
+   /// the bulk copy must produce the same stream as the per element serialization
+   template<typename T>
+   void checkWireFormat(const std::vector<T>& orig, bool pad);
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(CVectorTest);
@@ -68,3 +136,94 @@ void CVectorTest::testFilled()
    CPPUNIT_ASSERT(is.getError() == 0);   
    CPPUNIT_ASSERT(orig == copy);
 }
+
+
+template<typename T>
+void CVectorTest::checkWireFormat(const std::vector<T>& orig, bool pad)
+{
+   DSI::CRequestWriter writer;
+   DSI::COStream os(writer);
+   if (pad)
+      os << (int8_t)1;
+   os << orig;
+
+   DSI::CRequestWriter expectedWriter;
+   DSI::COStream expected(expectedWriter);
+   if (pad)
+      expected << (int8_t)1;
+   expected << (int32_t)orig.size();
+   for (size_t i=0; i<orig.size(); ++i)
+      expected << orig[i];
+
+   // padding bytes are undefined so just the layout is compared
+   CPPUNIT_ASSERT_EQUAL(expectedWriter.size(), writer.size());
+
+   int8_t byte = 0;
+   std::vector<T> copy;
+   DSI::CIStream is(expectedWriter.gptr(), expectedWriter.size());
+   if (pad)
+      is >> byte;
+   is >> copy;
+
+   CPPUNIT_ASSERT(is.getError() == 0);
+   CPPUNIT_ASSERT(orig == copy);
+}
+
+
+void CVectorTest::testTrivial()
+{
+   std::vector<int64_t> orig;
+   std::vector<uint8_t> bytes;
+   std::vector<double> doubles;
+
+   for (int i=0; i<100; ++i)
+   {
+      orig.push_back(-i * 0x100000001LL);
+      bytes.push_back(i);
+      doubles.push_back(i / 3.0);
+   }
+
+   checkWireFormat(orig, false);
+   checkWireFormat(orig, true);
+   checkWireFormat(bytes, true);
+   checkWireFormat(doubles, false);
+}
+
+
+void CVectorTest::testTrivialStruct()
+{
+   std::vector<SPoint> points;
+   std::vector<SSample> samples;
+
+   for (int i=0; i<10; ++i)
+   {
+      SPoint p = { i, -i, i * 0x100000000LL };
+      points.push_back(p);
+
+      SSample s = { i, i + 1, i / 7.0 };
+      samples.push_back(s);
+   }
+
+   checkWireFormat(points, false);
+   checkWireFormat(points, true);
+
+   // the samples are copied in bulk if they start at an 8 byte boundary, else one by one
+   checkWireFormat(samples, false);
+   checkWireFormat(samples, true);
+}
+
+
+void CVectorTest::testTruncated()
+{
+   std::vector<uint32_t> orig(10, 42);
+
+   DSI::CRequestWriter writer;
+   DSI::COStream os(writer);
+   os << orig;
+
+   std::vector<uint32_t> copy;
+   DSI::CIStream is(writer.gptr(), writer.size() - 1);
+   is >> copy;
+
+   CPPUNIT_ASSERT(is.getError() == ERANGE);
+}
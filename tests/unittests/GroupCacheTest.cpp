@@ -0,0 +1,118 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <grp.h>
+#include <unistd.h>
+#include <string>
+
+#include "GroupCache.hpp"
+#include "config.h"
+
+
+class GroupCacheTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(GroupCacheTest);
+      CPPUNIT_TEST(testCached);
+      CPPUNIT_TEST(testTimeout);
+      CPPUNIT_TEST(testUnknown);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void setUp();
+   void tearDown();
+
+   void testCached();
+   void testTimeout();
+   void testUnknown();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GroupCacheTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void GroupCacheTest::setUp()
+{
+   GroupCache::getInstance().clear();
+}
+
+
+void GroupCacheTest::tearDown()
+{
+   GroupCache::getInstance().setTimeout(SB_GROUPCACHE_TIMEOUT);
+   GroupCache::getInstance().clear();
+}
+
+
+void GroupCacheTest::testCached()
+{
+   GroupCache& cache = GroupCache::getInstance();
+   const unsigned int reads = cache.getReadCounter();
+
+   const ::group* gr = ::getgrgid(0);
+   CPPUNIT_ASSERT(gr != 0);
+   const std::string name(gr->gr_name);
+
+   CPPUNIT_ASSERT_EQUAL(name, std::string(cache.getGroupName(0)));
+   (void)cache.isMember(0, 0);
+   CPPUNIT_ASSERT_EQUAL(name, std::string(cache.getGroupName(0)));
+   CPPUNIT_ASSERT_EQUAL(reads + 1, cache.getReadCounter());
+
+   (void)cache.getUserName(0);
+   (void)cache.getUserName(0);
+   CPPUNIT_ASSERT_EQUAL(reads + 2, cache.getReadCounter());
+
+   // read again after a flush
+   cache.clear();
+   CPPUNIT_ASSERT_EQUAL(name, std::string(cache.getGroupName(0)));
+   (void)cache.getUserName(0);
+   CPPUNIT_ASSERT_EQUAL(reads + 4, cache.getReadCounter());
+}
+
+
+void GroupCacheTest::testTimeout()
+{
+   GroupCache& cache = GroupCache::getInstance();
+   cache.setTimeout(50);
+
+   const unsigned int reads = cache.getReadCounter();
+
+   (void)cache.getGroupName(0);
+   (void)cache.getUserName(0);
+   (void)cache.getGroupName(0);
+   (void)cache.getUserName(0);
+   CPPUNIT_ASSERT_EQUAL(reads + 2, cache.getReadCounter());
+
+   // expired entries are read again, and then cached again
+   ::usleep(100000);
+
+   (void)cache.getGroupName(0);
+   (void)cache.getUserName(0);
+   (void)cache.isMember(0, 0);
+   (void)cache.getUserName(0);
+   CPPUNIT_ASSERT_EQUAL(reads + 4, cache.getReadCounter());
+}
+
+
+void GroupCacheTest::testUnknown()
+{
+   GroupCache& cache = GroupCache::getInstance();
+   const gid_t gid = 0x7ffffff0;
+   CPPUNIT_ASSERT(::getgrgid(gid) == 0);
+
+   const unsigned int reads = cache.getReadCounter();
+
+   // missing entries are cached, too
+   CPPUNIT_ASSERT_EQUAL(std::string("<unknown>"), std::string(cache.getGroupName(gid)));
+   CPPUNIT_ASSERT(!cache.isMember(gid, 0));
+   CPPUNIT_ASSERT_EQUAL(reads + 1, cache.getReadCounter());
+}
@@ -0,0 +1,104 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <tr1/functional>
+#include <vector>
+
+#include "MpscQueue.hpp"
+#include "Thread.hpp"
+
+
+class MpscQueueTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(MpscQueueTest);
+      CPPUNIT_TEST(testFifo);
+      CPPUNIT_TEST(testProducers);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testFifo();
+   void testProducers();
+
+private:
+   enum { Producers = 4, Count = 10000 };
+
+   static void produce(DSI::MpscQueue<int>& queue, int producer);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MpscQueueTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void MpscQueueTest::produce(DSI::MpscQueue<int>& queue, int producer)
+{
+   for (int i=0; i<Count; ++i)
+      queue.push(producer * Count + i);
+}
+
+
+void MpscQueueTest::testFifo()
+{
+   DSI::MpscQueue<int> queue;
+   int value = 0;
+
+   CPPUNIT_ASSERT(queue.empty());
+   CPPUNIT_ASSERT(!queue.pop(value));
+
+   queue.push(1);
+   queue.push(2);
+   CPPUNIT_ASSERT(!queue.empty());
+
+   CPPUNIT_ASSERT(queue.pop(value));
+   CPPUNIT_ASSERT_EQUAL(1, value);
+
+   queue.push(3);
+
+   CPPUNIT_ASSERT(queue.pop(value));
+   CPPUNIT_ASSERT_EQUAL(2, value);
+   CPPUNIT_ASSERT(queue.pop(value));
+   CPPUNIT_ASSERT_EQUAL(3, value);
+
+   CPPUNIT_ASSERT(!queue.pop(value));
+
+   // remaining elements are released by the destructor
+   queue.push(4);
+}
+
+
+void MpscQueueTest::testProducers()
+{
+   DSI::MpscQueue<int> queue;
+   std::vector<int> next(Producers, 0);
+
+   std::vector<DSI::Thread*> threads;
+   for (int i=0; i<Producers; ++i)
+      threads.push_back(new DSI::Thread(std::tr1::bind(&MpscQueueTest::produce, std::tr1::ref(queue), i)));
+
+   int received = 0;
+   while(received < Producers * Count)
+   {
+      int value;
+      if (queue.pop(value))
+      {
+         // each producer's elements arrive in order
+         CPPUNIT_ASSERT_EQUAL(next[value / Count], value % Count);
+         ++next[value / Count];
+         ++received;
+      }
+   }
+
+   for (int i=0; i<Producers; ++i)
+      delete threads[i];
+
+   CPPUNIT_ASSERT(queue.empty());
+}
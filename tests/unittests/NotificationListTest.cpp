@@ -0,0 +1,211 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "NotificationList.hpp"
+
+
+namespace /*anonymous*/
+{
+
+SPartyID makeParty(uint32_t extendedID, uint32_t localID)
+{
+   SPartyID id;
+   id.s.extendedID = extendedID;
+   id.s.localID = localID;
+
+   return id;
+}
+
+
+InterfaceDescription makeInterface(const char* name, int32_t majorVersion, int32_t minorVersion)
+{
+   InterfaceDescription ifDescription;
+   ifDescription.name = name;
+   ifDescription.majorVersion = majorVersion;
+   ifDescription.minorVersion = minorVersion;
+
+   return ifDescription;
+}
+
+
+/**
+ * Notifications without a connection, triggering them just fails to send the pulse.
+ */
+notificationid_t add(NotificationList& list, const SPartyID& partyID, const InterfaceDescription& ifDescription, bool active = true)
+{
+   Notification entry;
+   entry.partyID = partyID;
+   entry.ifDescription = ifDescription;
+   entry.active = active;
+
+   const notificationid_t id = entry.notificationID;
+   list.add(entry);
+
+   return id;
+}
+
+
+notificationid_t add(NotificationList& list, const SPartyID& partyID, bool active = true)
+{
+   return add(list, partyID, InterfaceDescription(), active);
+}
+
+
+notificationid_t add(NotificationList& list, const InterfaceDescription& ifDescription)
+{
+   return add(list, SPartyID(), ifDescription);
+}
+
+}   // namespace anonymous
+
+
+class NotificationListTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(NotificationListTest);
+      CPPUNIT_TEST(testTriggerParty);
+      CPPUNIT_TEST(testTriggerInterface);
+      CPPUNIT_TEST(testTriggerId);
+      CPPUNIT_TEST(testSetType);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testTriggerParty();
+   void testTriggerInterface();
+   void testTriggerId();
+   void testSetType();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(NotificationListTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void NotificationListTest::testTriggerParty()
+{
+   NotificationList list;
+
+   const notificationid_t first = add(list, makeParty(1, 1));
+   const notificationid_t inactive = add(list, makeParty(1, 1), false);
+   const notificationid_t second = add(list, makeParty(1, 1));
+   const notificationid_t other = add(list, makeParty(1, 2));
+   const notificationid_t extended = add(list, makeParty(2, 1));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)5, list.size());
+
+   // all active ones of the party, none of its neighbours
+   list.trigger(makeParty(1, 1));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)3, list.size());
+   CPPUNIT_ASSERT(list.find(first) == 0);
+   CPPUNIT_ASSERT(list.find(second) == 0);
+   CPPUNIT_ASSERT(list.find(inactive) != 0);
+   CPPUNIT_ASSERT(list.find(other) != 0);
+   CPPUNIT_ASSERT(list.find(extended) != 0);
+
+   list.trigger(makeParty(1, 1));
+   CPPUNIT_ASSERT_EQUAL((size_t)3, list.size());
+
+   list.trigger(makeParty(2, 1));
+   CPPUNIT_ASSERT_EQUAL((size_t)2, list.size());
+   CPPUNIT_ASSERT(list.find(extended) == 0);
+}
+
+
+void NotificationListTest::testTriggerInterface()
+{
+   NotificationList list;
+
+   const notificationid_t old = add(list, makeInterface("foo", 1, 0));
+   const notificationid_t newer = add(list, makeInterface("foo", 1, 2));
+   const notificationid_t major = add(list, makeInterface("foo", 2, 0));
+   const notificationid_t prefix = add(list, makeInterface("foobar", 1, 0));
+   const notificationid_t other = add(list, makeInterface("bar", 1, 0));
+
+   // only the name and compatible versions
+   list.trigger(makeInterface("foo", 1, 1));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)4, list.size());
+   CPPUNIT_ASSERT(list.find(old) == 0);
+   CPPUNIT_ASSERT(list.find(newer) != 0);
+   CPPUNIT_ASSERT(list.find(major) != 0);
+   CPPUNIT_ASSERT(list.find(prefix) != 0);
+   CPPUNIT_ASSERT(list.find(other) != 0);
+
+   list.trigger(makeInterface("foo", 1, 2));
+   CPPUNIT_ASSERT(list.find(newer) == 0);
+
+   list.trigger(makeInterface("foobar", 1, 0));
+   CPPUNIT_ASSERT(list.find(prefix) == 0);
+
+   CPPUNIT_ASSERT_EQUAL((size_t)2, list.size());
+   CPPUNIT_ASSERT(list.find(major) != 0);
+   CPPUNIT_ASSERT(list.find(other) != 0);
+}
+
+
+void NotificationListTest::testTriggerId()
+{
+   NotificationList list;
+
+   const notificationid_t first = add(list, makeParty(1, 1));
+   const notificationid_t second = add(list, makeParty(1, 1));
+
+   Notification* entry = list.find(first);
+   CPPUNIT_ASSERT(entry != 0);
+   CPPUNIT_ASSERT_EQUAL(first, entry->notificationID);
+
+   // kept if requested
+   list.trigger(first, false);
+   CPPUNIT_ASSERT(list.find(first) == entry);
+
+   list.trigger(first);
+   CPPUNIT_ASSERT(list.find(first) == 0);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, list.size());
+
+   // unknown ids are ignored
+   list.trigger(first);
+   list.remove(first);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, list.size());
+
+   list.remove(second);
+   CPPUNIT_ASSERT(list.find(second) == 0);
+   CPPUNIT_ASSERT_EQUAL((size_t)0, list.size());
+
+   // a removed notification is not found by its party any more
+   list.trigger(makeParty(1, 1));
+   CPPUNIT_ASSERT_EQUAL((size_t)0, list.size());
+}
+
+
+void NotificationListTest::testSetType()
+{
+   NotificationList list;
+
+   const notificationid_t pooled = add(list, makeParty(1, 1));
+   const notificationid_t single = add(list, makeParty(1, 1));
+
+   list.find(pooled)->poolID = 7;
+
+   // the party index follows the new party id
+   CPPUNIT_ASSERT_EQUAL((size_t)1, list.setType(7, makeParty(1, 3)));
+   CPPUNIT_ASSERT_EQUAL((size_t)0, list.setType(8, makeParty(1, 4)));
+
+   (void)list.clearMasterNotification();
+
+   list.trigger(makeParty(1, 1));
+   CPPUNIT_ASSERT(list.find(single) == 0);
+   CPPUNIT_ASSERT(list.find(pooled) != 0);
+
+   list.trigger(makeParty(1, 3));
+   CPPUNIT_ASSERT(list.find(pooled) == 0);
+   CPPUNIT_ASSERT_EQUAL((size_t)0, list.size());
+}
@@ -0,0 +1,120 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+
+#include "RegExpCache.hpp"
+#include "config.h"
+
+
+namespace /*anonymous*/
+{
+
+RegExpCache::tRegExpPtr get(unsigned int idx)
+{
+   char pattern[32];
+   sprintf(pattern, "^if%u$", idx);
+
+   return RegExpCache::getInstance().get(pattern);
+}
+
+}   // namespace anonymous
+
+
+class RegExpCacheTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(RegExpCacheTest);
+      CPPUNIT_TEST(testShared);
+      CPPUNIT_TEST(testEviction);
+      CPPUNIT_TEST(testInvalid);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void setUp();
+   void tearDown();
+
+   void testShared();
+   void testEviction();
+   void testInvalid();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RegExpCacheTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void RegExpCacheTest::setUp()
+{
+   RegExpCache::getInstance().clear();
+}
+
+
+void RegExpCacheTest::tearDown()
+{
+   RegExpCache::getInstance().clear();
+}
+
+
+void RegExpCacheTest::testShared()
+{
+   RegExpCache::tRegExpPtr re = get(0);
+   CPPUNIT_ASSERT(re.get() != 0);
+   CPPUNIT_ASSERT_EQUAL(0, re->execute("if0", 0));
+   CPPUNIT_ASSERT(0 != re->execute("if1", 0));
+
+   // compiled once
+   CPPUNIT_ASSERT(get(0) == re);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, RegExpCache::getInstance().size());
+}
+
+
+void RegExpCacheTest::testEviction()
+{
+   RegExpCache::tRegExpPtr first = get(0);
+   RegExpCache::tRegExpPtr second = get(1);
+
+   for (unsigned int i=2; i<SB_REGEXPCACHE_SIZE; ++i)
+      (void)get(i);
+
+   CPPUNIT_ASSERT_EQUAL((size_t)SB_REGEXPCACHE_SIZE, RegExpCache::getInstance().size());
+
+   // the first one is used again, so the second one is the least recently used
+   CPPUNIT_ASSERT(get(0) == first);
+
+   RegExpCache::tRegExpPtr last = get(SB_REGEXPCACHE_SIZE);
+   CPPUNIT_ASSERT(last.get() != 0);
+   CPPUNIT_ASSERT_EQUAL((size_t)SB_REGEXPCACHE_SIZE, RegExpCache::getInstance().size());
+
+   CPPUNIT_ASSERT(get(0) == first);
+   CPPUNIT_ASSERT(get(SB_REGEXPCACHE_SIZE) == last);
+
+   // the evicted one is still usable by its holders, the cache compiles a new one
+   CPPUNIT_ASSERT_EQUAL(0, second->execute("if1", 0));
+
+   RegExpCache::tRegExpPtr again = get(1);
+   CPPUNIT_ASSERT(again.get() != 0);
+   CPPUNIT_ASSERT(again != second);
+   CPPUNIT_ASSERT_EQUAL(0, second->execute("if1", 0));
+   CPPUNIT_ASSERT_EQUAL((size_t)SB_REGEXPCACHE_SIZE, RegExpCache::getInstance().size());
+}
+
+
+void RegExpCacheTest::testInvalid()
+{
+   (void)get(0);
+
+   CPPUNIT_ASSERT(RegExpCache::getInstance().get("(").get() == 0);
+   CPPUNIT_ASSERT(RegExpCache::getInstance().get("(").get() == 0);
+
+   // not cached, the valid one is not evicted by it
+   CPPUNIT_ASSERT_EQUAL((size_t)1, RegExpCache::getInstance().size());
+}
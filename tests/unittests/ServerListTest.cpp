@@ -0,0 +1,149 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "ServerList.hpp"
+
+
+namespace /*anonymous*/
+{
+
+ServerListEntry makeEntry(const char* name, uint32_t extendedID, uint32_t localID)
+{
+   ServerListEntry entry;
+
+   entry.ifDescription.name = name;
+   entry.ifDescription.majorVersion = 1;
+   entry.partyID.s.extendedID = extendedID;
+   entry.partyID.s.localID = localID;
+   entry.masterID.s.localID = (uint32_t)-1;
+
+   return entry;
+}
+
+}   // namespace anonymous
+
+
+class ServerListTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(ServerListTest);
+      CPPUNIT_TEST(testStablePointers);
+      CPPUNIT_TEST(testOrder);
+      CPPUNIT_TEST(testDuplicateLocalIDs);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testStablePointers();
+   void testOrder();
+   void testDuplicateLocalIDs();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ServerListTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void ServerListTest::testStablePointers()
+{
+   ServerList list;
+   char name[32];
+
+   list.add(makeEntry("first", 1, 1));
+   ServerListEntry* first = list.find("first");
+   CPPUNIT_ASSERT(first != 0);
+
+   // growing the table must not move existing entries
+   for (uint32_t i=2; i<1000; ++i)
+   {
+      sprintf(name, "if%u", i);
+      list.add(makeEntry(name, 1, i));
+   }
+
+   CPPUNIT_ASSERT_EQUAL((size_t)999, list.size());
+   CPPUNIT_ASSERT(list.find("first") == first);
+   CPPUNIT_ASSERT_EQUAL(std::string("first"), first->ifDescription.name);
+
+   // neither does removing others or reusing their slots
+   SPartyID id;
+   id.s.extendedID = 1;
+
+   for (uint32_t i=2; i<500; ++i)
+   {
+      id.s.localID = i;
+      list.remove(id);
+   }
+
+   list.add(makeEntry("second", 1, 1000));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)502, list.size());
+   CPPUNIT_ASSERT(list.find("first") == first);
+   CPPUNIT_ASSERT(list.find("second") != 0);
+   CPPUNIT_ASSERT(list.find("if499") == 0);
+   CPPUNIT_ASSERT(list.find("if500") != 0);
+}
+
+
+void ServerListTest::testOrder()
+{
+   ServerList list;
+   list.add(makeEntry("b", 1, 1));
+   list.add(makeEntry("d", 1, 2));
+   list.add(makeEntry("a", 1, 3));
+   list.add(makeEntry("c", 1, 4));
+
+   std::string names;
+   for (ServerList::const_iterator iter = list.begin(); iter != list.end(); ++iter)
+      names += iter->ifDescription.name;
+
+   CPPUNIT_ASSERT_EQUAL(std::string("dcba"), names);
+
+   SPartyID id;
+   id.s.extendedID = 1;
+   id.s.localID = 4;
+   list.remove(id);
+
+   // the freed slot is reused, the order still follows the names
+   list.add(makeEntry("e", 1, 5));
+
+   names.clear();
+   for (ServerList::iterator iter = list.begin(); iter != list.end(); ++iter)
+      names += iter->ifDescription.name;
+
+   CPPUNIT_ASSERT_EQUAL(std::string("edba"), names);
+}
+
+
+void ServerListTest::testDuplicateLocalIDs()
+{
+   ServerList list;
+
+   // local IDs are only unique per extended ID
+   list.add(makeEntry("a", 1, 7));
+   list.add(makeEntry("c", 2, 7));
+   list.add(makeEntry("b", 3, 7));
+
+   // the first entry in iteration order wins, independent of the hashing
+   ServerListEntry* entry = list.findByLocalID(7);
+   CPPUNIT_ASSERT(entry != 0);
+   CPPUNIT_ASSERT_EQUAL(std::string("c"), entry->ifDescription.name);
+
+   list.find("c")->masterID.s.localID = 42;
+
+   entry = list.findByLocalIDandInvalidMasterID(7);
+   CPPUNIT_ASSERT(entry != 0);
+   CPPUNIT_ASSERT_EQUAL(std::string("b"), entry->ifDescription.name);
+
+   CPPUNIT_ASSERT(list.findByLocalID(8) == 0);
+}
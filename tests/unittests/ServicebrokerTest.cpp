@@ -0,0 +1,141 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <tr1/functional>
+
+#define QNX_REPLACE_RESMGR_CALLS
+#include "dsi/clientlib.h"
+
+#include "Servicebroker.hpp"
+#include "ServicebrokerServer.hpp"
+#include "Thread.hpp"
+#include "Trigger.hpp"
+
+
+namespace /*anonymous*/
+{
+
+int nullTranslator(int, int)
+{
+   return 0;
+}
+
+
+SFNDInterfaceDescription makeInterface(const char* name, int32_t majorVersion, int32_t minorVersion)
+{
+   SFNDInterfaceDescription ifDescription;
+   ::memset(&ifDescription, 0, sizeof(ifDescription));
+
+   strncpy(ifDescription.name, name, sizeof(ifDescription.name) - 1);
+   ifDescription.version.majorVersion = majorVersion;
+   ifDescription.version.minorVersion = minorVersion;
+
+   return ifDescription;
+}
+
+
+/**
+ * The client side, runs in its own thread while the servicebroker runs in the test's one.
+ */
+void registerInterfaces(const char* mountpoint, const SFNDInterfaceDescription* ifs, int count, SPartyID* ids,
+                        int* rc, DSI::Trigger* done)
+{
+   const int handle = SBOpen(mountpoint);
+   if (handle >= 0)
+   {
+      *rc = SBRegisterInterfaceEx(handle, ifs, count, 42, ids);
+      SBClose(handle);
+   }
+
+   (void)done->signal();
+}
+
+
+bool stopWhenDone(ServicebrokerServer* server, DSI::Trigger* done, unsigned int* rounds, DSI::io::error_code)
+{
+   // give up after five seconds
+   if (done->timed_wait(0) || ++*rounds == 500)
+   {
+      server->stop();
+      return false;
+   }
+
+   return true;
+}
+
+}   // namespace anonymous
+
+
+class ServicebrokerTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(ServicebrokerTest);
+      CPPUNIT_TEST(testRegisterInterfaceEx);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testRegisterInterfaceEx();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ServicebrokerTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void ServicebrokerTest::testRegisterInterfaceEx()
+{
+   char mountpoint[32];
+   sprintf(mountpoint, "unittest%d", (int)::getpid());
+
+   Servicebroker::getInstance().init(0, nullTranslator);
+
+   ServicebrokerServer server;
+   CPPUNIT_ASSERT(server.init(mountpoint, 0, 0, 0));
+
+   SFNDInterfaceDescription ifs[4];
+   ifs[0] = makeInterface("RegisterExTest.first", 1, 0);
+   ifs[1] = makeInterface("RegisterExTest.\x01", 1, 0);      // bad name
+   ifs[2] = makeInterface("RegisterExTest.first", 1, 0);     // already registered
+   ifs[3] = makeInterface("RegisterExTest.second", 2, 1);
+
+   SPartyID ids[4];
+   ::memset(ids, 0, sizeof(ids));
+
+   int rc = -1;
+   unsigned int rounds = 0;
+   DSI::Trigger done;
+
+   DSI::TimerWheel::Timer timer;
+   server.dispatcher().timers().start(timer, 10, std::tr1::bind(&stopWhenDone, &server, &done, &rounds,
+                                                                std::tr1::placeholders::_1));
+
+   {
+      DSI::Thread client(std::tr1::bind(&registerInterfaces, mountpoint, ifs, 4, ids, &rc, &done));
+      CPPUNIT_ASSERT_EQUAL(EXIT_SUCCESS, server.run());
+   }
+
+   char path[128];
+   sprintf(path, "%s%s", FND_SERVICEBROKER_ROOT, mountpoint);
+   (void)::unlink(path);
+
+   // the rejected interfaces do not fail the others
+   CPPUNIT_ASSERT(rounds < 500);
+   CPPUNIT_ASSERT_EQUAL((int)FNDOK, rc);
+
+   CPPUNIT_ASSERT(ids[0].globalID != 0 && ids[0].globalID != (uint64_t)-1);
+   CPPUNIT_ASSERT(ids[1].globalID == (uint64_t)-1);
+   CPPUNIT_ASSERT(ids[2].globalID == (uint64_t)-1);
+   CPPUNIT_ASSERT(ids[3].globalID != 0 && ids[3].globalID != (uint64_t)-1);
+   CPPUNIT_ASSERT(ids[0].globalID != ids[3].globalID);
+}
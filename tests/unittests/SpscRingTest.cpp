@@ -0,0 +1,123 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <tr1/functional>
+
+#include "SpscRing.hpp"
+#include "Thread.hpp"
+
+
+class SpscRingTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(SpscRingTest);
+      CPPUNIT_TEST(testFull);
+      CPPUNIT_TEST(testWrapAround);
+      CPPUNIT_TEST(testProducer);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testFull();
+   void testWrapAround();
+   void testProducer();
+
+private:
+   enum { Count = 100000 };
+
+   typedef DSI::SpscRing<int, 16> ring_type;
+
+   static void produce(ring_type& ring);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SpscRingTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void SpscRingTest::produce(ring_type& ring)
+{
+   for (int i=0; i<Count; )
+   {
+      if (ring.push(i))
+         ++i;
+   }
+}
+
+
+void SpscRingTest::testFull()
+{
+   DSI::SpscRing<int, 4> ring;
+   int value = 0;
+
+   CPPUNIT_ASSERT_EQUAL(4u, ring.capacity());
+   CPPUNIT_ASSERT(!ring.pop(value));
+
+   for (int i=0; i<4; ++i)
+      CPPUNIT_ASSERT(ring.push(i));
+
+   CPPUNIT_ASSERT(!ring.push(4));
+   CPPUNIT_ASSERT_EQUAL(4u, ring.size());
+
+   CPPUNIT_ASSERT(ring.pop(value));
+   CPPUNIT_ASSERT_EQUAL(0, value);
+
+   // one slot is free again
+   CPPUNIT_ASSERT(ring.push(4));
+   CPPUNIT_ASSERT(!ring.push(5));
+
+   for (int i=1; i<5; ++i)
+   {
+      CPPUNIT_ASSERT(ring.pop(value));
+      CPPUNIT_ASSERT_EQUAL(i, value);
+   }
+
+   CPPUNIT_ASSERT(!ring.pop(value));
+   CPPUNIT_ASSERT_EQUAL(0u, ring.size());
+}
+
+
+void SpscRingTest::testWrapAround()
+{
+   DSI::SpscRing<int, 4> ring;
+   int value = 0;
+
+   for (int i=0; i<100; ++i)
+   {
+      CPPUNIT_ASSERT(ring.push(i));
+      CPPUNIT_ASSERT(ring.push(-i));
+
+      CPPUNIT_ASSERT(ring.pop(value));
+      CPPUNIT_ASSERT_EQUAL(i, value);
+      CPPUNIT_ASSERT(ring.pop(value));
+      CPPUNIT_ASSERT_EQUAL(-i, value);
+   }
+}
+
+
+void SpscRingTest::testProducer()
+{
+   ring_type ring;
+
+   DSI::Thread thread(std::tr1::bind(&SpscRingTest::produce, std::tr1::ref(ring)));
+
+   for (int expected=0; expected<Count; )
+   {
+      int value;
+      if (ring.pop(value))
+      {
+         CPPUNIT_ASSERT_EQUAL(expected, value);
+         ++expected;
+      }
+   }
+
+   thread.join();
+   CPPUNIT_ASSERT_EQUAL(0u, ring.size());
+}
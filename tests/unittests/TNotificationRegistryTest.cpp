@@ -0,0 +1,171 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "dsi/private/TNotificationRegistry.hpp"
+
+
+namespace /*anonymous*/
+{
+
+struct TestNotification
+{
+   uint32_t notifyID;
+   uint64_t clientID;
+   int32_t sessionId;
+};
+
+typedef DSI::Private::TNotificationRegistry<TestNotification> tRegistry;
+
+
+TestNotification makeNotification(uint32_t notifyID, uint64_t clientID, int32_t sessionId = DSI::INVALID_SESSION_ID)
+{
+   TestNotification n = { notifyID, clientID, sessionId };
+   return n;
+}
+
+}   // namespace
+
+
+class TNotificationRegistryTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(TNotificationRegistryTest);
+      CPPUNIT_TEST(testCollect);
+      CPPUNIT_TEST(testErase);
+      CPPUNIT_TEST(testSession);
+      CPPUNIT_TEST(testVectorInterface);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testCollect();
+   void testErase();
+   void testSession();
+   void testVectorInterface();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TNotificationRegistryTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void TNotificationRegistryTest::testCollect()
+{
+   tRegistry registry;
+
+   tRegistry::handle_type h1 = registry.add(makeNotification(1, 100));
+   tRegistry::handle_type h2 = registry.add(makeNotification(2, 100));
+   tRegistry::handle_type h3 = registry.add(makeNotification(1, 200));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)3, registry.size());
+   CPPUNIT_ASSERT(registry.contains(1));
+   CPPUNIT_ASSERT(!registry.contains(3));
+
+   // insertion order is kept
+   tRegistry::handlelist_type handles;
+   registry.collect(1, handles);
+   CPPUNIT_ASSERT_EQUAL((size_t)2, handles.size());
+   CPPUNIT_ASSERT_EQUAL(h1, handles[0]);
+   CPPUNIT_ASSERT_EQUAL(h3, handles[1]);
+
+   handles.clear();
+   registry.collectClient(100, DSI::INVALID_ID, handles);
+   CPPUNIT_ASSERT_EQUAL((size_t)2, handles.size());
+   CPPUNIT_ASSERT_EQUAL(h1, handles[0]);
+   CPPUNIT_ASSERT_EQUAL(h2, handles[1]);
+
+   handles.clear();
+   registry.collectClient(100, 2, handles);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, handles.size());
+   CPPUNIT_ASSERT_EQUAL(h2, handles[0]);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)100, registry.find(h2)->clientID);
+}
+
+
+void TNotificationRegistryTest::testErase()
+{
+   tRegistry registry;
+
+   tRegistry::handle_type h1 = registry.add(makeNotification(1, 100));
+   tRegistry::handle_type h2 = registry.add(makeNotification(1, 200));
+
+   registry.erase(h1);
+   CPPUNIT_ASSERT(registry.find(h1) == 0);
+   CPPUNIT_ASSERT(registry.find(h2) != 0);
+
+   // erasing twice is harmless
+   registry.erase(h1);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, registry.size());
+
+   tRegistry::handlelist_type handles;
+   registry.collectClient(100, DSI::INVALID_ID, handles);
+   CPPUNIT_ASSERT(handles.empty());
+
+   registry.erase(h2);
+   CPPUNIT_ASSERT(registry.empty());
+   CPPUNIT_ASSERT(!registry.contains(1));
+}
+
+
+void TNotificationRegistryTest::testSession()
+{
+   tRegistry registry;
+
+   (void)registry.add(makeNotification(1, 100, 42));
+   (void)registry.add(makeNotification(2, 100, 42));
+   (void)registry.add(makeNotification(1, 100));
+
+   tRegistry::handlelist_type handles;
+   registry.collectSession(42, handles);
+   CPPUNIT_ASSERT_EQUAL((size_t)2, handles.size());
+
+   for (tRegistry::handlelist_type::const_iterator iter = handles.begin(); iter != handles.end(); ++iter)
+      registry.erase(*iter);
+
+   CPPUNIT_ASSERT_EQUAL((size_t)1, registry.size());
+   CPPUNIT_ASSERT(registry.contains(1));
+   CPPUNIT_ASSERT(!registry.contains(2));
+}
+
+
+void TNotificationRegistryTest::testVectorInterface()
+{
+   tRegistry registry;
+
+   for (uint32_t i=0; i<10; ++i)
+      (void)registry.add(makeNotification(i % 2, 100 + i));
+
+   CPPUNIT_ASSERT_EQUAL((uint64_t)100, registry[0].clientID);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)109, registry[9].clientID);
+   CPPUNIT_ASSERT_EQUAL((uint64_t)104, registry[4].clientID);
+
+   // the loop of stubs generated by former code generators
+   for (int32_t idx=registry.size()-1; idx>=0; idx--)
+   {
+      if (registry[idx].notifyID == 1)
+         registry.erase(registry.begin() + idx);
+   }
+
+   CPPUNIT_ASSERT_EQUAL((size_t)5, registry.size());
+   CPPUNIT_ASSERT(!registry.contains(1));
+
+   for (size_t idx=0; idx<registry.size(); ++idx)
+      CPPUNIT_ASSERT_EQUAL((uint64_t)(100 + 2 * idx), registry[idx].clientID);
+
+   // the indexes are still up to date
+   tRegistry::handlelist_type handles;
+   registry.collectClient(104, DSI::INVALID_ID, handles);
+   CPPUNIT_ASSERT_EQUAL((size_t)1, handles.size());
+   CPPUNIT_ASSERT_EQUAL((uint64_t)104, registry.find(handles[0])->clientID);
+
+   registry.erase(registry.begin());
+   CPPUNIT_ASSERT_EQUAL((uint64_t)102, registry[0].clientID);
+   CPPUNIT_ASSERT_EQUAL((size_t)4, registry.size());
+}
@@ -0,0 +1,282 @@
+/*****************************************************************
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this file,
+* You can obtain one at http://mozilla.org/MPL/2.0/.
+* Copyright (c) 2012 Harman International Industries, Inc.
+* All rights reserved
+****************************************************************/
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <time.h>
+#include <sys/timerfd.h>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <tr1/functional>
+
+#include "CDispatcher.hpp"
+#include "TimerWheel.hpp"
+
+
+namespace /*anonymous*/
+{
+
+uint64_t now_ms()
+{
+   struct timespec ts;
+   ::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/// stops the dispatcher if the timers do not, independent of the wheel
+struct Watchdog
+{
+   explicit
+   Watchdog(DSI::Dispatcher& dispatcher)
+    : dispatcher_(dispatcher)
+    , fd_(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK|TFD_CLOEXEC))
+   {
+      struct itimerspec spec;
+      ::memset(&spec, 0, sizeof(spec));
+      spec.it_value.tv_sec = 5;
+
+      (void)::timerfd_settime(fd_, 0, &spec, 0);
+      dispatcher_.enqueueEvent(fd_, new DSI::GenericEvent<Watchdog&>(*this), POLLIN);
+   }
+
+   ~Watchdog()
+   {
+      dispatcher_.removeAll(fd_);
+      (void)::close(fd_);
+   }
+
+   bool operator()(DSI::GenericEventBase::Result)
+   {
+      dispatcher_.stop(-1);
+      return false;
+   }
+
+   DSI::Dispatcher& dispatcher_;
+   int fd_;
+};
+
+
+struct Recorder
+{
+   Recorder(DSI::Dispatcher& dispatcher, unsigned int expected)
+    : dispatcher_(dispatcher)
+    , expected_(expected)
+    , early_(0)
+   {
+      // NOOP
+   }
+
+   bool expired(unsigned int id, uint64_t due, int rearms)
+   {
+      if (now_ms() < due)
+         ++early_;
+
+      fired_.push_back(id);
+
+      if (fired_.size() == expected_)
+         dispatcher_.stop(0);
+
+      return (int)std::count(fired_.begin(), fired_.end(), id) <= rearms;
+   }
+
+   DSI::Dispatcher& dispatcher_;
+   unsigned int expected_;
+   unsigned int early_;
+   std::vector<unsigned int> fired_;
+};
+
+}   // namespace anonymous
+
+
+class TimerWheelTest : public CppUnit::TestFixture
+{
+public:
+   CPPUNIT_TEST_SUITE(TimerWheelTest);
+      CPPUNIT_TEST(testOrder);
+      CPPUNIT_TEST(testCancel);
+      CPPUNIT_TEST(testRestart);
+      CPPUNIT_TEST(testMany);
+      CPPUNIT_TEST(testOutlive);
+      CPPUNIT_TEST(testSparse);
+   CPPUNIT_TEST_SUITE_END();
+
+public:
+   void testOrder();
+   void testCancel();
+   void testRestart();
+   void testMany();
+   void testOutlive();
+   void testSparse();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TimerWheelTest);
+
+
+// --------------------------------------------------------------------------------
+
+
+void TimerWheelTest::testOrder()
+{
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   DSI::TimerWheel wheel(dispatcher, 1);
+   Recorder recorder(dispatcher, 3);
+
+   DSI::TimerWheel::Timer timers[3];
+   const unsigned int timeouts[3] = { 30, 10, 100 };   // the last one starts in the second level
+
+   for (unsigned int i=0; i<3; ++i)
+      wheel.start(timers[i], timeouts[i], std::tr1::bind(&Recorder::expired, &recorder, i, now_ms() + timeouts[i], 0));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)3, wheel.size());
+   CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+   CPPUNIT_ASSERT_EQUAL(3u, (unsigned int)recorder.fired_.size());
+   CPPUNIT_ASSERT_EQUAL(1u, recorder.fired_[0]);
+   CPPUNIT_ASSERT_EQUAL(0u, recorder.fired_[1]);
+   CPPUNIT_ASSERT_EQUAL(2u, recorder.fired_[2]);
+   CPPUNIT_ASSERT_EQUAL(0u, recorder.early_);
+
+   CPPUNIT_ASSERT_EQUAL((size_t)0, wheel.size());
+   CPPUNIT_ASSERT(!timers[0].isActive());
+}
+
+
+void TimerWheelTest::testCancel()
+{
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   DSI::TimerWheel wheel(dispatcher, 1);
+   Recorder recorder(dispatcher, 1);
+
+   DSI::TimerWheel::Timer cancelled;
+   DSI::TimerWheel::Timer kept;
+
+   wheel.start(cancelled, 5, std::tr1::bind(&Recorder::expired, &recorder, 0, 0, 0));
+   wheel.start(kept, 20, std::tr1::bind(&Recorder::expired, &recorder, 1, 0, 0));
+
+   {
+      // destruction cancels, too
+      DSI::TimerWheel::Timer destroyed;
+      wheel.start(destroyed, 1, std::tr1::bind(&Recorder::expired, &recorder, 2, 0, 0));
+   }
+
+   wheel.cancel(cancelled);
+   CPPUNIT_ASSERT(!cancelled.isActive());
+   CPPUNIT_ASSERT_EQUAL((size_t)1, wheel.size());
+
+   CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+   CPPUNIT_ASSERT_EQUAL(1u, (unsigned int)recorder.fired_.size());
+   CPPUNIT_ASSERT_EQUAL(1u, recorder.fired_[0]);
+}
+
+
+void TimerWheelTest::testRestart()
+{
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   Recorder recorder(dispatcher, 4);
+
+   // the dispatcher's own wheel
+   DSI::TimerWheel::Timer timer;
+   dispatcher.timers().start(timer, 5, std::tr1::bind(&Recorder::expired, &recorder, 0, 0, 3));
+
+   CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+   CPPUNIT_ASSERT_EQUAL(4u, (unsigned int)recorder.fired_.size());
+
+   // the fourth expiry did not rearm
+   CPPUNIT_ASSERT(!timer.isActive());
+}
+
+
+void TimerWheelTest::testMany()
+{
+   enum { Count = 10000 };
+
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   DSI::TimerWheel wheel(dispatcher, 1);
+   Recorder recorder(dispatcher, Count);
+
+   std::vector<DSI::TimerWheel::Timer*> timers;
+   ::srand(42);
+
+   for (unsigned int i=0; i<Count; ++i)
+   {
+      const unsigned int timeout = ::rand() % 300;
+
+      timers.push_back(new DSI::TimerWheel::Timer);
+      wheel.start(*timers.back(), timeout, std::tr1::bind(&Recorder::expired, &recorder, i, now_ms() + timeout, 0));
+   }
+
+   CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+   CPPUNIT_ASSERT_EQUAL((unsigned int)Count, (unsigned int)recorder.fired_.size());
+   CPPUNIT_ASSERT_EQUAL(0u, recorder.early_);
+
+   for (unsigned int i=0; i<Count; ++i)
+      delete timers[i];
+}
+
+
+void TimerWheelTest::testOutlive()
+{
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   Recorder recorder(dispatcher, 1);
+
+   DSI::TimerWheel::Timer fired;
+   DSI::TimerWheel::Timer cancelled;
+
+   {
+      DSI::TimerWheel wheel(dispatcher, 1);
+
+      wheel.start(fired, 1, std::tr1::bind(&Recorder::expired, &recorder, 0, 0, 0));
+      wheel.start(cancelled, 10, std::tr1::bind(&Recorder::expired, &recorder, 1, 0, 0));
+      wheel.cancel(cancelled);
+
+      CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+      CPPUNIT_ASSERT_EQUAL(1u, (unsigned int)recorder.fired_.size());
+   }
+
+   // neither timer refers to the destroyed wheel, so both may be reused and destroyed
+   DSI::TimerWheel other(dispatcher, 1);
+   other.start(fired, 1, std::tr1::bind(&Recorder::expired, &recorder, 2, 0, 0));
+   other.start(cancelled, 1, std::tr1::bind(&Recorder::expired, &recorder, 3, 0, 0));
+
+   CPPUNIT_ASSERT_EQUAL((size_t)2, other.size());
+}
+
+
+void TimerWheelTest::testSparse()
+{
+   DSI::Dispatcher dispatcher;
+   Watchdog watchdog(dispatcher);
+
+   DSI::TimerWheel wheel(dispatcher, 1);
+   Recorder recorder(dispatcher, 1);
+
+   // a second level timer wakes up the loop for its cascade and its expiry only, not on every first level round
+   DSI::TimerWheel::Timer timer;
+   wheel.start(timer, 400, std::tr1::bind(&Recorder::expired, &recorder, 0, now_ms() + 400, 0));
+
+   CPPUNIT_ASSERT_EQUAL(0, dispatcher.run());
+
+   CPPUNIT_ASSERT_EQUAL(1u, (unsigned int)recorder.fired_.size());
+   CPPUNIT_ASSERT_EQUAL(0u, recorder.early_);
+   CPPUNIT_ASSERT(dispatcher.statistics().rounds <= 3);
+}